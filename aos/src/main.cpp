@@ -1,70 +1,131 @@
+#include <atomic>
+#include <cstdint>
 #include <iostream>
-#include <random>
+#include <optional>
 #include <vector>
 #include <iomanip>
 
+#include "baked_scene.hpp"
+#include "bvh.hpp"
 #include "camera.hpp"
+#include "command_line.hpp"
+#include "compiled_scene.hpp"
 #include "config.hpp"
+#include "image_output.hpp"
+#include "kernel_dispatch.hpp"
+#include "random.hpp"
 #include "renderer.hpp"
 #include "renderer_utils.hpp"
 #include "scene.hpp"
+#include "tile_renderer.hpp"
 #include "vector.hpp"
 
 int main(int argc, char* argv[]) {
-  if (argc != 4) {
-    std::cerr << "Usage: " << argv[0] << " <config_file> <scene_file> <output_file>\n";
+  render::command_line args;
+  try {
+    args = render::command_line_parser::parse(argc, argv);
+  } catch (const std::exception& e) {
+    std::cerr << e.what() << "\n" << render::command_line_parser::usage(argv[0]);
     return 1;
   }
 
-  const std::string config_file = argv[1];
-  const std::string scene_file = argv[2];
-  const std::string output_file = argv[3];
-
   try {
-    const auto config = render::config_parser::parse(config_file);
-    const auto scene = render::scene_parser::parse(scene_file);
+    auto config = render::config_parser::parse(args.config_file);
+    args.apply_overrides(config);
+    render::select_kernel_isa(args.isa);
+    std::cout << "Kernels: " << render::isa_name(render::active_kernel_isa()) << (args.isa ? " (--isa)" : " (detected)") << "\n";
+
+    // The AOS records are built from a compiled scene's columns instead of
+    // from text. Its primitive order is kept, so its BVH stays valid.
+    std::optional<render::compiled_scene> compiled;
+    if (render::is_compiled_scene(args.scene_file)) {
+      compiled = render::compiled_scene::open(args.scene_file);
+      std::cout << "Mapped compiled scene: " << compiled->get_num_spheres() << " spheres, " << compiled->get_num_cylinders() << " cylinders\n";
+      if (config.ordering != compiled->get_ordering()) {
+        std::cout << "The compiled scene keeps the primitive order it was compiled with.\n";
+      }
+    }
+    auto parsed = compiled ? compiled->to_scene() : render::scene_parser::parse(args.scene_file, config.threads);
+    if (!compiled) {
+      render::reorder_scene(parsed, config.ordering);
+    }
 
     const render::camera cam{config};
-    const render::renderer renderer{config, scene};
-
     const int width = cam.get_image_width();
     const int height = cam.get_image_height();
 
-    std::mt19937 ray_rng(config.ray_rng_seed);
-    std::mt19937 material_rng(config.material_rng_seed);
-    std::uniform_real_distribution<double> dist(0.0, 1.0);
-
-    std::vector<std::vector<render::vector>> image(static_cast<size_t>(width));
-    for (int i = 0; i < width; ++i) {
-      image[i].resize(static_cast<size_t>(height));
+    render::image_output output{config, args.output_file, width, height};
+    std::optional<render::sample_count_image> sample_counts;
+    if (args.sample_counts_file) {
+      sample_counts.emplace(width, height, config.samples_per_pixel);
     }
+    std::atomic<std::uint64_t> total_samples{0};
+    const render::sample_pattern pattern = render::sample_pattern_for(config);
 
-    std::cout << "Rendering " << width << "x" << height << " image with " << config.samples_per_pixel << " samples per pixel...\n";
-
-    for (int j = 0; j < height; ++j) {
-      for (int i = 0; i < width; ++i) {
-        render::vector color{0.0, 0.0, 0.0};
+    if (config.engine == render::render_engine::wavefront) {
+      std::cout << "The wavefront engine is only available in the SOA renderer; using the recursive one.\n";
+    }
+    if (config.layout && *config.layout != render::memory_layout::aos) {
+      std::cout << "Other memory layouts are only available in the SOA renderer; using AOS.\n";
+    }
 
-        for (int s = 0; s < config.samples_per_pixel; ++s) {
-          const double u = (static_cast<double>(i) + dist(ray_rng)) / static_cast<double>(width);
-          const double v = (static_cast<double>(j) + dist(ray_rng)) / static_cast<double>(height);
-          const render::ray r = cam.get_ray(u, v);
-          color = color + renderer.trace_ray(r, 0, ray_rng, material_rng);
+    // Tracers of either precision return double colors, so the pixel loop is shared.
+    const auto render_image = [&](const auto& renderer) {
+      std::cout << "Rendering " << width << "x" << height << " image with " << config.samples_per_pixel << " samples per pixel...\n";
+
+      render::render_tiles(config, width, height, [&](const render::tile& t) {
+        render::framebuffer pixels{t.x_end - t.x_begin, t.y_end - t.y_begin};
+        std::uint64_t tile_samples = 0;
+        for (int j = t.y_begin; j < t.y_end; ++j) {
+          for (int i = t.x_begin; i < t.x_end; ++i) {
+            const auto pixel = static_cast<std::uint64_t>(j) * static_cast<std::uint64_t>(width) + static_cast<std::uint64_t>(i);
+            render::pixel_estimate estimate;
+
+            // Every sample draws from streams addressed by pixel and sample index, so
+            // the image does not depend on tile order or thread count.
+            while (estimate.needs_sample(config)) {
+              const auto s = static_cast<std::uint32_t>(estimate.count);
+              render::random_stream ray_rng{config.ray_rng_seed, pixel, s, render::random_domain::camera, pattern};
+              render::random_stream material_rng{config.material_rng_seed, pixel, s, render::random_domain::material, pattern};
+              const double u = (static_cast<double>(i) + ray_rng.uniform()) / static_cast<double>(width);
+              const double v = (static_cast<double>(j) + ray_rng.uniform()) / static_cast<double>(height);
+              const render::ray r = cam.get_ray(u, v);
+              estimate.add(renderer.trace_ray(r, 0, material_rng));
+            }
+
+            pixels.set_pixel(i - t.x_begin, j - t.y_begin, estimate.mean());
+            if (sample_counts) {
+              sample_counts->set_count(i, j, estimate.count);
+            }
+            tile_samples += static_cast<std::uint64_t>(estimate.count);
+          }
         }
-
-        color = color / static_cast<double>(config.samples_per_pixel);
-        color = render::gamma_correct(color, config.gamma);
-        color = render::clamp_color(color);
-        image[i][j] = color;
-      }
-
-      if ((j + 1) % 50 == 0) {
-        std::cout << "Progress: " << (j + 1) << "/" << height << " lines\n";
-      }
+        total_samples += tile_samples;
+        output.store_tile(t, pixels);
+      });
+    };
+
+    if (config.precision == render::render_precision::single_precision) {
+      const auto baked = render::bake_scene<float>(parsed);
+      const auto accel = render::build_acceleration(config, baked.get_primitive_bounds());
+      render_image(render::basic_renderer<float>{config, baked, accel});
+    } else {
+      const auto baked = render::bake_scene(parsed);
+      const auto accel = compiled ? compiled->load_acceleration(config) : render::build_acceleration(config, baked.get_primitive_bounds());
+      render_image(render::renderer{config, baked, accel});
     }
 
-    render::write_ppm(output_file, image, width, height);
-    std::cout << "Rendering complete. Output written to " << output_file << "\n";
+    output.finish();
+    if (config.adaptive_threshold > 0.0) {
+      std::cout << "Adaptive sampling: " << std::fixed << std::setprecision(1)
+                << static_cast<double>(total_samples) / (static_cast<double>(width) * static_cast<double>(height))
+                << " samples per pixel on average\n";
+    }
+    if (sample_counts) {
+      sample_counts->write(*args.sample_counts_file);
+      std::cout << "Sample counts written to " << *args.sample_counts_file << "\n";
+    }
+    std::cout << "Rendering complete. Output written to " << args.output_file << "\n";
 
   } catch (const std::exception& e) {
     std::cerr << "Error: " << e.what() << "\n";
@@ -0,0 +1,129 @@
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <optional>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "aligned_allocator.hpp"
+#include "cylinder.hpp"
+#include "ray.hpp"
+#include "intersection_kernels.hpp"
+
+namespace {
+
+  constexpr std::size_t tests_per_run = 1U << 26;
+
+  // Keeps the optimizer from discarding the results.
+  volatile double sink = 0.0;
+
+  // One aligned column per kernel input array.
+  struct column_set {
+    std::vector<render::aligned_vector<double>> columns;
+
+    [[nodiscard]] std::size_t size() const { return columns[0].size(); }
+    [[nodiscard]] const double* operator[](std::size_t column) const { return columns[column].data(); }
+  };
+
+  column_set make_spheres(std::size_t count, std::mt19937& rng) {
+    std::uniform_real_distribution<double> coord(-50.0, 50.0);
+    std::uniform_real_distribution<double> size(0.2, 2.0);
+    column_set set{std::vector<render::aligned_vector<double>>(4)};
+    for (std::size_t i = 0; i < count; ++i) {
+      set.columns[0].push_back(coord(rng));
+      set.columns[1].push_back(coord(rng));
+      set.columns[2].push_back(coord(rng));
+      set.columns[3].push_back(size(rng));
+    }
+    return set;
+  }
+
+  column_set make_cylinders(std::size_t count, std::mt19937& rng) {
+    std::uniform_real_distribution<double> coord(-50.0, 50.0);
+    std::uniform_real_distribution<double> size(0.2, 2.0);
+    column_set set{std::vector<render::aligned_vector<double>>(14)};
+    for (std::size_t i = 0; i < count; ++i) {
+      const auto f = render::cylinder_frame::make(render::vector{coord(rng), coord(rng), coord(rng)}, size(rng),
+                                                  render::vector{coord(rng), coord(rng), coord(rng)} * 0.05);
+      const double values[] = {
+        f.center.get_x(), f.center.get_y(), f.center.get_z(),
+        f.unit_axis.get_x(), f.unit_axis.get_y(), f.unit_axis.get_z(),
+        f.top_center.get_x(), f.top_center.get_y(), f.top_center.get_z(),
+        f.bottom_center.get_x(), f.bottom_center.get_y(), f.bottom_center.get_z(),
+        f.half_height, f.radius_squared
+      };
+      for (std::size_t c = 0; c < set.columns.size(); ++c) {
+        set.columns[c].push_back(values[c]);
+      }
+    }
+    return set;
+  }
+
+  render::sphere_lanes sphere_view(const column_set& set) {
+    return render::sphere_lanes{set[0], set[1], set[2], set[3], set.size()};
+  }
+
+  render::cylinder_lanes cylinder_view(const column_set& set) {
+    return render::cylinder_lanes{set[0], set[1], set[2], set[3], set[4], set[5], set[6],
+                                  set[7], set[8], set[9], set[10], set[11], set[12], set[13], set.size()};
+  }
+
+  std::vector<render::ray> make_rays(std::size_t count, std::mt19937& rng) {
+    std::uniform_real_distribution<double> coord(-50.0, 50.0);
+    std::vector<render::ray> rays;
+    for (std::size_t i = 0; i < count; ++i) {
+      rays.emplace_back(render::vector{coord(rng), coord(rng), coord(rng)},
+                        render::vector{coord(rng), coord(rng), coord(rng)}.normalize());
+    }
+    return rays;
+  }
+
+  template <typename Lanes, typename Kernel>
+  double measure(const Lanes& primitives, const std::vector<render::ray>& rays, Kernel&& kernel) {
+    const std::size_t passes = tests_per_run / (primitives.count * rays.size()) + 1;
+    const auto start = std::chrono::steady_clock::now();
+    double checksum = 0.0;
+    for (std::size_t pass = 0; pass < passes; ++pass) {
+      for (const auto& r : rays) {
+        const auto hit = kernel(primitives, r, 0.0001, std::numeric_limits<double>::max());
+        checksum += hit ? hit->t : 0.0;
+      }
+    }
+    const auto stop = std::chrono::steady_clock::now();
+    sink = sink + checksum;
+
+    const double tests = static_cast<double>(passes * rays.size() * primitives.count);
+    return std::chrono::duration<double, std::nano>(stop - start).count() / tests;
+  }
+
+  void print_row(const std::string& name, std::size_t count, double scalar, double simd) {
+    std::cout << std::left << std::setw(12) << name << std::setw(10) << count << std::right << std::fixed << std::setprecision(3)
+              << std::setw(16) << scalar << std::setw(16) << simd
+              << std::setw(9) << std::setprecision(2) << scalar / simd << "x\n";
+  }
+
+}
+
+int main() {
+  std::cout << "Closest-hit intersection kernels (" << render::intersection_kernel_isa() << " kernels)\n";
+  std::cout << std::left << std::setw(12) << "primitive" << std::setw(10) << "count" << std::right << std::setw(16) << "scalar ns/test"
+            << std::setw(16) << "simd ns/test" << std::setw(10) << "speedup" << '\n';
+
+  std::mt19937 rng(0);
+  const auto rays = make_rays(1024, rng);
+  for (const std::size_t count : {8U, 64U, 512U, 4096U}) {
+    const auto spheres = make_spheres(count, rng);
+    const auto view = sphere_view(spheres);
+    print_row("sphere", count, measure(view, rays, render::closest_sphere_hit_scalar), measure(view, rays, render::closest_sphere_hit));
+  }
+  for (const std::size_t count : {8U, 64U, 512U, 4096U}) {
+    const auto cylinders = make_cylinders(count, rng);
+    const auto view = cylinder_view(cylinders);
+    print_row("cylinder", count, measure(view, rays, render::closest_cylinder_hit_scalar), measure(view, rays, render::closest_cylinder_hit));
+  }
+
+  return 0;
+}
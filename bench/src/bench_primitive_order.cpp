@@ -0,0 +1,154 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "baked_scene.hpp"
+#include "bvh.hpp"
+#include "camera.hpp"
+#include "config.hpp"
+#include "cylinder.hpp"
+#include "material.hpp"
+#include "ray.hpp"
+#include "renderer.hpp"
+#include "scene.hpp"
+#include "sphere.hpp"
+
+namespace {
+
+  constexpr int repeats = 5;
+
+  // Keeps the optimizer from discarding the results.
+  volatile double sink = 0.0;
+
+  // Small spheres and cylinders scattered over a plane, in shuffled order as a
+  // generator script would emit them.
+  render::scene make_scene(std::size_t count) {
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<double> coord(-60.0, 60.0);
+    std::uniform_real_distribution<double> size(0.05, 0.2);
+
+    std::vector<std::shared_ptr<render::sphere>> spheres;
+    std::vector<std::shared_ptr<render::cylinder>> cylinders;
+    render::scene sc;
+    const render::material_id mat = sc.add_material(render::matte_material{"matte", 0.5, 0.5, 0.5});
+    for (std::size_t i = 0; i < count; ++i) {
+      const double x = coord(rng);
+      const double z = coord(rng);
+      const double r = size(rng);
+      if (i % 4 == 0) {
+        cylinders.push_back(std::make_shared<render::cylinder>(render::vector{x, r, z}, r * 0.5, render::vector{0.0, r * 2.0, 0.0}, mat));
+      } else {
+        spheres.push_back(std::make_shared<render::sphere>(render::vector{x, r, z}, r, mat));
+      }
+    }
+    std::shuffle(spheres.begin(), spheres.end(), rng);
+    std::shuffle(cylinders.begin(), cylinders.end(), rng);
+    for (auto& sph : spheres) {
+      sc.add_sphere(std::move(sph));
+    }
+    for (auto& cyl : cylinders) {
+      sc.add_cylinder(std::move(cyl));
+    }
+    return sc;
+  }
+
+  // Median distance, in records, between the primitives of one kind that
+  // follow each other in BVH leaf order: how far apart in memory the
+  // consecutive sphere or cylinder tests of a traversal typically are.
+  std::uint32_t median_leaf_stride(const render::bvh& accel, std::size_t num_spheres) {
+    std::optional<std::uint32_t> last_sphere;
+    std::optional<std::uint32_t> last_cylinder;
+    std::vector<std::uint32_t> strides;
+    for (const std::uint32_t prim : accel.get_primitive_indices()) {
+      std::optional<std::uint32_t>& last = prim < num_spheres ? last_sphere : last_cylinder;
+      if (last) {
+        strides.push_back(prim > *last ? prim - *last : *last - prim);
+      }
+      last = prim;
+    }
+    if (strides.empty()) {
+      return 0;
+    }
+    std::nth_element(strides.begin(), strides.begin() + static_cast<std::ptrdiff_t>(strides.size() / 2), strides.end());
+    return strides[strides.size() / 2];
+  }
+
+  std::string order_name(render::primitive_order order) {
+    switch (order) {
+      case render::primitive_order::file:
+        return "file";
+      case render::primitive_order::morton:
+        return "morton";
+      case render::primitive_order::hilbert:
+        return "hilbert";
+    }
+    return "unknown";
+  }
+
+}
+
+int main(int argc, char* argv[]) {
+  const std::size_t count = argc > 1 ? static_cast<std::size_t>(std::strtoull(argv[1], nullptr, 10)) : 300000;
+
+  render::render_config config;
+  config.image_width = 320;
+  config.camera_position = render::vector{13.0, 2.0, 3.0};
+  config.camera_target = render::vector{0.0, 0.0, 0.0};
+  config.field_of_view = 20.0;
+  const render::camera cam{config};
+  const int width = cam.get_image_width();
+  const int height = cam.get_image_height();
+
+  // One ray per pixel in scanline order, as neighbouring tiles trace them.
+  std::vector<render::ray> rays;
+  for (int j = 0; j < height; ++j) {
+    for (int i = 0; i < width; ++i) {
+      rays.push_back(cam.get_ray((i + 0.5) / width, (j + 0.5) / height));
+    }
+  }
+
+  std::cout << "Primitive order over " << count << " primitives, SAH BVH, " << rays.size() << " primary rays\n";
+  std::cout << std::left << std::setw(10) << "order" << std::right << std::setw(12) << "sort ms" << std::setw(14) << "leaf stride"
+            << std::setw(12) << "ns/ray" << '\n';
+
+  const render::scene parsed = make_scene(count);
+  for (const auto order : {render::primitive_order::file, render::primitive_order::morton, render::primitive_order::hilbert}) {
+    render::scene sc = parsed;
+    const auto sort_start = std::chrono::steady_clock::now();
+    sc.reorder(order);
+    const auto sort_stop = std::chrono::steady_clock::now();
+
+    const render::baked_scene baked{sc};
+    const std::optional<render::bvh> accel = render::bvh::build_sah(baked.get_primitive_bounds());
+    const render::renderer tracer{config, baked, accel};
+
+    double best = std::numeric_limits<double>::max();
+    for (int repeat = 0; repeat < repeats; ++repeat) {
+      const auto start = std::chrono::steady_clock::now();
+      double checksum = 0.0;
+      for (const auto& r : rays) {
+        const auto hit = tracer.find_closest_primitive(r);
+        checksum += hit ? hit->t : 0.0;
+      }
+      const auto stop = std::chrono::steady_clock::now();
+      sink = sink + checksum;
+      best = std::min(best, std::chrono::duration<double, std::nano>(stop - start).count() / static_cast<double>(rays.size()));
+    }
+
+    std::cout << std::left << std::setw(10) << order_name(order) << std::right << std::fixed
+              << std::setw(12) << std::setprecision(1) << std::chrono::duration<double, std::milli>(sort_stop - sort_start).count()
+              << std::setw(14) << median_leaf_stride(*accel, baked.get_spheres().size())
+              << std::setw(12) << std::setprecision(1) << best << '\n';
+  }
+
+  return 0;
+}
@@ -0,0 +1,95 @@
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "random.hpp"
+#include "simd_random.hpp"
+
+namespace {
+
+  constexpr std::size_t values_per_run = 1U << 24;
+
+  // Keeps the optimizer from discarding the generated values.
+  volatile double sink = 0.0;
+
+  template <typename Fn>
+  void measure(const std::string& name, Fn&& fn) {
+    const auto start = std::chrono::steady_clock::now();
+    const double checksum = fn();
+    const auto stop = std::chrono::steady_clock::now();
+    sink = sink + checksum;
+
+    const double ns = std::chrono::duration<double, std::nano>(stop - start).count();
+    std::cout << std::left << std::setw(44) << name
+              << std::right << std::setw(8) << std::fixed << std::setprecision(3)
+              << ns / static_cast<double>(values_per_run) << " ns/value\n";
+  }
+
+}
+
+int main() {
+  std::cout << "Generating " << values_per_run << " uniform values per run\n";
+
+  measure("mt19937 + uniform_real_distribution", [] {
+    std::mt19937 rng(0);
+    double sum = 0.0;
+    for (std::size_t i = 0; i < values_per_run; ++i) {
+      std::uniform_real_distribution<double> dist(-1.0, 1.0);
+      sum += dist(rng);
+    }
+    return sum;
+  });
+
+  measure("philox4x32 per value", [] {
+    double sum = 0.0;
+    for (std::size_t i = 0; i < values_per_run; i += 2) {
+      const auto bits = render::philox4x32({static_cast<std::uint32_t>(i), 0U, 0U, 0U}, {0U, 0U});
+      sum += render::to_unit_double(bits[0], bits[1]) + render::to_unit_double(bits[2], bits[3]);
+    }
+    return sum;
+  });
+
+  measure("xoshiro256x4 fill_uniform(double)", [] {
+    render::xoshiro256x4 gen{0U};
+    std::vector<double> buffer(4096);
+    double sum = 0.0;
+    for (std::size_t i = 0; i < values_per_run; i += buffer.size()) {
+      gen.fill_uniform(buffer.data(), buffer.size());
+      sum += buffer[i % buffer.size()];
+    }
+    return sum;
+  });
+
+  measure("xoshiro256x4 fill_uniform(float)", [] {
+    render::xoshiro256x4 gen{0U};
+    std::vector<float> buffer(4096);
+    double sum = 0.0;
+    for (std::size_t i = 0; i < values_per_run; i += buffer.size()) {
+      gen.fill_uniform(buffer.data(), buffer.size());
+      sum += static_cast<double>(buffer[i % buffer.size()]);
+    }
+    return sum;
+  });
+
+  // Renderer access pattern: a new stream per path sample, a few draws per bounce.
+  measure("random_stream (8 bounces x 6 draws)", [] {
+    double sum = 0.0;
+    std::uint32_t sample = 0;
+    for (std::size_t i = 0; i < values_per_run; i += 48, ++sample) {
+      render::random_stream rng{0U, i, sample, render::random_domain::material};
+      for (std::uint32_t bounce = 0; bounce < 8; ++bounce) {
+        rng.set_bounce(bounce);
+        for (int d = 0; d < 6; ++d) {
+          sum += rng.uniform();
+        }
+      }
+    }
+    return sum;
+  });
+
+  return 0;
+}
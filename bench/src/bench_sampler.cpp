@@ -0,0 +1,170 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "baked_scene.hpp"
+#include "bvh.hpp"
+#include "camera.hpp"
+#include "config.hpp"
+#include "cylinder.hpp"
+#include "material.hpp"
+#include "random.hpp"
+#include "renderer.hpp"
+#include "renderer_utils.hpp"
+#include "scene.hpp"
+#include "sphere.hpp"
+
+namespace {
+
+  constexpr int reference_samples = 4096;
+  constexpr int sample_counts[] = {4, 8, 16, 25, 32, 40, 64, 100, 128, 256};
+  // Samples per pixel whose independent-sampling error the others are matched against.
+  constexpr int baseline_samples = 100;
+
+  // A matte ground, a diffuse, a fuzzy metal and a glass sphere and a metal
+  // cylinder: every scatter function and the sky.
+  render::scene make_scene() {
+    render::scene sc;
+    const render::material_id ground = sc.add_material(render::matte_material{"ground", 0.5, 0.5, 0.5});
+    const render::material_id matte = sc.add_material(render::matte_material{"matte", 0.7, 0.3, 0.1});
+    const render::material_id metal = sc.add_material(render::metal_material{"metal", 0.8, 0.8, 0.9, 0.3});
+    const render::material_id glass = sc.add_material(render::refractive_material{"glass", 1.5});
+    sc.add_sphere(std::make_shared<render::sphere>(render::vector{0.0, -1000.0, 0.0}, 1000.0, ground));
+    sc.add_sphere(std::make_shared<render::sphere>(render::vector{-4.0, 1.0, 0.0}, 1.0, matte));
+    sc.add_sphere(std::make_shared<render::sphere>(render::vector{0.0, 1.0, 0.0}, 1.0, glass));
+    sc.add_sphere(std::make_shared<render::sphere>(render::vector{4.0, 1.0, 0.0}, 1.0, metal));
+    sc.add_cylinder(std::make_shared<render::cylinder>(render::vector{2.0, 0.5, 2.5}, 0.5, render::vector{0.0, 1.0, 0.0}, metal));
+    return sc;
+  }
+
+  // Estimates of every pixel with the given sampler, bottom row first.
+  template <typename Renderer>
+  std::vector<render::pixel_estimate> render_image(const render::render_config& config, const render::camera& cam, const Renderer& tracer) {
+    const int width = cam.get_image_width();
+    const int height = cam.get_image_height();
+    const render::sample_pattern pattern = render::sample_pattern_for(config);
+    std::vector<render::pixel_estimate> pixels(static_cast<std::size_t>(width) * static_cast<std::size_t>(height));
+    for (int j = 0; j < height; ++j) {
+      for (int i = 0; i < width; ++i) {
+        const auto pixel = static_cast<std::uint64_t>(j) * static_cast<std::uint64_t>(width) + static_cast<std::uint64_t>(i);
+        render::pixel_estimate& estimate = pixels[pixel];
+        while (estimate.needs_sample(config)) {
+          const auto s = static_cast<std::uint32_t>(estimate.count);
+          render::random_stream ray_rng{config.ray_rng_seed, pixel, s, render::random_domain::camera, pattern};
+          render::random_stream material_rng{config.material_rng_seed, pixel, s, render::random_domain::material, pattern};
+          const double u = (static_cast<double>(i) + ray_rng.uniform()) / static_cast<double>(width);
+          const double v = (static_cast<double>(j) + ray_rng.uniform()) / static_cast<double>(height);
+          estimate.add(tracer.trace_ray(cam.get_ray(u, v), 0, material_rng));
+        }
+      }
+    }
+    return pixels;
+  }
+
+  // Root mean square error of pixel luminance against the reference, less
+  // the reference's own variance so that its noise does not set a floor.
+  double luminance_rmse(const std::vector<render::pixel_estimate>& image, const std::vector<render::pixel_estimate>& reference) {
+    double squared = 0.0;
+    for (std::size_t k = 0; k < image.size(); ++k) {
+      const render::pixel_estimate& ref = reference[k];
+      const double error = render::luminance(image[k].mean()) - ref.luminance_mean;
+      const double n = static_cast<double>(ref.count);
+      squared += error * error - ref.luminance_m2 / (n - 1.0) / n;
+    }
+    return std::sqrt(std::max(squared / static_cast<double>(image.size()), 0.0));
+  }
+
+  std::string sampler_name(render::sampler_type sampler) {
+    switch (sampler) {
+      case render::sampler_type::independent:
+        return "independent";
+      case render::sampler_type::stratified:
+        return "stratified";
+      case render::sampler_type::sobol:
+        return "sobol";
+    }
+    return "unknown";
+  }
+
+}
+
+int main(int argc, char* argv[]) {
+  render::render_config config;
+  config.image_width = argc > 1 ? std::atoi(argv[1]) : 64;
+  config.camera_position = render::vector{0.0, 2.0, 10.0};
+  config.camera_target = render::vector{0.0, 1.0, 0.0};
+  config.field_of_view = 50.0;
+  config.max_depth = 8;
+  const render::camera cam{config};
+
+  const render::scene sc = make_scene();
+  const render::baked_scene baked{sc};
+  const std::optional<render::bvh> accel = render::build_acceleration(config, baked.get_primitive_bounds());
+  const render::renderer tracer{config, baked, accel};
+
+  // Independent samples under other seeds, so the reference shares no
+  // points with any image it judges.
+  render::render_config reference_config = config;
+  reference_config.samples_per_pixel = reference_samples;
+  reference_config.ray_rng_seed = 1000;
+  reference_config.material_rng_seed = 1001;
+  const auto reference = render_image(reference_config, cam, tracer);
+
+  std::cout << "Luminance RMSE against a " << reference_samples << " spp reference, " << cam.get_image_width() << "x" << cam.get_image_height()
+            << " pixels\n";
+  std::cout << std::setw(6) << "spp";
+  const render::sampler_type samplers[] = {render::sampler_type::independent, render::sampler_type::stratified, render::sampler_type::sobol};
+  for (const auto sampler : samplers) {
+    std::cout << std::setw(14) << sampler_name(sampler);
+  }
+  std::cout << std::setw(12) << "ms (sobol)" << '\n';
+
+  std::vector<std::vector<double>> errors(std::size(samplers));
+  for (const int samples : sample_counts) {
+    std::cout << std::setw(6) << samples;
+    double milliseconds = 0.0;
+    for (std::size_t k = 0; k < std::size(samplers); ++k) {
+      render::render_config sampled = config;
+      sampled.samples_per_pixel = samples;
+      sampled.sampler = samplers[k];
+      const auto start = std::chrono::steady_clock::now();
+      const auto image = render_image(sampled, cam, tracer);
+      milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+      errors[k].push_back(luminance_rmse(image, reference));
+      std::cout << std::setw(14) << std::fixed << std::setprecision(5) << errors[k].back();
+    }
+    std::cout << std::setw(12) << std::setprecision(1) << milliseconds << '\n';
+  }
+
+  // Samples each sampler needs for the error of independent sampling at
+  // baseline_samples, interpolated between measured counts on log-log axes.
+  const auto baseline = static_cast<std::size_t>(std::find(std::begin(sample_counts), std::end(sample_counts), baseline_samples) - std::begin(sample_counts));
+  const double target = errors[0][baseline];
+  std::cout << "spp for the error of " << baseline_samples << " independent spp:";
+  for (std::size_t k = 0; k < std::size(samplers); ++k) {
+    std::optional<double> needed;
+    for (std::size_t c = 1; c < errors[k].size() && !needed; ++c) {
+      if (errors[k][c] <= target && errors[k][c - 1] > target) {
+        const double t = std::log(errors[k][c - 1] / target) / std::log(errors[k][c - 1] / errors[k][c]);
+        needed = std::exp(std::log(sample_counts[c - 1]) + t * std::log(static_cast<double>(sample_counts[c]) / sample_counts[c - 1]));
+      }
+    }
+    std::cout << "  " << sampler_name(samplers[k]) << " ";
+    if (needed) {
+      std::cout << std::setprecision(0) << *needed;
+    } else {
+      std::cout << "-";
+    }
+  }
+  std::cout << '\n';
+
+  return 0;
+}
@@ -0,0 +1,104 @@
+#ifndef RENDER_AABB_HPP
+#define RENDER_AABB_HPP
+
+#include "vector.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+
+namespace render {
+
+  // Axis-aligned bounding box. An empty box has min > max on every axis so
+  // that expanding it by anything yields exactly that thing.
+  struct aabb {
+    std::array<double, 3> min{
+      std::numeric_limits<double>::infinity(),
+      std::numeric_limits<double>::infinity(),
+      std::numeric_limits<double>::infinity()
+    };
+    std::array<double, 3> max{
+      -std::numeric_limits<double>::infinity(),
+      -std::numeric_limits<double>::infinity(),
+      -std::numeric_limits<double>::infinity()
+    };
+
+    void expand(const aabb& other) {
+      for (size_t axis = 0; axis < 3; ++axis) {
+        min[axis] = std::min(min[axis], other.min[axis]);
+        max[axis] = std::max(max[axis], other.max[axis]);
+      }
+    }
+
+    void expand(const std::array<double, 3>& point) {
+      for (size_t axis = 0; axis < 3; ++axis) {
+        min[axis] = std::min(min[axis], point[axis]);
+        max[axis] = std::max(max[axis], point[axis]);
+      }
+    }
+
+    [[nodiscard]] bool is_empty() const { return min[0] > max[0]; }
+
+    [[nodiscard]] std::array<double, 3> centroid() const {
+      return {0.5 * (min[0] + max[0]), 0.5 * (min[1] + max[1]), 0.5 * (min[2] + max[2])};
+    }
+
+    [[nodiscard]] double surface_area() const {
+      if (is_empty()) {
+        return 0.0;
+      }
+      const double dx = max[0] - min[0];
+      const double dy = max[1] - min[1];
+      const double dz = max[2] - min[2];
+      return 2.0 * (dx * dy + dy * dz + dz * dx);
+    }
+
+    // Slab test against [t_min, t_max]; returns the entry distance or a negative
+    // value on a miss. NaNs from 0 * inf (origin on a slab plane with a zero
+    // direction component) fail every comparison and leave the interval
+    // unchanged, which errs on the side of reporting a hit.
+    [[nodiscard]] double intersect(const std::array<double, 3>& origin, const std::array<double, 3>& inv_direction, double t_min, double t_max) const {
+      for (size_t axis = 0; axis < 3; ++axis) {
+        double t0 = (min[axis] - origin[axis]) * inv_direction[axis];
+        double t1 = (max[axis] - origin[axis]) * inv_direction[axis];
+        if (t0 > t1) {
+          std::swap(t0, t1);
+        }
+        t_min = t0 > t_min ? t0 : t_min;
+        t_max = t1 < t_max ? t1 : t_max;
+        if (t_min > t_max) {
+          return -1.0;
+        }
+      }
+      return t_min;
+    }
+  };
+
+  [[nodiscard]] inline aabb make_sphere_bounds(const vector& center, double radius) {
+    aabb box;
+    box.min = {center.get_x() - radius, center.get_y() - radius, center.get_z() - radius};
+    box.max = {center.get_x() + radius, center.get_y() + radius, center.get_z() + radius};
+    return box;
+  }
+
+  // Exact bounds of a capped cylinder: along each world axis the caps reach
+  // half_height * |a_i| from the center and the rim adds radius * sqrt(1 - a_i^2).
+  [[nodiscard]] inline aabb make_cylinder_bounds(const vector& center, double radius, const vector& axis) {
+    const vector axis_norm = axis.normalize();
+    const double half_height = axis.magnitude() / 2.0;
+    const std::array<double, 3> c{center.get_x(), center.get_y(), center.get_z()};
+    const std::array<double, 3> a{axis_norm.get_x(), axis_norm.get_y(), axis_norm.get_z()};
+
+    aabb box;
+    for (size_t i = 0; i < 3; ++i) {
+      const double extent = half_height * std::abs(a[i]) + radius * std::sqrt(std::max(0.0, 1.0 - a[i] * a[i]));
+      box.min[i] = c[i] - extent;
+      box.max[i] = c[i] + extent;
+    }
+    return box;
+  }
+
+}
+
+#endif
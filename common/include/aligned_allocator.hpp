@@ -0,0 +1,44 @@
+#ifndef RENDER_ALIGNED_ALLOCATOR_HPP
+#define RENDER_ALIGNED_ALLOCATOR_HPP
+
+#include <cstddef>
+#include <new>
+#include <vector>
+
+namespace render {
+
+  constexpr std::size_t cache_line_size = 64;
+
+  // Allocator that starts every block on an Alignment boundary, so SIMD loops
+  // over the data can use aligned loads and never split a cache line.
+  template <typename T, std::size_t Alignment = cache_line_size>
+  struct aligned_allocator {
+    using value_type = T;
+
+    template <typename U>
+    struct rebind {
+      using other = aligned_allocator<U, Alignment>;
+    };
+
+    aligned_allocator() noexcept = default;
+    template <typename U>
+    explicit aligned_allocator(const aligned_allocator<U, Alignment>& /*other*/) noexcept {}
+
+    [[nodiscard]] T* allocate(std::size_t n) {
+      return static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t{Alignment}));
+    }
+
+    void deallocate(T* p, std::size_t /*n*/) noexcept {
+      ::operator delete(p, std::align_val_t{Alignment});
+    }
+
+    template <typename U>
+    bool operator==(const aligned_allocator<U, Alignment>& /*other*/) const noexcept { return true; }
+  };
+
+  template <typename T>
+  using aligned_vector = std::vector<T, aligned_allocator<T>>;
+
+}
+
+#endif
@@ -0,0 +1,128 @@
+#ifndef RENDER_BAKED_SCENE_HPP
+#define RENDER_BAKED_SCENE_HPP
+
+#include "aabb.hpp"
+#include "aligned_allocator.hpp"
+#include "cylinder.hpp"
+#include "material.hpp"
+#include "ray.hpp"
+#include "scene.hpp"
+#include "sphere.hpp"
+#include "vector.hpp"
+
+#include <cstddef>
+#include <optional>
+#include <span>
+
+namespace render {
+
+  // Render-ready sphere: everything a hit test needs, with the squared radius
+  // worked out once at bake time.
+  template <typename T>
+  struct basic_baked_sphere {
+    basic_vector<T> center;
+    T radius = 0;
+    T radius_squared = 0;
+    material_id mat = 0;
+
+    // Same arithmetic as sphere::hit_distance, so in double both give
+    // identical distances.
+    [[nodiscard]] std::optional<T> hit_distance(const basic_ray<T>& r, T t_min, T t_max) const {
+      const basic_vector<T> oc = r.get_origin() - center;
+      const T a = r.get_direction().dot(r.get_direction());
+      const T b = T{2} * oc.dot(r.get_direction());
+      const T c = oc.dot(oc) - radius_squared;
+      const T discriminant = b * b - T{4} * a * c;
+
+      if (discriminant < T{0}) {
+        return std::nullopt;
+      }
+
+      const T sqrt_d = std::sqrt(discriminant);
+      const T t1 = (-b - sqrt_d) / (T{2} * a);
+      const T t2 = (-b + sqrt_d) / (T{2} * a);
+
+      T t = (t1 > t_min) ? t1 : ((t2 > t_min) ? t2 : T{-1});
+
+      if (t <= t_min || t >= t_max) {
+        return std::nullopt;
+      }
+      return t;
+    }
+
+    [[nodiscard]] basic_hit_info<T> surface_at(const basic_ray<T>& r, T t) const {
+      const basic_vector<T> point = r.point_at(t);
+      return basic_hit_info<T>{t, point, (point - center).normalize(), mat};
+    }
+  };
+
+  // Render-ready cylinder: the precomputed frame plus the original radius and
+  // axis, which bounds and the structure-of-arrays columns are built from.
+  template <typename T>
+  struct basic_baked_cylinder {
+    basic_cylinder_frame<T> frame;
+    basic_vector<T> axis;
+    T radius = 0;
+    material_id mat = 0;
+
+    [[nodiscard]] std::optional<T> hit_distance(const basic_ray<T>& r, T t_min, T t_max) const {
+      const auto hit = frame.closest_part(r, t_min, t_max);
+      return hit ? std::optional<T>{static_cast<T>(hit->t)} : std::nullopt;
+    }
+
+    [[nodiscard]] basic_hit_info<T> surface_at(const basic_ray<T>& r, T t) const {
+      const basic_vector<T> point = r.point_at(t);
+      return basic_hit_info<T>{t, point, frame.normal_at(frame.part_at(r, t), point), mat};
+    }
+  };
+
+  // Immutable flat copy of a parsed scene. Sphere records, cylinder records and
+  // primitive bounds live back to back in one allocation, each section starting
+  // on a cache line, so rendering touches no shared_ptr or name lookup. Bounds
+  // follow the usual primitive numbering: spheres first, then cylinders, and
+  // always enclose the geometry as rounded to T.
+  template <typename T>
+  class basic_baked_scene {
+  public:
+    explicit basic_baked_scene(const scene& sc);
+
+    basic_baked_scene(const basic_baked_scene&) = delete;
+    basic_baked_scene& operator=(const basic_baked_scene&) = delete;
+    basic_baked_scene(basic_baked_scene&&) noexcept = default;
+    basic_baked_scene& operator=(basic_baked_scene&&) noexcept = default;
+    ~basic_baked_scene() = default;
+
+    [[nodiscard]] std::span<const basic_baked_sphere<T>> get_spheres() const;
+    [[nodiscard]] std::span<const basic_baked_cylinder<T>> get_cylinders() const;
+    [[nodiscard]] std::span<const aabb> get_primitive_bounds() const;
+    [[nodiscard]] const material_table& get_materials() const { return materials_; }
+
+    // Bytes held by the flat block, padding included.
+    [[nodiscard]] std::size_t get_memory_bytes() const { return block_.size(); }
+
+  private:
+    material_table materials_;
+    aligned_vector<std::byte> block_;
+    std::size_t num_spheres_ = 0;
+    std::size_t num_cylinders_ = 0;
+    std::size_t cylinders_offset_ = 0;
+    std::size_t bounds_offset_ = 0;
+  };
+
+  extern template class basic_baked_scene<float>;
+  extern template class basic_baked_scene<double>;
+
+  using baked_sphere = basic_baked_sphere<double>;
+  using baked_cylinder = basic_baked_cylinder<double>;
+  using baked_scene = basic_baked_scene<double>;
+
+  // Bakes the scene at precision T and logs the bake time and memory footprint.
+  template <typename T = double>
+  [[nodiscard]] basic_baked_scene<T> bake_scene(const scene& sc);
+
+  extern template basic_baked_scene<float> bake_scene<float>(const scene& sc);
+  extern template basic_baked_scene<double> bake_scene<double>(const scene& sc);
+
+}
+
+#endif
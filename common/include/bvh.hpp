@@ -0,0 +1,247 @@
+#ifndef RENDER_BVH_HPP
+#define RENDER_BVH_HPP
+
+#include "aabb.hpp"
+#include "config.hpp"
+#include "primitive_arrays.hpp"
+#include "ray.hpp"
+#include "ray_packet.hpp"
+#include "thread_pool.hpp"
+
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <vector>
+
+namespace render {
+
+  // Nodes are stored depth-first: the first child of an interior node directly
+  // follows it and offset points at the second child. For leaves offset is the
+  // first entry of the primitive index list and count is non-zero.
+  struct bvh_node {
+    aabb bounds;
+    std::uint32_t offset = 0;
+    std::uint32_t count = 0;
+    std::uint32_t axis = 0;
+  };
+
+  // Bounding volume hierarchy over an indexed list of primitives. The tree only
+  // knows primitive numbers; callers decide what number maps to which sphere or
+  // cylinder and do the actual intersection in the traversal callback.
+  class bvh {
+  public:
+    // Entries of the traversal stacks, which hold at most one node per level,
+    // so trees must not be deeper than this.
+    static constexpr std::size_t traversal_stack_size = 128;
+
+    bvh() = default;
+    bvh(const bvh& other);
+    bvh& operator=(const bvh& other);
+    bvh(bvh&&) noexcept = default;
+    bvh& operator=(bvh&&) noexcept = default;
+    ~bvh() = default;
+
+    // A tree whose nodes and index list live elsewhere, such as in a mapped
+    // compiled scene file; they must outlive the tree and all its copies.
+    [[nodiscard]] static bvh view(std::span<const bvh_node> nodes, std::span<const std::uint32_t> primitive_indices);
+
+    // Top-down build with a binned surface area heuristic.
+    [[nodiscard]] static bvh build_sah(std::span<const aabb> primitive_bounds);
+
+    // Linear BVH (Karras 2012) tuned for build time: centroids quantized to
+    // Morton codes (30-bit up to 2^20 primitives, 63-bit beyond), a parallel
+    // radix sort and an independent split search per interior node. Traces
+    // slower than build_sah but builds in a fraction of the time.
+    [[nodiscard]] static bvh build_lbvh(std::span<const aabb> primitive_bounds, thread_pool& pool);
+    // Same, reading sphere and cylinder geometry straight from coordinate arrays.
+    [[nodiscard]] static bvh build_lbvh(const primitive_arrays& primitives, thread_pool& pool);
+
+    [[nodiscard]] std::span<const bvh_node> get_nodes() const { return nodes_; }
+    [[nodiscard]] std::span<const std::uint32_t> get_primitive_indices() const { return primitive_indices_; }
+    [[nodiscard]] int get_depth() const;
+
+    // Visits leaves front to back. intersect(primitive, t_max) returns the hit
+    // distance of a hit closer than t_max, which then becomes the new t_max so
+    // that farther subtrees are culled. Boxes are always tested in double,
+    // whatever the precision of the ray.
+    template <typename Scalar, typename Intersect>
+    void traverse(const basic_ray<Scalar>& r, double t_min, double t_max, Intersect&& intersect) const {
+      if (nodes_.empty()) {
+        return;
+      }
+
+      const vector o{r.get_origin()};
+      const vector d{r.get_direction()};
+      const std::array<double, 3> origin{o.get_x(), o.get_y(), o.get_z()};
+      const std::array<double, 3> inv_direction{1.0 / d.get_x(), 1.0 / d.get_y(), 1.0 / d.get_z()};
+
+      if (nodes_[0].bounds.intersect(origin, inv_direction, t_min, t_max) < 0.0) {
+        return;
+      }
+
+      struct entry {
+        std::uint32_t node;
+        double t_enter;
+      };
+      std::array<entry, traversal_stack_size> stack;
+      size_t stack_size = 0;
+      std::uint32_t current = 0;
+
+      while (true) {
+        const bvh_node& node = nodes_[current];
+        if (node.count > 0) {
+          for (std::uint32_t i = node.offset; i < node.offset + node.count; ++i) {
+            const std::optional<double> t = intersect(primitive_indices_[i], t_max);
+            if (t && *t < t_max) {
+              t_max = *t;
+            }
+          }
+        } else {
+          const std::uint32_t first = current + 1;
+          const std::uint32_t second = node.offset;
+          const double t_first = nodes_[first].bounds.intersect(origin, inv_direction, t_min, t_max);
+          const double t_second = nodes_[second].bounds.intersect(origin, inv_direction, t_min, t_max);
+
+          if (t_first >= 0.0 && t_second >= 0.0) {
+            const bool first_nearer = t_first <= t_second;
+            stack[stack_size++] = first_nearer ? entry{second, t_second} : entry{first, t_first};
+            current = first_nearer ? first : second;
+            continue;
+          }
+          if (t_first >= 0.0) {
+            current = first;
+            continue;
+          }
+          if (t_second >= 0.0) {
+            current = second;
+            continue;
+          }
+        }
+
+        // Pop the next subtree that can still contain a closer hit.
+        bool found = false;
+        while (stack_size > 0) {
+          const entry next = stack[--stack_size];
+          if (next.t_enter <= t_max) {
+            current = next.node;
+            found = true;
+            break;
+          }
+        }
+        if (!found) {
+          return;
+        }
+      }
+    }
+
+    // Packet version of traverse. A subtree is entered when any active ray's
+    // slab test passes within that ray's own t_max[k], children are visited in
+    // order of their nearest entry, and intersect(primitive) is expected to
+    // test every ray and lower t_max itself.
+    template <typename Intersect>
+    void traverse_packet(const ray_packet& packet, double t_min, const double* t_max, Intersect&& intersect) const {
+      if (nodes_.empty() || packet.count == 0) {
+        return;
+      }
+
+      std::array<std::array<double, 3>, ray_packet::capacity> origins;
+      std::array<std::array<double, 3>, ray_packet::capacity> inv_directions;
+      for (size_t k = 0; k < packet.count; ++k) {
+        origins[k] = {packet.origin_x[k], packet.origin_y[k], packet.origin_z[k]};
+        inv_directions[k] = {1.0 / packet.direction_x[k], 1.0 / packet.direction_y[k], 1.0 / packet.direction_z[k]};
+      }
+
+      // Nearest entry distance over the rays that hit the box, or -1.
+      const auto enter = [&](const aabb& box) {
+        double nearest = -1.0;
+        for (size_t k = 0; k < packet.count; ++k) {
+          const double t = box.intersect(origins[k], inv_directions[k], t_min, t_max[k]);
+          if (t >= 0.0 && (nearest < 0.0 || t < nearest)) {
+            nearest = t;
+          }
+        }
+        return nearest;
+      };
+      const auto farthest = [&] {
+        double t = t_max[0];
+        for (size_t k = 1; k < packet.count; ++k) {
+          t = t_max[k] > t ? t_max[k] : t;
+        }
+        return t;
+      };
+
+      if (enter(nodes_[0].bounds) < 0.0) {
+        return;
+      }
+
+      struct entry {
+        std::uint32_t node;
+        double t_enter;
+      };
+      std::array<entry, traversal_stack_size> stack;
+      size_t stack_size = 0;
+      std::uint32_t current = 0;
+
+      while (true) {
+        const bvh_node& node = nodes_[current];
+        if (node.count > 0) {
+          for (std::uint32_t i = node.offset; i < node.offset + node.count; ++i) {
+            intersect(primitive_indices_[i]);
+          }
+        } else {
+          const std::uint32_t first = current + 1;
+          const std::uint32_t second = node.offset;
+          const double t_first = enter(nodes_[first].bounds);
+          const double t_second = enter(nodes_[second].bounds);
+
+          if (t_first >= 0.0 && t_second >= 0.0) {
+            const bool first_nearer = t_first <= t_second;
+            stack[stack_size++] = first_nearer ? entry{second, t_second} : entry{first, t_first};
+            current = first_nearer ? first : second;
+            continue;
+          }
+          if (t_first >= 0.0) {
+            current = first;
+            continue;
+          }
+          if (t_second >= 0.0) {
+            current = second;
+            continue;
+          }
+        }
+
+        bool found = false;
+        while (stack_size > 0) {
+          const entry next = stack[--stack_size];
+          if (next.t_enter <= farthest()) {
+            current = next.node;
+            found = true;
+            break;
+          }
+        }
+        if (!found) {
+          return;
+        }
+      }
+    }
+
+  private:
+    // Points the views at the builders' output.
+    void adopt_storage();
+
+    std::vector<bvh_node> node_storage_;
+    std::vector<std::uint32_t> index_storage_;
+    // What traversal reads: the storage above, or memory owned elsewhere.
+    std::span<const bvh_node> nodes_;
+    std::span<const std::uint32_t> primitive_indices_;
+  };
+
+  // Builds the structure selected by config.acceleration over the given
+  // primitives and logs the build time; returns nothing for brute force.
+  [[nodiscard]] std::optional<bvh> build_acceleration(const render_config& config, std::span<const aabb> primitive_bounds);
+  [[nodiscard]] std::optional<bvh> build_acceleration(const render_config& config, const primitive_arrays& primitives);
+
+}
+
+#endif
@@ -3,6 +3,7 @@
 
 #include "config.hpp"
 #include "ray.hpp"
+#include "ray_packet.hpp"
 #include "vector.hpp"
 
 #include <cmath>
@@ -14,6 +15,9 @@ namespace render {
     camera(const render_config& config);
 
     [[nodiscard]] ray get_ray(double u, double v) const;
+    // Fills the first packet.count lanes with the rays get_ray(u[k], v[k])
+    // would return, computed lane-wise.
+    void get_rays(const double* u, const double* v, ray_packet& packet) const;
     [[nodiscard]] int get_image_width() const { return image_width_; }
     [[nodiscard]] int get_image_height() const { return image_height_; }
 
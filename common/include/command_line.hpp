@@ -0,0 +1,40 @@
+#ifndef RENDER_COMMAND_LINE_HPP
+#define RENDER_COMMAND_LINE_HPP
+
+#include "config.hpp"
+#include "kernel_dispatch.hpp"
+
+#include <optional>
+#include <string>
+
+namespace render {
+
+  struct command_line {
+    std::string config_file;
+    std::string scene_file;
+    std::string output_file;
+
+    std::optional<int> threads;
+    std::optional<int> tile_size;
+    // Kernel variant forced with --isa; nullopt (or "--isa auto") picks the
+    // best one the CPU supports.
+    std::optional<cpu_isa> isa;
+    // Where --sample-counts writes how many samples each pixel took.
+    std::optional<std::string> sample_counts_file;
+
+    // Options given on the command line take precedence over the config file.
+    void apply_overrides(render_config& config) const;
+  };
+
+  class command_line_parser {
+  public:
+    [[nodiscard]] static command_line parse(int argc, const char* const argv[]);
+    [[nodiscard]] static std::string usage(const std::string& program);
+
+  private:
+    static int parse_int_option(const std::string& option, const std::string& value, int min_value);
+  };
+
+}
+
+#endif
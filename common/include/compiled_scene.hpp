@@ -0,0 +1,128 @@
+#ifndef RENDER_COMPILED_SCENE_HPP
+#define RENDER_COMPILED_SCENE_HPP
+
+#include "baked_scene.hpp"
+#include "bvh.hpp"
+#include "config.hpp"
+#include "intersection_kernels.hpp"
+#include "mapped_file.hpp"
+#include "material.hpp"
+#include "primitive_arrays.hpp"
+#include "scene.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string>
+
+namespace render {
+
+  // Binary scene files written by render-scene-compile. A fixed header is
+  // followed by sections that each start on a cache line:
+  //
+  //   materials          one material_record per material_id
+  //   sphere columns     centers x, y, z and radii
+  //   sphere materials   material_id per sphere
+  //   cylinder columns   centers x, y, z, radii, axes x, y, z, unit axes x, y, z,
+  //                      top centers x, y, z, bottom centers x, y, z,
+  //                      half heights and squared radii
+  //   cylinder materials material_id per cylinder
+  //   bvh nodes          bvh_node records, if a BVH was stored
+  //   bvh indices        the BVH's primitive index list
+  //
+  // Columns are laid out exactly like scene_soa's: padded to a multiple of
+  // kernel_lane_padding with NaN entries, one after another. Everything is in
+  // the writer's byte order; files are not meant to move between machines,
+  // and the version number changes whenever the layout does.
+  inline constexpr std::uint32_t compiled_scene_version = 1;
+
+  enum class compiled_section : std::uint32_t {
+    materials,
+    sphere_columns,
+    sphere_materials,
+    cylinder_columns,
+    cylinder_materials,
+    bvh_nodes,
+    bvh_indices,
+    count
+  };
+
+  struct compiled_scene_header {
+    std::array<char, 8> magic;
+    std::uint32_t version;
+    // 0x01020304 as written, to reject files from a machine of other endianness.
+    std::uint32_t byte_order;
+    std::uint32_t ordering;
+    // Kind of the stored BVH; acceleration_type::none if there is none.
+    std::uint32_t acceleration;
+    // sizeof(bvh_node) of the writer, which depends on RENDER_PADDED_VECTOR.
+    std::uint32_t node_size;
+    std::uint32_t lane_padding;
+    std::uint64_t num_materials;
+    std::uint64_t num_spheres;
+    std::uint64_t num_cylinders;
+    std::uint64_t num_nodes;
+    std::uint64_t num_indices;
+    // Byte offset and size of every section, indexed by compiled_section.
+    std::array<std::array<std::uint64_t, 2>, static_cast<std::size_t>(compiled_section::count)> sections;
+  };
+
+  // Material parameters without the name, which only the text format needs.
+  struct material_record {
+    std::uint32_t type;
+    std::uint32_t reserved;
+    std::array<double, 4> values;
+  };
+
+  // True if the file starts like a compiled scene, whatever its version.
+  [[nodiscard]] bool is_compiled_scene(const std::string& filename);
+
+  // Writes the baked scene, and the BVH built over it if there is one, in the
+  // compiled format. config records how primitives were ordered and which
+  // kind of acceleration structure accel is.
+  void write_compiled_scene(const std::string& filename, const baked_scene& baked, const render_config& config, const std::optional<bvh>& accel);
+
+  // A compiled scene file mapped into memory. The column views point straight
+  // into the mapping, so opening costs only the header checks; pages are read
+  // (or shared with other processes through the page cache) as rendering
+  // touches them. Only the few materials are copied out.
+  class compiled_scene {
+  public:
+    [[nodiscard]] static compiled_scene open(const std::string& filename);
+
+    [[nodiscard]] const material_table& get_materials() const { return materials_; }
+    [[nodiscard]] std::size_t get_num_spheres() const { return header_.num_spheres; }
+    [[nodiscard]] std::size_t get_num_cylinders() const { return header_.num_cylinders; }
+    [[nodiscard]] primitive_order get_ordering() const { return static_cast<primitive_order>(header_.ordering); }
+
+    [[nodiscard]] sphere_lanes get_sphere_lanes() const;
+    [[nodiscard]] cylinder_lanes get_cylinder_lanes() const;
+    [[nodiscard]] std::span<const material_id> get_sphere_materials() const;
+    [[nodiscard]] std::span<const material_id> get_cylinder_materials() const;
+    [[nodiscard]] primitive_arrays get_primitive_arrays() const;
+
+    // The stored BVH as a view into the file if it is the kind config asks
+    // for, otherwise whatever build_acceleration builds over the columns.
+    [[nodiscard]] std::optional<bvh> load_acceleration(const render_config& config) const;
+
+    // Rebuilds a text-format scene, for renderers that need their own copy of
+    // the primitives. Materials are named after their ids.
+    [[nodiscard]] scene to_scene() const;
+
+  private:
+    compiled_scene(mapped_file file, const compiled_scene_header& header);
+
+    template <typename T>
+    [[nodiscard]] const T* section(compiled_section which) const;
+    [[nodiscard]] const double* column(compiled_section which, std::size_t index) const;
+
+    mapped_file file_;
+    compiled_scene_header header_;
+    material_table materials_;
+  };
+
+}
+
+#endif
@@ -3,11 +3,67 @@
 
 #include "vector.hpp"
 
+#include <optional>
 #include <string>
 #include <vector>
 
 namespace render {
 
+  enum class acceleration_type {
+    none,
+    bvh,
+    lbvh
+  };
+
+  // How paths are scheduled: one at a time, depth first (recursive), or all
+  // samples of a tile advanced bounce by bounce (wavefront, SOA only).
+  enum class render_engine {
+    recursive,
+    wavefront
+  };
+
+  // Scalar type of geometry, rays and path throughput (AOS renderer only).
+  // Pixel sums are always accumulated in double; on the example scenes float
+  // images stay above 55 dB PSNR against the double ones.
+  enum class render_precision {
+    single_precision,
+    double_precision
+  };
+
+  // How the renderer stores primitives: one record per primitive (AOS), one
+  // array per field (SOA), or fields interleaved in blocks of
+  // kernel_lane_padding primitives (AOSOA). The SOA renderer offers all three.
+  enum class memory_layout {
+    aos,
+    soa,
+    aosoa
+  };
+
+  // Order of the spheres and of the cylinders after parsing: as in the file,
+  // or sorted along a Morton or Hilbert curve through their centroids so that
+  // primitives close in space are close in memory.
+  enum class primitive_order {
+    file,
+    morton,
+    hilbert
+  };
+
+  // Output file format: ASCII or binary 8-bit PPM, or linear float PFM.
+  enum class image_format {
+    p3,
+    p6,
+    pfm
+  };
+
+  // Where the draws of each path come from: independent pseudo-random
+  // numbers, jittered strata spread over a pixel's samples_per_pixel samples,
+  // or an Owen-scrambled Sobol sequence over its samples (see random_stream).
+  enum class sampler_type {
+    independent,
+    stratified,
+    sobol
+  };
+
   struct render_config {
     int image_width = 800;
     int aspect_ratio_width = 16;
@@ -20,9 +76,32 @@ namespace render {
     double field_of_view = 90.0;
 
     int samples_per_pixel = 100;
+    // Above 0, pixels stop sampling once the 95% confidence interval of
+    // their mean luminance is within this fraction of it (see
+    // pixel_estimate), after at least adaptive_min_samples samples.
+    double adaptive_threshold = 0.0;
+    int adaptive_min_samples = 32;
     int max_depth = 50;
+    // Bounces before Russian roulette may end a path; 0 turns it off.
+    int russian_roulette_depth = 0;
     unsigned int material_rng_seed = 0;
     unsigned int ray_rng_seed = 0;
+    sampler_type sampler = sampler_type::independent;
+
+    int threads = 0;
+    int tile_size = 16;
+
+    acceleration_type acceleration = acceleration_type::bvh;
+    render_engine engine = render_engine::recursive;
+    render_precision precision = render_precision::double_precision;
+    // Unset: the renderer's own layout.
+    std::optional<memory_layout> layout;
+    primitive_order ordering = primitive_order::file;
+    // Unset: PFM for a .pfm output file, otherwise P3 as in earlier builds.
+    std::optional<image_format> output_format;
+    // Write tiles into the output file as they finish instead of keeping the
+    // image in memory (see image_output).
+    bool stream_output = false;
 
     vector background_dark_color{0.5, 0.7, 1.0};
     vector background_light_color{1.0, 1.0, 1.0};
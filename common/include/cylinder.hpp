@@ -1,21 +1,129 @@
 #ifndef RENDER_CYLINDER_HPP
 #define RENDER_CYLINDER_HPP
 
+#include "aabb.hpp"
 #include "material.hpp"
 #include "ray.hpp"
 #include "sphere.hpp"
 #include "vector.hpp"
 
 #include <cmath>
-#include <memory>
+#include <limits>
 #include <optional>
+#include <utility>
 
 namespace render {
 
+  // Surface of a cylinder a hit lies on.
+  enum class cylinder_part {
+    side,
+    top_cap,
+    bottom_cap
+  };
+
+  // The distance is kept in double whatever the precision of the frame that
+  // found it; widening a float distance is exact.
+  struct cylinder_part_hit {
+    double t;
+    cylinder_part part;
+  };
+
+  // Per-cylinder constants derived once from (center, radius, axis) instead
+  // of on every ray: unit axis, half-height, squared radius and cap centers.
+  template <typename T>
+  struct basic_cylinder_frame {
+    basic_vector<T> center;
+    basic_vector<T> unit_axis;
+    basic_vector<T> top_center;
+    basic_vector<T> bottom_center;
+    T half_height = 0;
+    T radius_squared = 0;
+
+    [[nodiscard]] static basic_cylinder_frame make(const basic_vector<T>& center, T radius, const basic_vector<T>& axis) {
+      basic_cylinder_frame frame;
+      frame.center = center;
+      frame.unit_axis = axis.normalize();
+      frame.half_height = axis.magnitude() / T{2};
+      frame.top_center = center + frame.unit_axis * frame.half_height;
+      frame.bottom_center = center - frame.unit_axis * frame.half_height;
+      frame.radius_squared = radius * radius;
+      return frame;
+    }
+
+    // Nearest surface with t_min < t < t_max, distance only. Surfaces are tested
+    // side, top cap, bottom cap, and an equal distance keeps the earlier one.
+    [[nodiscard]] std::optional<cylinder_part_hit> closest_part(const basic_ray<T>& r, T t_min, T t_max) const {
+      constexpr T epsilon = static_cast<T>(0.0001);
+      std::optional<cylinder_part_hit> best;
+      const auto consider = [&](T t, cylinder_part part) {
+        if (t > t_min && t < (best ? static_cast<T>(best->t) : t_max)) {
+          best = cylinder_part_hit{t, part};
+        }
+      };
+
+      const basic_vector<T> oc = r.get_origin() - center;
+      const basic_vector<T> dir = r.get_direction();
+
+      const basic_vector<T> dir_perp = dir - unit_axis * dir.dot(unit_axis);
+      const basic_vector<T> oc_perp = oc - unit_axis * oc.dot(unit_axis);
+
+      const T a = dir_perp.dot(dir_perp);
+      const T b = T{2} * dir_perp.dot(oc_perp);
+      const T c = oc_perp.dot(oc_perp) - radius_squared;
+      const T discriminant = b * b - T{4} * a * c;
+
+      if (discriminant >= T{0} && a > epsilon) {
+        const T sqrt_d = std::sqrt(discriminant);
+        const T t1 = (-b - sqrt_d) / (T{2} * a);
+        const T t2 = (-b + sqrt_d) / (T{2} * a);
+
+        for (T t : {t1, t2}) {
+          if (t > t_min && std::abs((r.point_at(t) - center).dot(unit_axis)) <= half_height) {
+            consider(t, cylinder_part::side);
+          }
+        }
+      }
+
+      const T dir_dot_axis = dir.dot(unit_axis);
+      if (std::abs(dir_dot_axis) > epsilon) {
+        for (const auto& [cap_center, part] : {std::pair{top_center, cylinder_part::top_cap}, std::pair{bottom_center, cylinder_part::bottom_cap}}) {
+          const T t = (cap_center - r.get_origin()).dot(unit_axis) / dir_dot_axis;
+          if (t > t_min && (r.point_at(t) - cap_center).magnitude_squared() <= radius_squared) {
+            consider(t, part);
+          }
+        }
+      }
+
+      return best;
+    }
+
+    // Finds which surface a known closest distance t belongs to, by repeating
+    // closest_part in the window that contains t alone.
+    [[nodiscard]] cylinder_part part_at(const basic_ray<T>& r, T t) const {
+      const auto hit = closest_part(r, std::nextafter(t, -std::numeric_limits<T>::infinity()), std::nextafter(t, std::numeric_limits<T>::infinity()));
+      return hit ? hit->part : cylinder_part::side;
+    }
+
+    [[nodiscard]] basic_vector<T> normal_at(cylinder_part part, const basic_vector<T>& point) const {
+      switch (part) {
+        case cylinder_part::top_cap:
+          return unit_axis;
+        case cylinder_part::bottom_cap:
+          return -unit_axis;
+        case cylinder_part::side:
+          break;
+      }
+      const basic_vector<T> to_point = point - center;
+      return (to_point - unit_axis * to_point.dot(unit_axis)).normalize();
+    }
+  };
+
+  using cylinder_frame = basic_cylinder_frame<double>;
+
   class cylinder {
   public:
-    cylinder(const vector& center, double radius, const vector& axis, std::shared_ptr<material> mat)
-      : center_{center}, radius_{radius}, axis_{axis}, material_{mat} {
+    cylinder(const vector& center, double radius, const vector& axis, material_id mat)
+      : center_{center}, radius_{radius}, axis_{axis}, frame_{cylinder_frame::make(center, radius, axis)}, material_{mat} {
       if (radius <= 0.0) {
         throw std::invalid_argument("Cylinder radius must be positive");
       }
@@ -24,84 +132,37 @@ namespace render {
     [[nodiscard]] const vector& get_center() const { return center_; }
     [[nodiscard]] double get_radius() const { return radius_; }
     [[nodiscard]] const vector& get_axis() const { return axis_; }
-    [[nodiscard]] std::shared_ptr<material> get_material() const { return material_; }
+    [[nodiscard]] const cylinder_frame& get_frame() const { return frame_; }
+    [[nodiscard]] material_id get_material() const { return material_; }
+    [[nodiscard]] aabb bounds() const { return make_cylinder_bounds(center_, radius_, axis_); }
+
+    // Distance to the nearest surface with t_min < t < t_max.
+    [[nodiscard]] std::optional<double> hit_distance(const ray& r, double t_min, double t_max) const {
+      const auto hit = frame_.closest_part(r, t_min, t_max);
+      return hit ? std::optional<double>{hit->t} : std::nullopt;
+    }
 
-    [[nodiscard]] std::optional<hit_info> intersect(const ray& r) const {
-      const vector axis_norm = axis_.normalize();
-      const double half_height = axis_.magnitude() / 2.0;
-      const vector top_center = center_ + axis_norm * half_height;
-      const vector bottom_center = center_ - axis_norm * half_height;
-
-      const vector oc = r.get_origin() - center_;
-      const vector dir = r.get_direction();
-      
-      const vector dir_perp = dir - axis_norm * dir.dot(axis_norm);
-      const vector oc_perp = oc - axis_norm * oc.dot(axis_norm);
-
-      const double a = dir_perp.dot(dir_perp);
-      const double b = 2.0 * dir_perp.dot(oc_perp);
-      const double c = oc_perp.dot(oc_perp) - radius_ * radius_;
-      const double discriminant = b * b - 4.0 * a * c;
-
-      std::optional<hit_info> best_hit;
-
-      if (discriminant >= 0.0 && a > 0.0001) {
-        const double sqrt_d = std::sqrt(discriminant);
-        const double t1 = (-b - sqrt_d) / (2.0 * a);
-        const double t2 = (-b + sqrt_d) / (2.0 * a);
-
-        for (double t : {t1, t2}) {
-          if (t > 0.0001) {
-            const vector point = r.point_at(t);
-            const vector to_point = point - center_;
-            const double projection = to_point.dot(axis_norm);
-            
-            if (std::abs(projection) <= half_height) {
-              const vector to_center = point - center_;
-              const vector axis_proj = axis_norm * projection;
-              const vector radial = to_center - axis_proj;
-              vector normal = radial.normalize();
-
-              if (!best_hit || t < best_hit->t) {
-                best_hit = hit_info{t, point, normal, material_};
-              }
-            }
-          }
-        }
-      }
+    // Attributes of the hit at distance t, as returned by hit_distance.
+    [[nodiscard]] hit_info surface_at(const ray& r, double t) const {
+      const vector point = r.point_at(t);
+      return hit_info{t, point, frame_.normal_at(frame_.part_at(r, t), point), material_};
+    }
 
-      const double dir_dot_axis = dir.dot(axis_norm);
-      if (std::abs(dir_dot_axis) > 0.0001) {
-        for (const vector& cap_center : {top_center, bottom_center}) {
-          const vector to_cap = cap_center - r.get_origin();
-          const double t = to_cap.dot(axis_norm) / dir_dot_axis;
-          
-          if (t > 0.0001) {
-            const vector point = r.point_at(t);
-            const double dist_sq = (point - cap_center).magnitude_squared();
-            
-            if (dist_sq <= radius_ * radius_) {
-              const bool is_top = (cap_center.get_x() == top_center.get_x() && 
-                                    cap_center.get_y() == top_center.get_y() && 
-                                    cap_center.get_z() == top_center.get_z());
-              const vector normal = is_top ? axis_norm : -axis_norm;
-              
-              if (!best_hit || t < best_hit->t) {
-                best_hit = hit_info{t, point, normal, material_};
-              }
-            }
-          }
-        }
+    [[nodiscard]] std::optional<hit_info> intersect(const ray& r) const {
+      const auto hit = frame_.closest_part(r, 0.0001, std::numeric_limits<double>::max());
+      if (!hit) {
+        return std::nullopt;
       }
-
-      return best_hit;
+      const vector point = r.point_at(hit->t);
+      return hit_info{hit->t, point, frame_.normal_at(hit->part, point), material_};
     }
 
   private:
     vector center_;
     double radius_;
     vector axis_;
-    std::shared_ptr<material> material_;
+    cylinder_frame frame_;
+    material_id material_;
   };
 
 }
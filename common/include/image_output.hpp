@@ -0,0 +1,60 @@
+#ifndef RENDER_IMAGE_OUTPUT_HPP
+#define RENDER_IMAGE_OUTPUT_HPP
+
+#include "config.hpp"
+#include "mapped_file.hpp"
+#include "renderer_utils.hpp"
+#include "tile_renderer.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <string>
+
+namespace render {
+
+  // Destination of finished tiles. By default they are gathered in a
+  // framebuffer that finish() writes out in the configured format.
+  //
+  // With config.stream_output the output file is created at its final size
+  // up front, header included, and mapped; every tile is encoded straight
+  // into it as it is stored. Once a whole row of tiles is in, its pages are
+  // handed back to the kernel, so memory stays bounded by the tile rows in
+  // flight however large the image is. Tiles stored before a crash are in
+  // the file, the rest are black. Only the fixed-size formats, P6 and PFM,
+  // can be streamed.
+  class image_output {
+  public:
+    image_output(const render_config& config, const std::string& filename, int width, int height);
+
+    // pixels holds the tile's colors, its (0, 0) at (t.x_begin, t.y_begin).
+    // Different tiles may be stored concurrently.
+    void store_tile(const tile& t, const framebuffer& pixels);
+    // Writes the in-memory image, or closes the streamed file.
+    void finish();
+
+  private:
+    void stream_tile(const tile& t, const framebuffer& pixels);
+    [[nodiscard]] std::size_t byte_offset(int x, int y) const;
+
+    std::string filename_;
+    image_format format_;
+    double gamma_;
+    int width_;
+    int height_;
+    int tile_size_;
+    std::optional<framebuffer> image_;
+
+    // Streaming only.
+    std::optional<mapped_output_file> file_;
+    std::optional<gamma_encoder> encoder_;
+    std::size_t header_size_ = 0;
+    std::size_t pixel_size_ = 0;
+    // Tiles still to come in each row of tiles.
+    std::unique_ptr<std::atomic<int>[]> tiles_left_;
+  };
+
+}
+
+#endif
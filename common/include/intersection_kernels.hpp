@@ -0,0 +1,95 @@
+#ifndef RENDER_INTERSECTION_KERNELS_HPP
+#define RENDER_INTERSECTION_KERNELS_HPP
+
+#include "ray.hpp"
+#include "ray_packet.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+
+namespace render {
+
+  // Primitive arrays are padded to a multiple of this many entries (one cache
+  // line of doubles), enough for full AVX-512 iterations without a remainder loop.
+  constexpr std::size_t kernel_lane_padding = 8;
+
+  // Closest hit found by a kernel: distance along the ray and primitive index.
+  struct primitive_hit {
+    double t;
+    std::uint32_t index;
+  };
+
+  // Structure-of-arrays sphere storage as seen by the kernels. Every pointer is
+  // 64-byte aligned and count is a multiple of kernel_lane_padding; padding
+  // entries have NaN centers so they can never be hit. Columns come in runs of
+  // kernel_lane_padding entries that start block_stride doubles apart, so
+  // primitive i sits at column[i / kernel_lane_padding * block_stride +
+  // i % kernel_lane_padding]: plain arrays use the default stride, blocked
+  // (AoSoA) storage the size of one block.
+  struct sphere_lanes {
+    const double* centers_x;
+    const double* centers_y;
+    const double* centers_z;
+    const double* radii;
+    std::size_t count;
+    std::size_t block_stride = kernel_lane_padding;
+  };
+
+  // Position of primitive i within the columns of sphere_lanes or cylinder_lanes.
+  template <typename Lanes>
+  [[nodiscard]] constexpr std::size_t column_offset(const Lanes& lanes, std::size_t i) {
+    return i / kernel_lane_padding * lanes.block_stride + i % kernel_lane_padding;
+  }
+
+  // Cylinders as precomputed frames (see cylinder_frame), with the same
+  // alignment and padding rules as sphere_lanes.
+  struct cylinder_lanes {
+    const double* centers_x;
+    const double* centers_y;
+    const double* centers_z;
+    const double* unit_axes_x;
+    const double* unit_axes_y;
+    const double* unit_axes_z;
+    const double* top_centers_x;
+    const double* top_centers_y;
+    const double* top_centers_z;
+    const double* bottom_centers_x;
+    const double* bottom_centers_y;
+    const double* bottom_centers_z;
+    const double* half_heights;
+    const double* radii_squared;
+    std::size_t count;
+    std::size_t block_stride = kernel_lane_padding;
+  };
+
+  // Nearest hit with t_min < t < t_max, testing several primitives per
+  // iteration with the AVX-512 or AVX2 variant picked at startup (see
+  // kernel_dispatch.hpp). Equal distances resolve to the lowest index,
+  // exactly as in the scalar versions.
+  [[nodiscard]] std::optional<primitive_hit> closest_sphere_hit(const sphere_lanes& spheres, const ray& r, double t_min, double t_max);
+  [[nodiscard]] std::optional<primitive_hit> closest_cylinder_hit(const cylinder_lanes& cylinders, const ray& r, double t_min, double t_max);
+
+  // One primitive at a time; reference for the SIMD paths and for benchmarks.
+  [[nodiscard]] std::optional<primitive_hit> closest_sphere_hit_scalar(const sphere_lanes& spheres, const ray& r, double t_min, double t_max);
+  [[nodiscard]] std::optional<primitive_hit> closest_cylinder_hit_scalar(const cylinder_lanes& cylinders, const ray& r, double t_min, double t_max);
+
+  // Distance to a single primitive with t_min < t < t_max, for BVH leaves.
+  [[nodiscard]] std::optional<double> sphere_hit_distance(const sphere_lanes& spheres, std::size_t index, const ray& r, double t_min, double t_max);
+  [[nodiscard]] std::optional<double> cylinder_hit_distance(const cylinder_lanes& cylinders, std::size_t index, const ray& r, double t_min, double t_max);
+
+  // Packet versions: test primitives [begin, end) against every active lane of
+  // the packet, lowering hits.t and setting hits.primitive to first_primitive
+  // plus the index wherever a primitive is the closest hit so far. Each ray
+  // gets exactly the distance the single-ray kernels compute.
+  void intersect_packet_spheres(const sphere_lanes& spheres, std::size_t begin, std::size_t end, std::uint32_t first_primitive,
+                                const ray_packet& packet, double t_min, packet_hits& hits);
+  void intersect_packet_cylinders(const cylinder_lanes& cylinders, std::size_t begin, std::size_t end, std::uint32_t first_primitive,
+                                  const ray_packet& packet, double t_min, packet_hits& hits);
+
+  // Instruction set the kernels currently run with: "avx512", "avx2" or "scalar".
+  [[nodiscard]] const char* intersection_kernel_isa();
+
+}
+
+#endif
@@ -0,0 +1,96 @@
+#ifndef RENDER_KERNEL_DISPATCH_HPP
+#define RENDER_KERNEL_DISPATCH_HPP
+
+#include "intersection_kernels.hpp"
+#include "ray_packet.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace render {
+
+  // Instruction sets the hot kernels are compiled for, lowest first.
+  enum class cpu_isa {
+    scalar,
+    avx2,
+    avx512
+  };
+
+  [[nodiscard]] const char* isa_name(cpu_isa isa);
+  // "scalar", "avx2" or "avx512"; nullopt for anything else.
+  [[nodiscard]] std::optional<cpu_isa> parse_isa(const std::string& name);
+
+  // Variants linked into this build that the running CPU can execute, lowest first.
+  [[nodiscard]] std::vector<cpu_isa> supported_isas();
+  // Best of supported_isas(), from CPUID.
+  [[nodiscard]] cpu_isa detect_cpu_isa();
+
+  // Switches every kernel to the given variant, or back to detect_cpu_isa()
+  // for nullopt. Meant for startup, before worker threads run; throws
+  // std::runtime_error if the CPU or build lacks the variant. Every variant
+  // rounds the same way, so the choice never changes an image.
+  void select_kernel_isa(std::optional<cpu_isa> isa);
+  [[nodiscard]] cpu_isa active_kernel_isa();
+
+  namespace kernels {
+
+    // Below this, a ray counts as parallel to a cylinder's sides or caps.
+    inline constexpr double parallel_epsilon = 0.0001;
+
+    // Ray as plain doubles, so variant translation units need no inline code
+    // from vector.hpp, which would otherwise be emitted with their -m flags.
+    struct flat_ray {
+      double origin[3];
+      double direction[3];
+    };
+
+    // Closest hit so far; index is negative while there is none.
+    struct flat_hit {
+      double t;
+      std::int64_t index;
+    };
+
+    // Tables of a gamma_encoder. A component clamped to [0, 1] starts at the
+    // level buckets[bits >> level_bucket_shift] and moves up one level, at
+    // most steps times, for every next threshold it is not below.
+    inline constexpr int level_bucket_shift = 16;
+
+    struct level_tables {
+      const std::uint8_t* buckets;
+      const float* thresholds;
+      int steps;
+    };
+
+    // Entry points of one variant. A null entry means the portable code is
+    // used for that kernel. The closest-hit scans cover whole registers only
+    // and return how many primitives they tested; the caller finishes the rest.
+    struct table {
+      cpu_isa isa;
+      std::size_t (*closest_spheres)(const sphere_lanes& spheres, const flat_ray& r, double t_min, flat_hit& best);
+      std::size_t (*closest_cylinders)(const cylinder_lanes& cylinders, const flat_ray& r, double t_min, flat_hit& best);
+      void (*packet_spheres)(const sphere_lanes& spheres, std::size_t begin, std::size_t end, std::uint32_t first_primitive,
+                             const ray_packet& packet, double t_min, packet_hits& hits);
+      void (*packet_cylinders)(const cylinder_lanes& cylinders, std::size_t begin, std::size_t end, std::uint32_t first_primitive,
+                               const ray_packet& packet, double t_min, packet_hits& hits);
+      // xoshiro256x4 step: state is the four lane-major words s0..s3 of four lanes each.
+      void (*random_fill)(std::uint64_t* state, std::uint64_t* out, std::size_t n);
+      // 8-bit levels of n linear components, as gamma_encoder::encode.
+      void (*encode_levels)(const level_tables& tables, const float* in, std::uint8_t* out, std::size_t n);
+    };
+
+    // Table of the variant chosen by select_kernel_isa, or detected on first use.
+    [[nodiscard]] const table& active();
+
+#if defined(RENDER_KERNEL_VARIANTS)
+    extern const table avx2_table;
+    extern const table avx512_table;
+#endif
+
+  }
+
+}
+
+#endif
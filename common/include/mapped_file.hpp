@@ -0,0 +1,77 @@
+#ifndef RENDER_MAPPED_FILE_HPP
+#define RENDER_MAPPED_FILE_HPP
+
+#include "aligned_allocator.hpp"
+
+#include <cstddef>
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace render {
+
+  // Read-only view of a whole file: memory-mapped where the platform supports
+  // it, read into memory otherwise. Either way the contents start on a cache
+  // line, and the view stays valid as long as the object (or whatever it was
+  // moved into) lives.
+  class mapped_file {
+  public:
+    // nullopt if the file cannot be opened or is not a regular file.
+    [[nodiscard]] static std::optional<mapped_file> open(const std::string& path);
+
+    mapped_file(const mapped_file&) = delete;
+    mapped_file& operator=(const mapped_file&) = delete;
+    mapped_file(mapped_file&& other) noexcept;
+    mapped_file& operator=(mapped_file&& other) noexcept;
+    ~mapped_file();
+
+    [[nodiscard]] std::string_view contents() const { return {data_, size_}; }
+
+  private:
+    mapped_file() = default;
+    void release() noexcept;
+
+    const char* data_ = nullptr;
+    std::size_t size_ = 0;
+    bool mapped_ = false;
+    aligned_vector<char> buffer_;
+  };
+
+  // A file created at a fixed size and mapped writable and shared. Stores go
+  // straight to the page cache, so they reach the file even if the process
+  // dies before closing it. Without mmap the contents are kept in memory and
+  // written out when the object is destroyed.
+  class mapped_output_file {
+  public:
+    // Creates or truncates the file. Throws std::runtime_error if it cannot
+    // be created or mapped.
+    [[nodiscard]] static mapped_output_file create(const std::string& path, std::size_t size);
+
+    mapped_output_file(const mapped_output_file&) = delete;
+    mapped_output_file& operator=(const mapped_output_file&) = delete;
+    mapped_output_file(mapped_output_file&& other) noexcept;
+    mapped_output_file& operator=(mapped_output_file&& other) noexcept;
+    ~mapped_output_file();
+
+    [[nodiscard]] char* data() { return data_; }
+    [[nodiscard]] std::size_t size() const { return size_; }
+
+    // Starts writing [offset, offset + size) back and drops its pages from
+    // the process, which is done with them; the contents stay in the file,
+    // and later stores to the range just fault the pages back in.
+    void release_range(std::size_t offset, std::size_t size);
+
+  private:
+    mapped_output_file() = default;
+    void release() noexcept;
+
+    char* data_ = nullptr;
+    std::size_t size_ = 0;
+    bool mapped_ = false;
+    std::string path_;
+    aligned_vector<char> buffer_;
+  };
+
+}
+
+#endif
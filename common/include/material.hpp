@@ -3,8 +3,10 @@
 
 #include "vector.hpp"
 
+#include <cstdint>
 #include <string>
 #include <memory>
+#include <vector>
 
 namespace render {
 
@@ -63,6 +65,52 @@ namespace render {
     double refraction_index_;
   };
 
+  // Position of a material in a material_table.
+  using material_id = std::uint32_t;
+
+  struct matte_params {
+    vector reflectance;
+  };
+
+  struct metal_params {
+    vector reflectance;
+    double diffusion;
+  };
+
+  // Refraction index plus the constants the scatter code derives from it:
+  // the index ratio entering the material and Schlick's normal reflectance r0.
+  struct refractive_params {
+    double refraction_index;
+    double inverse_index;
+    double r0;
+  };
+
+  // Flat material storage used while rendering. Materials are interned once
+  // into per-type parameter arrays, and hits carry a material_id, so shading
+  // is a switch on get_type() plus an array lookup: no reference counting and
+  // no RTTI in the hot path.
+  class material_table {
+  public:
+    material_id add(const material& mat);
+
+    [[nodiscard]] std::size_t size() const { return entries_.size(); }
+    [[nodiscard]] material_type get_type(material_id id) const { return entries_[id].type; }
+    [[nodiscard]] const matte_params& get_matte(material_id id) const { return matte_[entries_[id].slot]; }
+    [[nodiscard]] const metal_params& get_metal(material_id id) const { return metal_[entries_[id].slot]; }
+    [[nodiscard]] const refractive_params& get_refractive(material_id id) const { return refractive_[entries_[id].slot]; }
+
+  private:
+    struct entry {
+      material_type type;
+      std::uint32_t slot;
+    };
+
+    std::vector<entry> entries_;
+    std::vector<matte_params> matte_;
+    std::vector<metal_params> metal_;
+    std::vector<refractive_params> refractive_;
+  };
+
 }
 
 #endif
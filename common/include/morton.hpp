@@ -0,0 +1,91 @@
+#ifndef RENDER_MORTON_HPP
+#define RENDER_MORTON_HPP
+
+#include "aabb.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+
+namespace render {
+
+  // Spreads the low 10 bits of v so that two zero bits follow every bit.
+  [[nodiscard]] inline std::uint32_t expand_bits_10(std::uint32_t v) {
+    v &= 0x3FFU;
+    v = (v | (v << 16)) & 0x030000FFU;
+    v = (v | (v << 8)) & 0x0300F00FU;
+    v = (v | (v << 4)) & 0x030C30C3U;
+    v = (v | (v << 2)) & 0x09249249U;
+    return v;
+  }
+
+  // Spreads the low 21 bits of v so that two zero bits follow every bit.
+  [[nodiscard]] inline std::uint64_t expand_bits_21(std::uint64_t v) {
+    v &= 0x1FFFFFULL;
+    v = (v | (v << 32)) & 0x001F00000000FFFFULL;
+    v = (v | (v << 16)) & 0x001F0000FF0000FFULL;
+    v = (v | (v << 8)) & 0x100F00F00F00F00FULL;
+    v = (v | (v << 4)) & 0x10C30C30C30C30C3ULL;
+    v = (v | (v << 2)) & 0x1249249249249249ULL;
+    return v;
+  }
+
+  [[nodiscard]] inline std::uint32_t morton_encode_30(std::uint32_t x, std::uint32_t y, std::uint32_t z) {
+    return (expand_bits_10(x) << 2) | (expand_bits_10(y) << 1) | expand_bits_10(z);
+  }
+
+  [[nodiscard]] inline std::uint64_t morton_encode_63(std::uint64_t x, std::uint64_t y, std::uint64_t z) {
+    return (expand_bits_21(x) << 2) | (expand_bits_21(y) << 1) | expand_bits_21(z);
+  }
+
+  // Position of grid cell (x, y, z) along a 3D Hilbert curve through a grid
+  // of 2^bits cells per axis, for bits up to 21. Unlike the Morton order,
+  // consecutive cells on the curve always share a face. Skilling's transform
+  // ("Programming the Hilbert curve", 2004) turns the coordinates into the
+  // transposed index, whose bits then interleave like a Morton code.
+  [[nodiscard]] inline std::uint64_t hilbert_encode(std::uint64_t x, std::uint64_t y, std::uint64_t z, int bits) {
+    std::array<std::uint64_t, 3> v{x, y, z};
+    const std::uint64_t top = std::uint64_t{1} << (bits - 1);
+
+    for (std::uint64_t q = top; q > 1; q >>= 1) {
+      const std::uint64_t p = q - 1;
+      for (std::uint64_t& c : v) {
+        if ((c & q) != 0) {
+          v[0] ^= p;
+        } else {
+          const std::uint64_t t = (v[0] ^ c) & p;
+          v[0] ^= t;
+          c ^= t;
+        }
+      }
+    }
+
+    v[1] ^= v[0];
+    v[2] ^= v[1];
+    std::uint64_t t = 0;
+    for (std::uint64_t q = top; q > 1; q >>= 1) {
+      if ((v[2] & q) != 0) {
+        t ^= q - 1;
+      }
+    }
+    for (std::uint64_t& c : v) {
+      c ^= t;
+    }
+    return morton_encode_63(v[0], v[1], v[2]);
+  }
+
+  // Quantizes a point inside bounds to a grid of 2^bits cells per axis.
+  [[nodiscard]] inline std::array<std::uint64_t, 3> quantize(const std::array<double, 3>& point, const aabb& bounds, int bits) {
+    const double cells = static_cast<double>(std::uint64_t{1} << bits);
+    std::array<std::uint64_t, 3> q{};
+    for (size_t axis = 0; axis < 3; ++axis) {
+      const double extent = bounds.max[axis] - bounds.min[axis];
+      const double unit = extent > 0.0 ? (point[axis] - bounds.min[axis]) / extent : 0.0;
+      q[axis] = static_cast<std::uint64_t>(std::clamp(unit * cells, 0.0, cells - 1.0));
+    }
+    return q;
+  }
+
+}
+
+#endif
@@ -0,0 +1,55 @@
+#ifndef RENDER_PRIMITIVE_ARRAYS_HPP
+#define RENDER_PRIMITIVE_ARRAYS_HPP
+
+#include "aabb.hpp"
+#include "vector.hpp"
+
+#include <span>
+#include <vector>
+
+namespace render {
+
+  // Non-owning view of primitive geometry stored as separate coordinate arrays,
+  // so builders can read a structure-of-arrays scene without copying it.
+  // Primitive numbers run over the spheres first and then the cylinders.
+  struct primitive_arrays {
+    std::span<const double> sphere_centers_x;
+    std::span<const double> sphere_centers_y;
+    std::span<const double> sphere_centers_z;
+    std::span<const double> sphere_radii;
+
+    std::span<const double> cylinder_centers_x;
+    std::span<const double> cylinder_centers_y;
+    std::span<const double> cylinder_centers_z;
+    std::span<const double> cylinder_radii;
+    std::span<const double> cylinder_axes_x;
+    std::span<const double> cylinder_axes_y;
+    std::span<const double> cylinder_axes_z;
+
+    [[nodiscard]] size_t get_num_spheres() const { return sphere_radii.size(); }
+    [[nodiscard]] size_t get_num_cylinders() const { return cylinder_radii.size(); }
+    [[nodiscard]] size_t size() const { return get_num_spheres() + get_num_cylinders(); }
+
+    [[nodiscard]] aabb bounds(size_t prim) const {
+      if (prim < get_num_spheres()) {
+        return make_sphere_bounds(vector{sphere_centers_x[prim], sphere_centers_y[prim], sphere_centers_z[prim]}, sphere_radii[prim]);
+      }
+      const size_t i = prim - get_num_spheres();
+      return make_cylinder_bounds(vector{cylinder_centers_x[i], cylinder_centers_y[i], cylinder_centers_z[i]},
+                                  cylinder_radii[i],
+                                  vector{cylinder_axes_x[i], cylinder_axes_y[i], cylinder_axes_z[i]});
+    }
+
+    [[nodiscard]] std::vector<aabb> all_bounds() const {
+      std::vector<aabb> result;
+      result.reserve(size());
+      for (size_t prim = 0; prim < size(); ++prim) {
+        result.push_back(bounds(prim));
+      }
+      return result;
+    }
+  };
+
+}
+
+#endif
@@ -0,0 +1,19 @@
+#ifndef RENDER_RADIX_SORT_HPP
+#define RENDER_RADIX_SORT_HPP
+
+#include "thread_pool.hpp"
+
+#include <cstdint>
+#include <vector>
+
+namespace render {
+
+  // Stable LSD radix sort of keys (8-bit digits) that permutes values along with
+  // them. Each pass builds per-worker histograms and scatters in parallel;
+  // passes whose digit is the same for every key are skipped.
+  void radix_sort(std::vector<std::uint32_t>& keys, std::vector<std::uint32_t>& values, thread_pool& pool);
+  void radix_sort(std::vector<std::uint64_t>& keys, std::vector<std::uint32_t>& values, thread_pool& pool);
+
+}
+
+#endif
@@ -0,0 +1,151 @@
+#ifndef RENDER_RANDOM_HPP
+#define RENDER_RANDOM_HPP
+
+#include "config.hpp"
+#include "simd_random.hpp"
+
+#include <array>
+#include <cstdint>
+
+namespace render {
+
+  using philox_counter = std::array<std::uint32_t, 4>;
+  using philox_key = std::array<std::uint32_t, 2>;
+
+  // Philox4x32-10 (Salmon et al., "Parallel random numbers: as easy as 1, 2, 3").
+  // The output is a pure function of counter and key, so any draw can be
+  // recomputed independently of every other one.
+  [[nodiscard]] inline philox_counter philox4x32(philox_counter counter, philox_key key) {
+    constexpr std::uint32_t multiplier0 = 0xD2511F53U;
+    constexpr std::uint32_t multiplier1 = 0xCD9E8D57U;
+    constexpr std::uint32_t weyl0 = 0x9E3779B9U;
+    constexpr std::uint32_t weyl1 = 0xBB67AE85U;
+
+    for (int round = 0; round < 10; ++round) {
+      const std::uint64_t product0 = static_cast<std::uint64_t>(multiplier0) * counter[0];
+      const std::uint64_t product1 = static_cast<std::uint64_t>(multiplier1) * counter[2];
+      counter = philox_counter{
+        static_cast<std::uint32_t>(product1 >> 32) ^ counter[1] ^ key[0],
+        static_cast<std::uint32_t>(product1),
+        static_cast<std::uint32_t>(product0 >> 32) ^ counter[3] ^ key[1],
+        static_cast<std::uint32_t>(product0)
+      };
+      key[0] += weyl0;
+      key[1] += weyl1;
+    }
+    return counter;
+  }
+
+  // Maps 64 random bits to a double in [0, 1) using the top 53 bits.
+  [[nodiscard]] inline double to_unit_double(std::uint32_t high, std::uint32_t low) {
+    const std::uint64_t bits = (static_cast<std::uint64_t>(high) << 32) | low;
+    return static_cast<double>(bits >> 11) * 0x1.0p-53;
+  }
+
+  // Independent families of draws that may share a seed (ray_rng_seed and
+  // material_rng_seed both default to 0).
+  enum class random_domain : std::uint32_t {
+    camera = 0,
+    material = 1
+  };
+
+  // Which points a stream's draws come from (see random_stream).
+  struct sample_pattern {
+    sampler_type sampler = sampler_type::independent;
+    // Strata of the stratified sampler; sample indices must stay below it.
+    std::uint32_t samples_per_pixel = 1;
+  };
+
+  [[nodiscard]] inline sample_pattern sample_pattern_for(const render_config& config) {
+    return sample_pattern{config.sampler, static_cast<std::uint32_t>(config.samples_per_pixel)};
+  }
+
+  // Stream of uniform numbers for one (pixel, sample) path. Every value is
+  // addressed by (seed, pixel, sample, bounce, dimension), so pixels can be
+  // rendered in any order or on any thread with identical results.
+  //
+  // The first dimensions_per_bounce draws of bounce b are block b of a 4-lane
+  // xoshiro256+ stream keyed by Philox, generated in bulk when the bounce makes
+  // its first draw. Bounces are visited in order, so the blocks come out of the
+  // generator sequentially; jumping backwards replays it from the start. The
+  // rare draws past the block (long rejection loops) fall back to Philox.
+  //
+  // With a stratified or Sobol pattern, the first dimensions_per_bounce draws
+  // of a bounce are instead taken in pairs from a 2D point set over the
+  // pixel's samples: dimensions 2k and 2k+1 are the coordinates of point
+  // number `sample`. Every (domain, bounce, pair) has its own random
+  // scrambling of the set, so pairs are independent of each other while the
+  // samples of a pixel cover each pair's square evenly. Callers that want the
+  // benefit draw a fixed number of dimensions per bounce (no rejection loops).
+  class random_stream {
+  public:
+    static constexpr std::uint32_t dimensions_per_bounce = 16;
+
+    random_stream(unsigned int seed, std::uint64_t pixel, std::uint32_t sample, random_domain domain, sample_pattern pattern = {})
+      : key_{seed, static_cast<std::uint32_t>(pixel >> 32)},
+        pixel_{static_cast<std::uint32_t>(pixel)},
+        sample_{sample},
+        domain_bits_{static_cast<std::uint32_t>(domain) << 31},
+        pattern_{pattern},
+        pattern_seed_{pattern.sampler == sampler_type::independent ? 0U : scramble_seed(key_, pixel_, domain_bits_)} {}
+
+    // Starts the draws of a new bounce at dimension 0.
+    void set_bounce(std::uint32_t bounce) {
+      bounce_ = bounce;
+      dimension_ = 0;
+    }
+
+    [[nodiscard]] std::uint32_t get_bounce() const { return bounce_; }
+    [[nodiscard]] std::uint32_t get_dimension() const { return dimension_; }
+    [[nodiscard]] sampler_type get_sampler() const { return pattern_.sampler; }
+
+    // Next dimension of the current bounce, uniform in [0, 1).
+    [[nodiscard]] double uniform() {
+      const std::uint32_t dimension = dimension_++;
+      if (dimension < dimensions_per_bounce) {
+        if (pattern_.sampler != sampler_type::independent) {
+          return pattern_draw(dimension);
+        }
+        if (!has_block_ || block_bounce_ != bounce_) {
+          fill_block();
+        }
+        return block_[dimension];
+      }
+      return overflow(dimension);
+    }
+
+    [[nodiscard]] double uniform(double min, double max) {
+      return min + (max - min) * uniform();
+    }
+
+  private:
+    void fill_block();
+    [[nodiscard]] double overflow(std::uint32_t dimension) const;
+    [[nodiscard]] double pattern_draw(std::uint32_t dimension);
+    [[nodiscard]] std::array<double, 2> pattern_point(std::uint32_t pair) const;
+    [[nodiscard]] static std::uint32_t scramble_seed(const philox_key& key, std::uint32_t pixel, std::uint32_t domain_bits);
+
+    philox_key key_;
+    std::uint32_t pixel_;
+    std::uint32_t sample_;
+    std::uint32_t domain_bits_;
+    sample_pattern pattern_;
+    // Hash of seed, pixel and domain that pattern_point refines per pair.
+    std::uint32_t pattern_seed_;
+    // Second coordinate of the last pattern point, drawn next.
+    std::uint32_t paired_bounce_ = 0;
+    std::uint32_t paired_dimension_ = 0;
+    double paired_ = 0.0;
+    std::uint32_t bounce_ = 0;
+    std::uint32_t dimension_ = 0;
+
+    xoshiro256x4 generator_;
+    std::uint32_t generated_blocks_ = 0;
+    std::uint32_t block_bounce_ = 0;
+    bool has_block_ = false;
+    double block_[dimensions_per_bounce];
+  };
+
+}
+
+#endif
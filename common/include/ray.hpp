@@ -5,23 +5,29 @@
 
 namespace render {
 
-  class ray {
+  template <typename T>
+  class basic_ray {
   public:
-    ray(const vector& origin, const vector& direction)
+    basic_ray(const basic_vector<T>& origin, const basic_vector<T>& direction)
       : origin_{origin}, direction_{direction} {}
-
-    [[nodiscard]] const vector& get_origin() const { return origin_; }
-    [[nodiscard]] const vector& get_direction() const { return direction_; }
-    [[nodiscard]] vector point_at(double t) const {
-      return origin_ + direction_ * t;
+    // Rounds a ray of another precision, e.g. a camera ray for the float renderer.
+    template <typename U>
+    explicit basic_ray(const basic_ray<U>& other)
+      : origin_{other.get_origin()}, direction_{other.get_direction()} {}
+
+    [[nodiscard]] const basic_vector<T>& get_origin() const { return origin_; }
+    [[nodiscard]] const basic_vector<T>& get_direction() const { return direction_; }
+    [[nodiscard]] basic_vector<T> point_at(T t) const {
+      return origin_.add_scaled(direction_, t);
     }
 
   private:
-    vector origin_;
-    vector direction_;
+    basic_vector<T> origin_;
+    basic_vector<T> direction_;
   };
 
+  using ray = basic_ray<double>;
+
 }
 
 #endif
-
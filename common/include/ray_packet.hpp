@@ -0,0 +1,49 @@
+#ifndef RENDER_RAY_PACKET_HPP
+#define RENDER_RAY_PACKET_HPP
+
+#include "ray.hpp"
+
+#include <cstddef>
+#include <limits>
+
+namespace render {
+
+  // Up to capacity coherent rays (a run of neighbouring pixels) stored as lane
+  // arrays, so intersection kernels can load one coordinate of 4 or 8 rays at a
+  // time. Lanes at and beyond count are ignored.
+  struct ray_packet {
+    static constexpr std::size_t capacity = 16;
+
+    alignas(64) double origin_x[capacity]{};
+    alignas(64) double origin_y[capacity]{};
+    alignas(64) double origin_z[capacity]{};
+    alignas(64) double direction_x[capacity]{};
+    alignas(64) double direction_y[capacity]{};
+    alignas(64) double direction_z[capacity]{};
+    std::size_t count = 0;
+
+    [[nodiscard]] ray get_ray(std::size_t lane) const {
+      return ray{vector{origin_x[lane], origin_y[lane], origin_z[lane]},
+                 vector{direction_x[lane], direction_y[lane], direction_z[lane]}};
+    }
+  };
+
+  // Closest hit per packet lane: distance and primitive number (spheres first,
+  // then cylinders), with -1 for no hit. Both are doubles so kernels can blend
+  // them with the same masks.
+  struct packet_hits {
+    alignas(64) double t[ray_packet::capacity];
+    alignas(64) double primitive[ray_packet::capacity];
+
+    // Active lanes start at t_max; inactive ones at zero so nothing can hit them.
+    void reset(std::size_t count, double t_max) {
+      for (std::size_t lane = 0; lane < ray_packet::capacity; ++lane) {
+        t[lane] = lane < count ? t_max : 0.0;
+        primitive[lane] = -1.0;
+      }
+    }
+  };
+
+}
+
+#endif
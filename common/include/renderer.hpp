@@ -1,40 +1,313 @@
 #ifndef RENDER_RENDERER_HPP
 #define RENDER_RENDERER_HPP
 
+#include "baked_scene.hpp"
+#include "bvh.hpp"
 #include "config.hpp"
+#include "material.hpp"
+#include "random.hpp"
 #include "ray.hpp"
-#include "scene.hpp"
+#include "ray_packet.hpp"
+#include "renderer_utils.hpp"
+#include "scene_layout.hpp"
 #include "sphere.hpp"
 #include "vector.hpp"
 
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
 #include <optional>
-#include <random>
+#include <span>
+#include <type_traits>
 
 namespace render {
 
-  class renderer {
+  // Path tracer over any scene layout (see scene_layout.hpp). Geometry, rays
+  // and path throughput are in the layout's scalar type; the color of each
+  // path is handed back in double so that pixel accumulation never loses
+  // precision. Defined here so other layouts can instantiate it; the common
+  // ones are instantiated once in renderer.cpp.
+  template <typename Layout>
+  class layout_renderer {
   public:
-    renderer(const render_config& config, const scene& sc);
+    using scalar_type = typename Layout::scalar_type;
+    using layout_type = Layout;
 
-    [[nodiscard]] vector trace_ray(const ray& r, int depth, std::mt19937& ray_rng, std::mt19937& material_rng) const;
-    [[nodiscard]] std::optional<hit_info> find_closest_hit(const ray& r) const;
-    [[nodiscard]] vector get_background_color(const ray& r) const;
+    layout_renderer(const render_config& config, Layout layout, const std::optional<bvh>& accel);
+
+    [[nodiscard]] vector trace_ray(const ray& r, int depth, random_stream& rng) const;
+    // Distance and primitive of the nearest hit, without surface attributes.
+    [[nodiscard]] std::optional<ray_hit> find_closest_primitive(const basic_ray<scalar_type>& r) const;
+    [[nodiscard]] std::optional<basic_hit_info<scalar_type>> find_closest_hit(const basic_ray<scalar_type>& r) const;
+
+    // Primary rays as a packet: closest hits are found for all lanes together,
+    // then every lane continues with single-ray bounces using its own stream.
+    // colors[k] is what trace_ray(packet.get_ray(k), 0, rngs[k]) returns.
+    void trace_packet(const ray_packet& packet, std::span<random_stream> rngs, std::span<vector> colors) const;
+    void find_closest_hits(const ray_packet& packet, std::array<std::optional<basic_hit_info<scalar_type>>, ray_packet::capacity>& hits) const;
+    [[nodiscard]] basic_vector<scalar_type> get_background_color(const basic_ray<scalar_type>& r) const;
+
+    [[nodiscard]] const Layout& get_layout() const { return layout_; }
 
   private:
+    using T = scalar_type;
+
+    // The wavefront engine shares the intersection and scattering helpers.
+    template <typename>
+    friend class basic_wavefront_renderer;
+
+    // Distance, relative to the magnitude of the hit point, by which float
+    // rays are started off the surface. In float, |oc|^2 - r^2 for a point on
+    // a large sphere is only known to a few ulps of r^2, so without the offset
+    // grazing bounces hit their own surface again and darken it.
+    static constexpr float float_spawn_offset = 1e-4f;
+
     const render_config& config_;
-    const scene& scene_;
-
-    [[nodiscard]] vector scatter_matte(const ray& r, const hit_info& hit, int depth, std::mt19937& ray_rng, std::mt19937& material_rng) const;
-    [[nodiscard]] vector scatter_metal(const ray& r, const hit_info& hit, int depth, std::mt19937& ray_rng, std::mt19937& material_rng) const;
-    [[nodiscard]] vector scatter_refractive(const ray& r, const hit_info& hit, int depth, std::mt19937& ray_rng, std::mt19937& material_rng) const;
-    [[nodiscard]] vector random_in_unit_sphere(std::mt19937& material_rng) const;
-    [[nodiscard]] vector random_unit_vector(std::mt19937& material_rng) const;
-    [[nodiscard]] vector reflect(const vector& v, const vector& n) const;
-    [[nodiscard]] bool refract(const vector& v, const vector& n, double ni_over_nt, vector& refracted) const;
-    [[nodiscard]] double schlick(double cosine, double ref_idx) const;
+    const Layout layout_;
+    const std::optional<bvh>& accel_;
+    basic_vector<T> background_dark_color_;
+    basic_vector<T> background_light_color_;
+
+    // Radiance of a path whose ray r at the given depth has the given closest hit.
+    [[nodiscard]] basic_vector<T> shade(const basic_ray<T>& r, std::optional<basic_hit_info<T>> hit, int depth, random_stream& rng) const;
+    [[nodiscard]] static basic_ray<T> spawn_ray(const basic_ray<T>& scattered, const basic_vector<T>& normal);
+    [[nodiscard]] std::optional<basic_scatter_event<T>> scatter(const basic_ray<T>& r, const basic_hit_info<T>& hit, random_stream& rng) const;
+    [[nodiscard]] std::optional<basic_scatter_event<T>> scatter_matte(const basic_hit_info<T>& hit, random_stream& rng) const;
+    [[nodiscard]] std::optional<basic_scatter_event<T>> scatter_metal(const basic_ray<T>& r, const basic_hit_info<T>& hit, random_stream& rng) const;
+    [[nodiscard]] std::optional<basic_scatter_event<T>> scatter_refractive(const basic_ray<T>& r, const basic_hit_info<T>& hit, random_stream& rng) const;
+    [[nodiscard]] basic_vector<T> random_in_unit_sphere(random_stream& rng) const;
+    [[nodiscard]] basic_vector<T> random_unit_vector(random_stream& rng) const;
+    [[nodiscard]] basic_vector<T> reflect(const basic_vector<T>& v, const basic_vector<T>& n) const;
+    [[nodiscard]] bool refract(const basic_vector<T>& v, const basic_vector<T>& n, T ni_over_nt, basic_vector<T>& refracted) const;
+    [[nodiscard]] T schlick(T cosine, T r0) const;
   };
 
+  template <typename Layout>
+  layout_renderer<Layout>::layout_renderer(const render_config& config, Layout layout, const std::optional<bvh>& accel)
+    : config_{config}, layout_{layout}, accel_{accel},
+      background_dark_color_{config.background_dark_color}, background_light_color_{config.background_light_color} {}
+
+  template <typename Layout>
+  auto layout_renderer<Layout>::get_background_color(const basic_ray<T>& r) const -> basic_vector<T> {
+    const basic_vector<T> unit_direction = r.get_direction().normalize();
+    const T m = T{0.5} * (unit_direction.get_y() + T{1});
+    return background_light_color_ * (T{1} - m) + background_dark_color_ * m;
+  }
+
+  template <typename Layout>
+  std::optional<ray_hit> layout_renderer<Layout>::find_closest_primitive(const basic_ray<T>& r) const {
+    return layout_.find_closest_primitive(r, accel_);
+  }
+
+  template <typename Layout>
+  auto layout_renderer<Layout>::find_closest_hit(const basic_ray<T>& r) const -> std::optional<basic_hit_info<T>> {
+    // Point, normal and material are only worked out for the final winner.
+    const auto closest = find_closest_primitive(r);
+    return closest ? std::optional<basic_hit_info<T>>{layout_.surface_at(r, *closest)} : std::nullopt;
+  }
+
+  template <typename Layout>
+  void layout_renderer<Layout>::find_closest_hits(const ray_packet& packet,
+                                                  std::array<std::optional<basic_hit_info<T>>, ray_packet::capacity>& hits) const {
+    packet_ray_hits closest;
+    layout_.find_closest_primitives(packet, accel_, closest);
+    for (std::size_t k = 0; k < packet.count; ++k) {
+      hits[k].reset();
+      if (closest[k]) {
+        hits[k] = layout_.surface_at(basic_ray<T>{packet.get_ray(k)}, *closest[k]);
+      }
+    }
+  }
+
+  template <typename Layout>
+  void layout_renderer<Layout>::trace_packet(const ray_packet& packet, std::span<random_stream> rngs, std::span<vector> colors) const {
+    if (config_.max_depth <= 0) {
+      std::fill_n(colors.begin(), packet.count, vector{0.0, 0.0, 0.0});
+      return;
+    }
+
+    std::array<std::optional<basic_hit_info<T>>, ray_packet::capacity> hits;
+    find_closest_hits(packet, hits);
+    for (std::size_t k = 0; k < packet.count; ++k) {
+      colors[k] = vector{shade(basic_ray<T>{packet.get_ray(k)}, hits[k], 0, rngs[k])};
+    }
+  }
+
+  template <typename Layout>
+  vector layout_renderer<Layout>::trace_ray(const ray& r, int depth, random_stream& rng) const {
+    if (depth >= config_.max_depth) {
+      return vector{0.0, 0.0, 0.0};
+    }
+    const basic_ray<T> current{r};
+    return vector{shade(current, find_closest_hit(current), depth, rng)};
+  }
+
+  template <typename Layout>
+  auto layout_renderer<Layout>::shade(const basic_ray<T>& r, std::optional<basic_hit_info<T>> hit, int depth, random_stream& rng) const
+    -> basic_vector<T> {
+    // Iterative path loop: throughput holds the product of the attenuations so
+    // far, so the stack stays flat however deep the path goes.
+    basic_ray<T> current = r;
+    basic_vector<T> throughput{1, 1, 1};
+
+    while (hit) {
+      rng.set_bounce(static_cast<std::uint32_t>(depth));
+      const auto event = scatter(current, *hit, rng);
+      if (!event) {
+        return basic_vector<T>{0, 0, 0};
+      }
+      throughput = throughput.multiply(event->attenuation);
+      if (!continue_path(config_, depth, throughput, rng) || ++depth >= config_.max_depth) {
+        return basic_vector<T>{0, 0, 0};
+      }
+      current = spawn_ray(event->scattered, hit->normal);
+      hit = find_closest_hit(current);
+    }
+
+    return throughput.multiply(get_background_color(current));
+  }
+
+  // Scattered ray as it is traced next. Double rays are left alone, t_min is
+  // enough there; float rays are nudged off the surface on the side they
+  // leave towards.
+  template <typename Layout>
+  auto layout_renderer<Layout>::spawn_ray(const basic_ray<T>& scattered, const basic_vector<T>& normal) -> basic_ray<T> {
+    if constexpr (std::is_same_v<T, double>) {
+      static_cast<void>(normal);
+      return scattered;
+    } else {
+      const basic_vector<T>& p = scattered.get_origin();
+      const T scale = T{1} + std::max({std::abs(p.get_x()), std::abs(p.get_y()), std::abs(p.get_z())});
+      const T side = scattered.get_direction().dot(normal) > T{0} ? T{1} : T{-1};
+      return basic_ray<T>{p + normal * (side * scale * float_spawn_offset), scattered.get_direction()};
+    }
+  }
+
+  template <typename Layout>
+  auto layout_renderer<Layout>::random_in_unit_sphere(random_stream& rng) const -> basic_vector<T> {
+    // Rejection sampling would use a varying number of dimensions, which
+    // scrambles the pattern samplers' pairs; they map three draws instead.
+    if (rng.get_sampler() != sampler_type::independent) {
+      const double u = rng.uniform();
+      const double v = rng.uniform();
+      const double radius = std::cbrt(rng.uniform());
+      return basic_vector<T>{sphere_direction(u, v) * radius};
+    }
+    basic_vector<T> p;
+    do {
+      p = basic_vector<T>{vector{rng.uniform(-1.0, 1.0), rng.uniform(-1.0, 1.0), rng.uniform(-1.0, 1.0)}};
+    } while (p.magnitude_squared() >= T{1});
+    return p;
+  }
+
+  template <typename Layout>
+  auto layout_renderer<Layout>::random_unit_vector(random_stream& rng) const -> basic_vector<T> {
+    if (rng.get_sampler() != sampler_type::independent) {
+      const double u = rng.uniform();
+      const double v = rng.uniform();
+      return basic_vector<T>{sphere_direction(u, v)};
+    }
+    return random_in_unit_sphere(rng).normalize();
+  }
+
+  template <typename Layout>
+  auto layout_renderer<Layout>::reflect(const basic_vector<T>& v, const basic_vector<T>& n) const -> basic_vector<T> {
+    return v - n * (T{2} * v.dot(n));
+  }
+
+  template <typename Layout>
+  bool layout_renderer<Layout>::refract(const basic_vector<T>& v, const basic_vector<T>& n, T ni_over_nt, basic_vector<T>& refracted) const {
+    const basic_vector<T> uv = v.normalize();
+    const T dt = uv.dot(n);
+    const T discriminant = T{1} - ni_over_nt * ni_over_nt * (T{1} - dt * dt);
+
+    if (discriminant > T{0}) {
+      refracted = (uv - n * dt) * ni_over_nt - n * std::sqrt(discriminant);
+      return true;
+    }
+    return false;
+  }
+
+  template <typename Layout>
+  auto layout_renderer<Layout>::schlick(T cosine, T r0) const -> T {
+    return r0 + (T{1} - r0) * std::pow(T{1} - cosine, T{5});
+  }
+
+  template <typename Layout>
+  auto layout_renderer<Layout>::scatter_matte(const basic_hit_info<T>& hit, random_stream& rng) const
+    -> std::optional<basic_scatter_event<T>> {
+    const matte_params& mat = layout_.get_materials().get_matte(hit.mat);
+    const basic_vector<T> target = hit.point + hit.normal + random_unit_vector(rng);
+    return basic_scatter_event<T>{basic_ray<T>{hit.point, (target - hit.point).normalize()}, basic_vector<T>{mat.reflectance}};
+  }
+
+  template <typename Layout>
+  auto layout_renderer<Layout>::scatter_metal(const basic_ray<T>& r, const basic_hit_info<T>& hit, random_stream& rng) const
+    -> std::optional<basic_scatter_event<T>> {
+    const metal_params& mat = layout_.get_materials().get_metal(hit.mat);
+    const basic_vector<T> reflected = reflect(r.get_direction().normalize(), hit.normal);
+    const basic_vector<T> fuzz = random_in_unit_sphere(rng) * static_cast<T>(mat.diffusion);
+    const basic_ray<T> scattered{hit.point, (reflected + fuzz).normalize()};
+
+    // Scattered below the surface: the path is absorbed.
+    if (scattered.get_direction().dot(hit.normal) > T{0}) {
+      return basic_scatter_event<T>{scattered, basic_vector<T>{mat.reflectance}};
+    }
+    return std::nullopt;
+  }
+
+  template <typename Layout>
+  auto layout_renderer<Layout>::scatter_refractive(const basic_ray<T>& r, const basic_hit_info<T>& hit, random_stream& rng) const
+    -> std::optional<basic_scatter_event<T>> {
+    const refractive_params& mat = layout_.get_materials().get_refractive(hit.mat);
+    const auto r0 = static_cast<T>(mat.r0);
+
+    basic_vector<T> outward_normal;
+    T ni_over_nt;
+    const T cosine = r.get_direction().normalize().dot(hit.normal);
+
+    if (cosine > T{0}) {
+      outward_normal = -hit.normal;
+      ni_over_nt = static_cast<T>(mat.refraction_index);
+    } else {
+      outward_normal = hit.normal;
+      ni_over_nt = static_cast<T>(mat.inverse_index);
+    }
+
+    basic_vector<T> refracted;
+    const T reflect_prob = (cosine > T{0}) ?
+      schlick(cosine, r0) :
+      schlick(-cosine, r0);
+
+    const basic_vector<T> unit{1, 1, 1};
+    if (refract(r.get_direction().normalize(), outward_normal, ni_over_nt, refracted) && rng.uniform() > reflect_prob) {
+      return basic_scatter_event<T>{basic_ray<T>{hit.point, refracted}, unit};
+    }
+    return basic_scatter_event<T>{basic_ray<T>{hit.point, reflect(r.get_direction().normalize(), hit.normal)}, unit};
+  }
+
+  template <typename Layout>
+  auto layout_renderer<Layout>::scatter(const basic_ray<T>& r, const basic_hit_info<T>& hit, random_stream& rng) const
+    -> std::optional<basic_scatter_event<T>> {
+    switch (layout_.get_materials().get_type(hit.mat)) {
+      case material_type::matte:
+        return scatter_matte(hit, rng);
+      case material_type::metal:
+        return scatter_metal(r, hit, rng);
+      case material_type::refractive:
+        return scatter_refractive(r, hit, rng);
+    }
+    return std::nullopt;
+  }
+
+  extern template class layout_renderer<aos_layout<float>>;
+  extern template class layout_renderer<aos_layout<double>>;
+
+  template <typename T>
+  using basic_renderer = layout_renderer<aos_layout<T>>;
+  using renderer = basic_renderer<double>;
+
 }
 
 #endif
-
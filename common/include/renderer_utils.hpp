@@ -1,19 +1,178 @@
 #ifndef RENDER_RENDERER_UTILS_HPP
 #define RENDER_RENDERER_UTILS_HPP
 
+#include "aligned_allocator.hpp"
 #include "config.hpp"
+#include "random.hpp"
+#include "ray.hpp"
 #include "vector.hpp"
 
+#include <algorithm>
 #include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
 #include <vector>
 
 namespace render {
 
+  // Continuation of a path after a surface interaction: the scattered ray and
+  // the factor it applies to the path throughput.
+  template <typename T>
+  struct basic_scatter_event {
+    basic_ray<T> scattered;
+    basic_vector<T> attenuation;
+  };
+
+  using scatter_event = basic_scatter_event<double>;
+
+  // Whether a path continues after its bounce at depth (0 for the camera ray's
+  // hit). Paths with zero throughput stop. Once depth + 1 bounces reach
+  // config.russian_roulette_depth (0 disables it), a path survives with
+  // probability min(1, max component of throughput) and is divided by that
+  // probability, which keeps the estimate unbiased.
+  template <typename T>
+  [[nodiscard]] bool continue_path(const render_config& config, int depth, basic_vector<T>& throughput, random_stream& rng);
+
+  extern template bool continue_path(const render_config& config, int depth, basic_vector<float>& throughput, random_stream& rng);
+  extern template bool continue_path(const render_config& config, int depth, basic_vector<double>& throughput, random_stream& rng);
+
   [[nodiscard]] vector gamma_correct(const vector& color, double gamma);
   [[nodiscard]] vector clamp_color(const vector& color);
   [[nodiscard]] int color_to_int(double component);
 
-  void write_ppm(const std::string& filename, const std::vector<std::vector<vector>>& image, int width, int height);
+  // Point on the unit sphere for two uniform numbers in [0, 1), preserving
+  // their stratification: u picks the height, v the angle around the axis.
+  [[nodiscard]] vector sphere_direction(double u, double v);
+
+  // Relative luminance of a linear color (Rec. 709 weights).
+  [[nodiscard]] double luminance(const vector& color);
+
+  // Running estimate of one pixel: the sum of its samples, which gives the
+  // color, and Welford's running mean and sum of squared deviations of their
+  // luminance, which give the variance adaptive sampling stops on.
+  struct pixel_estimate {
+    vector sum{0.0, 0.0, 0.0};
+    int count = 0;
+    double luminance_mean = 0.0;
+    double luminance_m2 = 0.0;
+
+    void add(const vector& sample);
+    [[nodiscard]] vector mean() const { return sum / static_cast<double>(count); }
+
+    // Whether the pixel takes another sample: never at samples_per_pixel,
+    // always without adaptive sampling or below adaptive_min_samples, and
+    // otherwise while the 95% confidence interval of the mean luminance is
+    // wider than adaptive_threshold times that mean. Means below
+    // adaptive_luminance_floor count as the floor, so that nearly black
+    // pixels, whose noise is large relative to their mean but invisible, do
+    // not all run to samples_per_pixel.
+    [[nodiscard]] bool needs_sample(const render_config& config) const;
+  };
+
+  inline constexpr double adaptive_luminance_floor = 0.01;
+
+  // Samples taken by every pixel of an image, as a 16-bit PGM whose white is
+  // samples_per_pixel.
+  class sample_count_image {
+  public:
+    sample_count_image(int width, int height, int samples_per_pixel);
+
+    void set_count(int i, int j, int count) {
+      counts_[static_cast<std::size_t>(height_ - 1 - j) * static_cast<std::size_t>(width_) + static_cast<std::size_t>(i)] =
+        static_cast<std::uint16_t>(std::min(count, static_cast<int>(max_value_)));
+    }
+
+    void write(const std::string& filename) const;
+
+  private:
+    int width_;
+    int height_;
+    std::uint16_t max_value_;
+    // Top row first, as PGM stores them.
+    std::vector<std::uint16_t> counts_;
+  };
+
+  // Linear pixel colors, three floats per pixel in one cache-line aligned
+  // block. Rows run from the bottom of the image (j = 0, the camera's v = 0)
+  // up, which is PFM's scanline order, so write_pfm writes the block as is.
+  class framebuffer {
+  public:
+    framebuffer(int width, int height);
+
+    [[nodiscard]] int get_width() const { return width_; }
+    [[nodiscard]] int get_height() const { return height_; }
+
+    void set_pixel(int i, int j, const vector& color) {
+      float* p = components_.data() + component_index(i, j);
+      p[0] = static_cast<float>(color.get_x());
+      p[1] = static_cast<float>(color.get_y());
+      p[2] = static_cast<float>(color.get_z());
+    }
+
+    [[nodiscard]] vector get_pixel(int i, int j) const {
+      const float* p = components_.data() + component_index(i, j);
+      return vector{p[0], p[1], p[2]};
+    }
+
+    [[nodiscard]] std::span<const float> get_row(int j) const {
+      return std::span<const float>{components_}.subspan(component_index(0, j), static_cast<std::size_t>(width_) * 3);
+    }
+    [[nodiscard]] std::span<const float> get_components() const { return components_; }
+
+    // Copies block over the pixels from (x, y) on.
+    void set_block(int x, int y, const framebuffer& block);
+
+  private:
+    [[nodiscard]] std::size_t component_index(int i, int j) const {
+      return (static_cast<std::size_t>(j) * static_cast<std::size_t>(width_) + static_cast<std::size_t>(i)) * 3;
+    }
+
+    int width_;
+    int height_;
+    aligned_vector<float> components_;
+  };
+
+  // Maps linear components to 8-bit levels exactly as gamma_correct,
+  // clamp_color and color_to_int do, without a pow per component. A clamped
+  // component's top 16 bits pick a bucket spanning 1/128 of its octave; a
+  // table holds the level at each bucket's start, and a compare or two with
+  // the smallest components of the next levels finish the job. Whole buffers
+  // go through the widest kernel variant the CPU supports. Negative
+  // components encode as 0.
+  class gamma_encoder {
+  public:
+    explicit gamma_encoder(double gamma);
+
+    void encode(const float* components, std::uint8_t* levels, std::size_t n) const;
+
+  private:
+    double gamma_;
+    // False if 1 / gamma is negative or NaN, where the levels do not grow
+    // with the component and every component goes through pow instead.
+    bool monotonic_;
+    // Level of the first float of every bucket, padded for 4-byte gathers.
+    aligned_vector<std::uint8_t> buckets_;
+    // thresholds_[k]: smallest component encoded as level k or above. The
+    // entry past 255 is NaN, which no component reaches.
+    aligned_vector<float> thresholds_;
+    // Most levels a bucket spans beyond its first.
+    int steps_ = 0;
+  };
+
+  // The configured output_format, or else the one the file name suggests.
+  [[nodiscard]] image_format output_format_for(const render_config& config, const std::string& filename);
+
+  // File header of an image in the given format, up to the first pixel.
+  [[nodiscard]] std::string image_header(image_format format, int width, int height);
+
+  // Each writer prepares all pixel data in memory and writes it in one call.
+  // The PPM formats store gamma-encoded levels, PFM the linear colors.
+  void write_ppm_ascii(const std::string& filename, const framebuffer& image, double gamma);
+  void write_ppm(const std::string& filename, const framebuffer& image, double gamma);
+  void write_pfm(const std::string& filename, const framebuffer& image);
+  void write_image(const std::string& filename, const framebuffer& image, image_format format, double gamma);
 
 }
 
@@ -1,40 +1,121 @@
 #ifndef RENDER_SCENE_HPP
 #define RENDER_SCENE_HPP
 
+#include "aabb.hpp"
+#include "config.hpp"
 #include "cylinder.hpp"
 #include "material.hpp"
 #include "sphere.hpp"
+#include "vector.hpp"
 
-#include <map>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
 #include <memory>
+#include <optional>
+#include <span>
 #include <string>
+#include <string_view>
+#include <unordered_map>
 #include <vector>
 
 namespace render {
 
-  class scene {
+  // Where scene_parser delivers a scene, so each renderer can build the
+  // storage it renders from without an intermediate copy. reserve() comes
+  // first with the number of primitives that follow, then the materials in
+  // file order, then the primitives. Ids returned by add_material are what
+  // the primitives refer to.
+  class scene_builder {
   public:
-    void add_material(std::shared_ptr<material> mat);
+    virtual ~scene_builder() = default;
+
+    // Room for this many more primitives of each kind.
+    virtual void reserve(std::size_t num_spheres, std::size_t num_cylinders) = 0;
+    virtual material_id add_material(const material& mat) = 0;
+    virtual void add_sphere(const vector& center, double radius, material_id mat) = 0;
+    virtual void add_cylinder(const vector& center, double radius, const vector& axis, material_id mat) = 0;
+  };
+
+  class scene : public scene_builder {
+  public:
+    // Interns the material; names must be unique.
+    material_id add_material(const material& mat) override;
     void add_sphere(std::shared_ptr<sphere> sph);
     void add_cylinder(std::shared_ptr<cylinder> cyl);
+    void add_sphere(const vector& center, double radius, material_id mat) override;
+    void add_cylinder(const vector& center, double radius, const vector& axis, material_id mat) override;
+    void reserve(std::size_t num_spheres, std::size_t num_cylinders) override;
 
-    [[nodiscard]] std::shared_ptr<material> get_material(const std::string& name) const;
+    [[nodiscard]] std::optional<material_id> get_material(std::string_view name) const;
+    [[nodiscard]] const material_table& get_materials() const { return materials_; }
     [[nodiscard]] const std::vector<std::shared_ptr<sphere>>& get_spheres() const { return spheres_; }
     [[nodiscard]] const std::vector<std::shared_ptr<cylinder>>& get_cylinders() const { return cylinders_; }
+    [[nodiscard]] std::size_t get_num_spheres() const { return spheres_.size(); }
+    [[nodiscard]] std::size_t get_num_cylinders() const { return cylinders_.size(); }
+
+    // Bounds of every primitive, spheres first and then cylinders; the position
+    // in this list is the primitive number used by acceleration structures.
+    [[nodiscard]] std::vector<aabb> get_primitive_bounds() const;
+
+    // Sorts the spheres, and separately the cylinders, by the position of
+    // their bounds' centroids along the given curve; ties keep file order.
+    // Everything built from the scene afterwards inherits the order.
+    void reorder(primitive_order order);
 
   private:
-    std::map<std::string, std::shared_ptr<material>> materials_;
+    // Looks names up as string_view without building a std::string first.
+    struct name_hash {
+      using is_transparent = void;
+      std::size_t operator()(std::string_view name) const { return std::hash<std::string_view>{}(name); }
+    };
+
+    std::unordered_map<std::string, material_id, name_hash, std::equal_to<>> material_ids_;
+    material_table materials_;
     std::vector<std::shared_ptr<sphere>> spheres_;
     std::vector<std::shared_ptr<cylinder>> cylinders_;
   };
 
+  // New position to old index, per kind, for sorting primitives along a
+  // curve; see scene::reorder.
+  struct primitive_permutation {
+    std::vector<std::uint32_t> spheres;
+    std::vector<std::uint32_t> cylinders;
+  };
+
+  // Order of primitives with the given bounds (spheres first, then
+  // cylinders) by the position of their centroids along the curve.
+  [[nodiscard]] primitive_permutation curve_order(std::span<const aabb> bounds, std::size_t num_spheres, primitive_order order);
+
+  void log_reorder(std::size_t num_primitives, primitive_order order, double milliseconds);
+
+  // sc.reorder(order) for a scene or any other layout that can sort itself,
+  // logging the curve and the time taken. Does nothing for
+  // primitive_order::file.
+  template <typename Scene>
+  void reorder_scene(Scene& sc, primitive_order order) {
+    if (order == primitive_order::file) {
+      return;
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    sc.reorder(order);
+    const auto stop = std::chrono::steady_clock::now();
+    log_reorder(sc.get_num_spheres() + sc.get_num_cylinders(), order, std::chrono::duration<double, std::milli>(stop - start).count());
+  }
+
   class scene_parser {
   public:
-    [[nodiscard]] static scene parse(const std::string& filename);
-
-  private:
-    static std::vector<std::string> split_line(const std::string& line);
-    static bool is_whitespace(const std::string& line);
+    // Maps the file and parses it in line-aligned chunks on up to `threads`
+    // threads (0 means all hardware threads; small files use one). The scene
+    // and any error are the same as a line-by-line read would produce: the
+    // error reported is the one on the earliest offending line.
+    [[nodiscard]] static scene parse(const std::string& filename, int threads = 0);
+    // Same, delivering the scene to a builder. The primitive counts passed
+    // to reserve() come from the chunks' first pass over the text. After an
+    // error the builder may hold part of the scene.
+    static void parse(const std::string& filename, scene_builder& builder, int threads = 0);
   };
 
 }
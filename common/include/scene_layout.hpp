@@ -0,0 +1,59 @@
+#ifndef RENDER_SCENE_LAYOUT_HPP
+#define RENDER_SCENE_LAYOUT_HPP
+
+#include "baked_scene.hpp"
+#include "bvh.hpp"
+#include "material.hpp"
+#include "ray.hpp"
+#include "ray_packet.hpp"
+#include "sphere.hpp"
+
+#include <array>
+#include <optional>
+
+namespace render {
+
+  // Closest primitive per packet lane, as a layout reports it.
+  using packet_ray_hits = std::array<std::optional<ray_hit>, ray_packet::capacity>;
+
+  // A scene layout is how layout_renderer (renderer.hpp) sees the geometry.
+  // It is a small copyable view over scene storage owned elsewhere and
+  // provides:
+  //
+  //   scalar_type                  precision of geometry and rays
+  //   get_materials()              the scene's material_table
+  //   find_closest_primitive(r, accel)
+  //                                nearest hit of a ray, through the BVH if
+  //                                there is one, without surface attributes
+  //   find_closest_primitives(packet, accel, hits)
+  //                                the same for every lane of a ray packet
+  //   surface_at(r, hit)           point, normal and material of a hit
+  //
+  // The renderer owns everything else, so shading is written once for every
+  // layout and images only differ between layouts if their arithmetic does.
+
+  // Array of structures: the baked scene's records, one primitive at a time.
+  template <typename T>
+  class aos_layout {
+  public:
+    using scalar_type = T;
+
+    // Not explicit, so a renderer can be built straight from a baked scene.
+    aos_layout(const basic_baked_scene<T>& sc) : scene_{&sc} {}
+
+    [[nodiscard]] const material_table& get_materials() const { return scene_->get_materials(); }
+    [[nodiscard]] std::optional<ray_hit> find_closest_primitive(const basic_ray<T>& r, const std::optional<bvh>& accel) const;
+    // One ray after another; the records have no lanes to share.
+    void find_closest_primitives(const ray_packet& packet, const std::optional<bvh>& accel, packet_ray_hits& hits) const;
+    [[nodiscard]] basic_hit_info<T> surface_at(const basic_ray<T>& r, const ray_hit& hit) const;
+
+  private:
+    const basic_baked_scene<T>* scene_;
+  };
+
+  extern template class aos_layout<float>;
+  extern template class aos_layout<double>;
+
+}
+
+#endif
@@ -0,0 +1,111 @@
+#ifndef RENDER_SIMD_LANES_HPP
+#define RENDER_SIMD_LANES_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <immintrin.h>
+
+// Each kernel variant translation unit defines RENDER_SIMD_AVX512 or
+// RENDER_SIMD_AVX2 before including this header and is compiled with the
+// matching -m flag; see kernel_dispatch.hpp.
+#if defined(RENDER_SIMD_AVX512) && !defined(__AVX512F__)
+#error "RENDER_SIMD_AVX512 needs a translation unit compiled with -mavx512f"
+#elif defined(RENDER_SIMD_AVX2) && !defined(__AVX2__)
+#error "RENDER_SIMD_AVX2 needs a translation unit compiled with -mavx2"
+#elif !defined(RENDER_SIMD_AVX512) && !defined(RENDER_SIMD_AVX2)
+#error "Define RENDER_SIMD_AVX512 or RENDER_SIMD_AVX2 before including simd_lanes.hpp"
+#endif
+
+// Thin wrappers over a register of double lanes so the intersection kernels
+// are written once and compile to AVX-512 (8 lanes) or AVX2 (4 lanes). All
+// comparisons are ordered: any NaN operand yields false. The inline namespace
+// keeps the variants' symbols apart when several are linked into one binary.
+namespace render::simd {
+
+#if defined(RENDER_SIMD_AVX512)
+  inline namespace avx512 {
+
+  // sqrt, min, max and store_truncated use zero-masked forms: same results,
+  // but they avoid GCC's uninitialized-pass-through warning.
+  constexpr std::size_t lanes = 8;
+  constexpr const char* isa_name = "avx512";
+
+  struct vdouble {
+    __m512d v;
+  };
+  using vmask = __mmask8;
+
+  inline vdouble broadcast(double v) { return {_mm512_set1_pd(v)}; }
+  inline vdouble load(const double* p) { return {_mm512_load_pd(p)}; }
+  inline void store(double* p, vdouble v) { _mm512_store_pd(p, v.v); }
+  inline vdouble load_unaligned(const double* p) { return {_mm512_loadu_pd(p)}; }
+  // Truncates each lane toward zero, as static_cast<std::int32_t> does.
+  inline void store_truncated(std::int32_t* p, vdouble v) { _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), _mm512_maskz_cvttpd_epi32(0xFF, v.v)); }
+  inline vdouble lane_offsets() { return {_mm512_set_pd(7.0, 6.0, 5.0, 4.0, 3.0, 2.0, 1.0, 0.0)}; }
+
+  inline vdouble operator+(vdouble a, vdouble b) { return {_mm512_add_pd(a.v, b.v)}; }
+  inline vdouble operator-(vdouble a, vdouble b) { return {_mm512_sub_pd(a.v, b.v)}; }
+  inline vdouble operator*(vdouble a, vdouble b) { return {_mm512_mul_pd(a.v, b.v)}; }
+  inline vdouble operator/(vdouble a, vdouble b) { return {_mm512_div_pd(a.v, b.v)}; }
+  inline vdouble sqrt(vdouble v) { return {_mm512_maskz_sqrt_pd(0xFF, v.v)}; }
+  inline vdouble abs(vdouble v) { return {_mm512_abs_pd(v.v)}; }
+  // a < b ? a : b and a > b ? a : b, so std::min(b, a) and std::max(b, a) round alike.
+  inline vdouble min(vdouble a, vdouble b) { return {_mm512_maskz_min_pd(0xFF, a.v, b.v)}; }
+  inline vdouble max(vdouble a, vdouble b) { return {_mm512_maskz_max_pd(0xFF, a.v, b.v)}; }
+
+  inline vmask greater(vdouble a, vdouble b) { return _mm512_cmp_pd_mask(a.v, b.v, _CMP_GT_OQ); }
+  inline vmask greater_equal(vdouble a, vdouble b) { return _mm512_cmp_pd_mask(a.v, b.v, _CMP_GE_OQ); }
+  inline vmask less(vdouble a, vdouble b) { return _mm512_cmp_pd_mask(a.v, b.v, _CMP_LT_OQ); }
+  inline vmask less_equal(vdouble a, vdouble b) { return _mm512_cmp_pd_mask(a.v, b.v, _CMP_LE_OQ); }
+  inline vmask both(vmask a, vmask b) { return a & b; }
+  inline bool none(vmask m) { return m == 0; }
+
+  // Lanes of if_true where m is set, of if_false elsewhere.
+  inline vdouble select(vmask m, vdouble if_true, vdouble if_false) { return {_mm512_mask_blend_pd(m, if_false.v, if_true.v)}; }
+
+  }
+#else
+  inline namespace avx2 {
+
+  constexpr std::size_t lanes = 4;
+  constexpr const char* isa_name = "avx2";
+
+  struct vdouble {
+    __m256d v;
+  };
+  using vmask = __m256d;
+
+  inline vdouble broadcast(double v) { return {_mm256_set1_pd(v)}; }
+  inline vdouble load(const double* p) { return {_mm256_load_pd(p)}; }
+  inline void store(double* p, vdouble v) { _mm256_store_pd(p, v.v); }
+  inline vdouble load_unaligned(const double* p) { return {_mm256_loadu_pd(p)}; }
+  // Truncates each lane toward zero, as static_cast<std::int32_t> does.
+  inline void store_truncated(std::int32_t* p, vdouble v) { _mm_storeu_si128(reinterpret_cast<__m128i*>(p), _mm256_cvttpd_epi32(v.v)); }
+  inline vdouble lane_offsets() { return {_mm256_set_pd(3.0, 2.0, 1.0, 0.0)}; }
+
+  inline vdouble operator+(vdouble a, vdouble b) { return {_mm256_add_pd(a.v, b.v)}; }
+  inline vdouble operator-(vdouble a, vdouble b) { return {_mm256_sub_pd(a.v, b.v)}; }
+  inline vdouble operator*(vdouble a, vdouble b) { return {_mm256_mul_pd(a.v, b.v)}; }
+  inline vdouble operator/(vdouble a, vdouble b) { return {_mm256_div_pd(a.v, b.v)}; }
+  inline vdouble sqrt(vdouble v) { return {_mm256_sqrt_pd(v.v)}; }
+  inline vdouble abs(vdouble v) { return {_mm256_andnot_pd(_mm256_set1_pd(-0.0), v.v)}; }
+  // a < b ? a : b and a > b ? a : b, so std::min(b, a) and std::max(b, a) round alike.
+  inline vdouble min(vdouble a, vdouble b) { return {_mm256_min_pd(a.v, b.v)}; }
+  inline vdouble max(vdouble a, vdouble b) { return {_mm256_max_pd(a.v, b.v)}; }
+
+  inline vmask greater(vdouble a, vdouble b) { return _mm256_cmp_pd(a.v, b.v, _CMP_GT_OQ); }
+  inline vmask greater_equal(vdouble a, vdouble b) { return _mm256_cmp_pd(a.v, b.v, _CMP_GE_OQ); }
+  inline vmask less(vdouble a, vdouble b) { return _mm256_cmp_pd(a.v, b.v, _CMP_LT_OQ); }
+  inline vmask less_equal(vdouble a, vdouble b) { return _mm256_cmp_pd(a.v, b.v, _CMP_LE_OQ); }
+  inline vmask both(vmask a, vmask b) { return _mm256_and_pd(a, b); }
+  inline bool none(vmask m) { return _mm256_movemask_pd(m) == 0; }
+
+  // Lanes of if_true where m is set, of if_false elsewhere.
+  inline vdouble select(vmask m, vdouble if_true, vdouble if_false) { return {_mm256_blendv_pd(if_false.v, if_true.v, m)}; }
+
+  }
+#endif
+
+}
+
+#endif
@@ -0,0 +1,55 @@
+#ifndef RENDER_SIMD_RANDOM_HPP
+#define RENDER_SIMD_RANDOM_HPP
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+
+namespace render {
+
+  // Four interleaved xoshiro256+ generators (Blackman & Vigna). The state is
+  // stored lane-major so one step of all lanes is a handful of 256-bit integer
+  // operations; CPUs with AVX2 run an intrinsics variant (see
+  // kernel_dispatch.hpp), others a loop the compiler can vectorize with SSE2.
+  class xoshiro256x4 {
+  public:
+    static constexpr std::size_t lanes = 4;
+
+    xoshiro256x4() = default;
+    explicit xoshiro256x4(std::uint64_t seed) { reseed(seed, 0); }
+
+    // Expands (seed, stream) with splitmix64 into four non-zero lane states.
+    void reseed(std::uint64_t seed, std::uint64_t stream);
+
+    // Writes n raw 64-bit outputs, lane-interleaved.
+    void fill(std::uint64_t* out, std::size_t n);
+    // Writes n uniform values in [0, 1) built from the high mantissa bits.
+    void fill_uniform(double* out, std::size_t n);
+    void fill_uniform(float* out, std::size_t n);
+
+  private:
+    // Words s0..s3 of every lane, one row per word.
+    alignas(32) std::uint64_t s_[4][lanes]{};
+  };
+
+  [[nodiscard]] inline std::uint64_t splitmix64(std::uint64_t& state) {
+    std::uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+  }
+
+  // Bit-trick conversions: place the top bits in the mantissa of a number in
+  // [1, 2) and subtract one. Cheaper than an integer-to-float conversion and
+  // exact, at the cost of one bit of resolution.
+  [[nodiscard]] inline double bits_to_unit_double(std::uint64_t bits) {
+    return std::bit_cast<double>((bits >> 12) | 0x3FF0000000000000ULL) - 1.0;
+  }
+
+  [[nodiscard]] inline float bits_to_unit_float(std::uint32_t bits) {
+    return std::bit_cast<float>((bits >> 9) | 0x3F800000U) - 1.0F;
+  }
+
+}
+
+#endif
@@ -1,25 +1,44 @@
 #ifndef RENDER_SPHERE_HPP
 #define RENDER_SPHERE_HPP
 
+#include "aabb.hpp"
 #include "material.hpp"
 #include "ray.hpp"
 #include "vector.hpp"
 
-#include <memory>
+#include <cstdint>
+#include <limits>
 #include <optional>
+#include <stdexcept>
 
 namespace render {
 
-  struct hit_info {
+  enum class primitive_kind : std::uint32_t {
+    sphere,
+    cylinder
+  };
+
+  // Result of a closest-hit search before any surface attributes are computed:
+  // the distance and which primitive was hit.
+  struct ray_hit {
     double t;
-    vector point;
-    vector normal;
-    std::shared_ptr<material> mat;
+    primitive_kind kind;
+    std::uint32_t index;
   };
 
+  template <typename T>
+  struct basic_hit_info {
+    T t;
+    basic_vector<T> point;
+    basic_vector<T> normal;
+    material_id mat;
+  };
+
+  using hit_info = basic_hit_info<double>;
+
   class sphere {
   public:
-    sphere(const vector& center, double radius, std::shared_ptr<material> mat)
+    sphere(const vector& center, double radius, material_id mat)
       : center_{center}, radius_{radius}, material_{mat} {
       if (radius <= 0.0) {
         throw std::invalid_argument("Sphere radius must be positive");
@@ -28,9 +47,11 @@ namespace render {
 
     [[nodiscard]] const vector& get_center() const { return center_; }
     [[nodiscard]] double get_radius() const { return radius_; }
-    [[nodiscard]] std::shared_ptr<material> get_material() const { return material_; }
+    [[nodiscard]] material_id get_material() const { return material_; }
+    [[nodiscard]] aabb bounds() const { return make_sphere_bounds(center_, radius_); }
 
-    [[nodiscard]] std::optional<hit_info> intersect(const ray& r) const {
+    // Distance to the nearest intersection with t_min < t < t_max.
+    [[nodiscard]] std::optional<double> hit_distance(const ray& r, double t_min, double t_max) const {
       const vector oc = r.get_origin() - center_;
       const double a = r.get_direction().dot(r.get_direction());
       const double b = 2.0 * oc.dot(r.get_direction());
@@ -45,22 +66,29 @@ namespace render {
       const double t1 = (-b - sqrt_d) / (2.0 * a);
       const double t2 = (-b + sqrt_d) / (2.0 * a);
 
-      double t = (t1 > 0.0001) ? t1 : ((t2 > 0.0001) ? t2 : -1.0);
+      double t = (t1 > t_min) ? t1 : ((t2 > t_min) ? t2 : -1.0);
 
-      if (t < 0.0001) {
+      if (t <= t_min || t >= t_max) {
         return std::nullopt;
       }
+      return t;
+    }
 
+    // Attributes of the hit at distance t, as returned by hit_distance.
+    [[nodiscard]] hit_info surface_at(const ray& r, double t) const {
       const vector point = r.point_at(t);
-      vector normal = (point - center_).normalize();
+      return hit_info{t, point, (point - center_).normalize(), material_};
+    }
 
-      return hit_info{t, point, normal, material_};
+    [[nodiscard]] std::optional<hit_info> intersect(const ray& r) const {
+      const auto t = hit_distance(r, 0.0001, std::numeric_limits<double>::max());
+      return t ? std::optional<hit_info>{surface_at(r, *t)} : std::nullopt;
     }
 
   private:
     vector center_;
     double radius_;
-    std::shared_ptr<material> material_;
+    material_id material_;
   };
 
 }
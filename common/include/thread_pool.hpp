@@ -0,0 +1,57 @@
+#ifndef RENDER_THREAD_POOL_HPP
+#define RENDER_THREAD_POOL_HPP
+
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace render {
+
+  // Fixed set of worker threads that all run the same task. The calling thread
+  // takes part as worker 0, so a pool of size 1 spawns no threads at all.
+  class thread_pool {
+  public:
+    explicit thread_pool(int num_threads);
+    ~thread_pool();
+
+    thread_pool(const thread_pool&) = delete;
+    thread_pool& operator=(const thread_pool&) = delete;
+
+    // Runs task(worker_index) once on every worker and blocks until all of them
+    // return. The first exception thrown by any worker is rethrown here.
+    void run(const std::function<void(int)>& task);
+
+    // Splits [0, count) into one contiguous chunk per worker, in worker order,
+    // and runs body(begin, end, worker) on each. The split only depends on
+    // count and the pool size, so two calls see the same chunks.
+    void parallel_for(size_t count, const std::function<void(size_t, size_t, int)>& body);
+
+    [[nodiscard]] int size() const { return num_threads_; }
+
+    // Maps a configured thread count to a usable one (0 means all hardware threads).
+    [[nodiscard]] static int resolve_thread_count(int requested);
+
+  private:
+    void worker_loop(int index);
+    void execute(int index);
+
+    int num_threads_;
+    std::vector<std::thread> workers_;
+
+    std::mutex mutex_;
+    std::condition_variable start_cv_;
+    std::condition_variable done_cv_;
+    const std::function<void(int)>* task_ = nullptr;
+    std::size_t generation_ = 0;
+    int pending_ = 0;
+    bool stopping_ = false;
+    std::exception_ptr error_;
+  };
+
+}
+
+#endif
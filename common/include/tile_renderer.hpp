@@ -0,0 +1,74 @@
+#ifndef RENDER_TILE_RENDERER_HPP
+#define RENDER_TILE_RENDERER_HPP
+
+#include "config.hpp"
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+namespace render {
+
+  // Rectangular block of pixels [x_begin, x_end) x [y_begin, y_end). The index is
+  // the tile's position in row-major tile order and never depends on scheduling,
+  // so it can be used to seed per-tile random streams.
+  struct tile {
+    int index;
+    int x_begin;
+    int x_end;
+    int y_begin;
+    int y_end;
+  };
+
+  // The tiles of a width x height image in row-major order, computed on
+  // demand so that huge images need no tile list.
+  class tile_grid {
+  public:
+    tile_grid(int width, int height, int tile_size);
+
+    [[nodiscard]] int get_tile_size() const { return tile_size_; }
+    [[nodiscard]] int get_columns() const { return columns_; }
+    [[nodiscard]] std::size_t size() const { return static_cast<std::size_t>(columns_) * static_cast<std::size_t>(rows_); }
+    [[nodiscard]] tile at(std::size_t index) const;
+
+  private:
+    int width_;
+    int height_;
+    int tile_size_;
+    int columns_;
+    int rows_;
+  };
+
+  [[nodiscard]] std::vector<tile> make_tiles(int width, int height, int tile_size);
+
+  // Work-stealing tile queue: every worker owns a contiguous run of tiles,
+  // takes from its front and steals from the back of the others. A run is
+  // just a range of tile indices, so the queue's size does not depend on the
+  // number of tiles.
+  class tile_queue {
+  public:
+    tile_queue(const tile_grid& grid, int num_workers);
+
+    [[nodiscard]] std::optional<tile> pop(int worker);
+
+  private:
+    struct worker_run {
+      std::mutex mutex;
+      std::size_t begin = 0;
+      std::size_t end = 0;
+    };
+
+    tile_grid grid_;
+    std::vector<std::unique_ptr<worker_run>> runs_;
+  };
+
+  // Splits the image into tiles and calls shade_tile for each of them on a pool of
+  // config.threads workers. Every tile is shaded exactly once.
+  void render_tiles(const render_config& config, int width, int height, const std::function<void(const tile&)>& shade_tile);
+
+}
+
+#endif
@@ -1,41 +1,139 @@
 #ifndef RENDER_VECTOR_HPP
 #define RENDER_VECTOR_HPP
 
+#include <array>
 #include <cmath>
+#include <cstddef>
 
 namespace render {
 
-  class vector {
+  // With RENDER_PADDED_VECTOR the three components are followed by a padding
+  // lane that no result depends on and the vector is aligned to its size, so
+  // component-wise operations compile to single SSE or AVX instructions.
+#if defined(RENDER_PADDED_VECTOR)
+  inline constexpr std::size_t vector_lanes = 4;
+#else
+  inline constexpr std::size_t vector_lanes = 3;
+#endif
+
+  // Three-component vector over a scalar type; the renderers use double by
+  // default and float when the config asks for single precision. Header-only
+  // so every operation inlines into the intersection and shading loops.
+  template <typename T>
+  class basic_vector {
   public:
-    vector(double cx, double cy, double cz) : x{cx}, y{cy}, z{cz} {}
-    vector() : x{0.0}, y{0.0}, z{0.0} {}
-
-    [[nodiscard]] double magnitude() const;
-    [[nodiscard]] double magnitude_squared() const;
-    [[nodiscard]] vector normalize() const;
-    [[nodiscard]] double dot(const vector& other) const;
-    [[nodiscard]] vector cross(const vector& other) const;
-    
-    [[nodiscard]] double get_x() const { return x; }
-    [[nodiscard]] double get_y() const { return y; }
-    [[nodiscard]] double get_z() const { return z; }
-
-    vector operator+(const vector& other) const;
-    vector operator-(const vector& other) const;
-    vector operator*(double scalar) const;
-    vector operator/(double scalar) const;
-    vector operator-() const;
-    
-    vector& operator+=(const vector& other);
-    vector& operator-=(const vector& other);
-    vector& operator*=(double scalar);
-    vector& operator/=(double scalar);
+    using scalar_type = T;
+
+    constexpr basic_vector(T cx, T cy, T cz) : v_{make(cx, cy, cz)} {}
+    constexpr basic_vector() : v_{} {}
+    // Component-wise conversion from another precision.
+    template <typename U>
+    constexpr explicit basic_vector(const basic_vector<U>& other)
+      : v_{make(static_cast<T>(other.get_x()), static_cast<T>(other.get_y()), static_cast<T>(other.get_z()))} {}
+
+    [[nodiscard]] T magnitude() const { return std::sqrt(magnitude_squared()); }
+    [[nodiscard]] constexpr T magnitude_squared() const { return dot(*this); }
+
+    [[nodiscard]] basic_vector normalize() const {
+      const T mag = magnitude();
+      if (mag == T{0}) {
+        return basic_vector{};
+      }
+      return *this / mag;
+    }
+
+    // Summed x, y, z in that order, never the padding lane.
+    [[nodiscard]] constexpr T dot(const basic_vector& other) const {
+      return v_[0] * other.v_[0] + v_[1] * other.v_[1] + v_[2] * other.v_[2];
+    }
+
+    [[nodiscard]] constexpr basic_vector cross(const basic_vector& other) const {
+      return basic_vector{
+        v_[1] * other.v_[2] - v_[2] * other.v_[1],
+        v_[2] * other.v_[0] - v_[0] * other.v_[2],
+        v_[0] * other.v_[1] - v_[1] * other.v_[0]
+      };
+    }
+
+    // Component-wise product, e.g. a path throughput times an attenuation.
+    [[nodiscard]] constexpr basic_vector multiply(const basic_vector& other) const {
+      basic_vector result;
+      for (std::size_t i = 0; i < vector_lanes; ++i) {
+        result.v_[i] = v_[i] * other.v_[i];
+      }
+      return result;
+    }
+
+    // *this + other * scalar, rounded as the two separate operations would be.
+    [[nodiscard]] constexpr basic_vector add_scaled(const basic_vector& other, T scalar) const {
+      basic_vector result;
+      for (std::size_t i = 0; i < vector_lanes; ++i) {
+        result.v_[i] = v_[i] + other.v_[i] * scalar;
+      }
+      return result;
+    }
+
+    [[nodiscard]] constexpr T get_x() const { return v_[0]; }
+    [[nodiscard]] constexpr T get_y() const { return v_[1]; }
+    [[nodiscard]] constexpr T get_z() const { return v_[2]; }
+
+    constexpr basic_vector operator+(const basic_vector& other) const { return basic_vector{*this} += other; }
+    constexpr basic_vector operator-(const basic_vector& other) const { return basic_vector{*this} -= other; }
+    constexpr basic_vector operator*(T scalar) const { return basic_vector{*this} *= scalar; }
+    constexpr basic_vector operator/(T scalar) const { return basic_vector{*this} /= scalar; }
+    constexpr basic_vector operator-() const {
+      basic_vector result;
+      for (std::size_t i = 0; i < vector_lanes; ++i) {
+        result.v_[i] = -v_[i];
+      }
+      return result;
+    }
+
+    constexpr basic_vector& operator+=(const basic_vector& other) {
+      for (std::size_t i = 0; i < vector_lanes; ++i) {
+        v_[i] += other.v_[i];
+      }
+      return *this;
+    }
+
+    constexpr basic_vector& operator-=(const basic_vector& other) {
+      for (std::size_t i = 0; i < vector_lanes; ++i) {
+        v_[i] -= other.v_[i];
+      }
+      return *this;
+    }
+
+    constexpr basic_vector& operator*=(T scalar) {
+      for (std::size_t i = 0; i < vector_lanes; ++i) {
+        v_[i] *= scalar;
+      }
+      return *this;
+    }
+
+    constexpr basic_vector& operator/=(T scalar) {
+      for (std::size_t i = 0; i < vector_lanes; ++i) {
+        v_[i] /= scalar;
+      }
+      return *this;
+    }
+
+    friend constexpr basic_vector operator*(T scalar, const basic_vector& v) { return v * scalar; }
 
   private:
-    double x, y, z;
+    using storage = std::array<T, vector_lanes>;
+
+    static constexpr storage make(T cx, T cy, T cz) {
+      storage v{};
+      v[0] = cx;
+      v[1] = cy;
+      v[2] = cz;
+      return v;
+    }
+
+    alignas(vector_lanes == 4 ? 4 * sizeof(T) : alignof(T)) storage v_;
   };
 
-  vector operator*(double scalar, const vector& v);
+  using vector = basic_vector<double>;
 
 }
 
@@ -0,0 +1,102 @@
+#include "baked_scene.hpp"
+
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <type_traits>
+
+namespace render {
+
+  namespace {
+
+    static_assert(std::is_trivially_destructible_v<basic_baked_sphere<float>>);
+    static_assert(std::is_trivially_destructible_v<basic_baked_sphere<double>>);
+    static_assert(std::is_trivially_destructible_v<basic_baked_cylinder<float>>);
+    static_assert(std::is_trivially_destructible_v<basic_baked_cylinder<double>>);
+    static_assert(std::is_trivially_destructible_v<aabb>);
+
+    constexpr std::size_t round_up_to_line(std::size_t bytes) {
+      return (bytes + cache_line_size - 1) / cache_line_size * cache_line_size;
+    }
+
+    template <typename T>
+    std::span<const T> section(const aligned_vector<std::byte>& block, std::size_t offset, std::size_t count) {
+      if (count == 0) {
+        return {};
+      }
+      return {std::launder(reinterpret_cast<const T*>(block.data() + offset)), count};
+    }
+
+  }
+
+  template <typename T>
+  basic_baked_scene<T>::basic_baked_scene(const scene& sc)
+    : materials_{sc.get_materials()},
+      num_spheres_{sc.get_spheres().size()},
+      num_cylinders_{sc.get_cylinders().size()} {
+    cylinders_offset_ = round_up_to_line(num_spheres_ * sizeof(basic_baked_sphere<T>));
+    bounds_offset_ = cylinders_offset_ + round_up_to_line(num_cylinders_ * sizeof(basic_baked_cylinder<T>));
+    block_.resize(bounds_offset_ + round_up_to_line((num_spheres_ + num_cylinders_) * sizeof(aabb)));
+
+    // Records are constructed in place; being trivially destructible, they go
+    // away with the block.
+    std::byte* base = block_.data();
+    auto* spheres = reinterpret_cast<basic_baked_sphere<T>*>(base);
+    auto* cylinders = reinterpret_cast<basic_baked_cylinder<T>*>(base + cylinders_offset_);
+    auto* bounds = reinterpret_cast<aabb*>(base + bounds_offset_);
+
+    // Bounds come from the rounded values, so they enclose what is traced.
+    for (std::size_t i = 0; i < num_spheres_; ++i) {
+      const sphere& sph = *sc.get_spheres()[i];
+      const basic_vector<T> center{sph.get_center()};
+      const auto radius = static_cast<T>(sph.get_radius());
+      std::construct_at(spheres + i, basic_baked_sphere<T>{center, radius, radius * radius, sph.get_material()});
+      std::construct_at(bounds + i, make_sphere_bounds(vector{center}, static_cast<double>(radius)));
+    }
+    for (std::size_t i = 0; i < num_cylinders_; ++i) {
+      const cylinder& cyl = *sc.get_cylinders()[i];
+      const basic_vector<T> center{cyl.get_center()};
+      const basic_vector<T> axis{cyl.get_axis()};
+      const auto radius = static_cast<T>(cyl.get_radius());
+      const auto frame = basic_cylinder_frame<T>::make(center, radius, axis);
+      std::construct_at(cylinders + i, basic_baked_cylinder<T>{frame, axis, radius, cyl.get_material()});
+      std::construct_at(bounds + num_spheres_ + i, make_cylinder_bounds(vector{center}, static_cast<double>(radius), vector{axis}));
+    }
+  }
+
+  template <typename T>
+  std::span<const basic_baked_sphere<T>> basic_baked_scene<T>::get_spheres() const {
+    return section<basic_baked_sphere<T>>(block_, 0, num_spheres_);
+  }
+
+  template <typename T>
+  std::span<const basic_baked_cylinder<T>> basic_baked_scene<T>::get_cylinders() const {
+    return section<basic_baked_cylinder<T>>(block_, cylinders_offset_, num_cylinders_);
+  }
+
+  template <typename T>
+  std::span<const aabb> basic_baked_scene<T>::get_primitive_bounds() const {
+    return section<aabb>(block_, bounds_offset_, num_spheres_ + num_cylinders_);
+  }
+
+  template <typename T>
+  basic_baked_scene<T> bake_scene(const scene& sc) {
+    const auto start = std::chrono::steady_clock::now();
+    basic_baked_scene<T> baked{sc};
+    const auto stop = std::chrono::steady_clock::now();
+
+    std::cout << "Baked " << baked.get_spheres().size() << " spheres and " << baked.get_cylinders().size() << " cylinders"
+              << (std::is_same_v<T, float> ? " (single precision)" : "") << ": "
+              << baked.get_memory_bytes() << " bytes, "
+              << std::chrono::duration<double, std::milli>(stop - start).count() << " ms\n";
+    return baked;
+  }
+
+  template class basic_baked_scene<float>;
+  template class basic_baked_scene<double>;
+
+  template basic_baked_scene<float> bake_scene<float>(const scene& sc);
+  template basic_baked_scene<double> bake_scene<double>(const scene& sc);
+
+}
@@ -0,0 +1,435 @@
+#include "bvh.hpp"
+
+#include "morton.hpp"
+#include "radix_sort.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <limits>
+#include <stdexcept>
+#include <string>
+
+namespace render {
+
+  namespace {
+
+    constexpr size_t bin_count = 16;
+    constexpr std::uint32_t max_leaf_size = 4;
+    constexpr double traversal_cost = 1.0;
+    constexpr double intersection_cost = 1.0;
+    // Beyond this depth splits fall back to object medians, which bounds the
+    // tree depth (and the traversal stack) for any input.
+    constexpr int max_sah_depth = 32;
+
+    struct sah_builder {
+      std::span<const aabb> bounds;
+      std::vector<std::array<double, 3>> centroids;
+      std::vector<std::uint32_t>& indices;
+      std::vector<bvh_node>& nodes;
+
+      struct bin {
+        aabb bounds;
+        std::uint32_t count = 0;
+      };
+
+      struct split {
+        double cost = std::numeric_limits<double>::infinity();
+        size_t axis = 0;
+        size_t bin = 0;
+      };
+
+      [[nodiscard]] static size_t bin_of(double centroid, double min, double extent) {
+        const auto b = static_cast<size_t>(static_cast<double>(bin_count) * (centroid - min) / extent);
+        return std::min(b, bin_count - 1);
+      }
+
+      [[nodiscard]] split find_split(std::uint32_t begin, std::uint32_t end, const aabb& centroid_bounds, double node_area) const {
+        split best;
+        for (size_t axis = 0; axis < 3; ++axis) {
+          const double min = centroid_bounds.min[axis];
+          const double extent = centroid_bounds.max[axis] - min;
+          if (extent <= 0.0) {
+            continue;
+          }
+
+          std::array<bin, bin_count> bins{};
+          for (std::uint32_t i = begin; i < end; ++i) {
+            const std::uint32_t prim = indices[i];
+            bin& b = bins[bin_of(centroids[prim][axis], min, extent)];
+            b.bounds.expand(bounds[prim]);
+            ++b.count;
+          }
+
+          // Sweep from the right to get the cost of every right-hand side, then
+          // from the left to combine it with the matching left-hand side.
+          std::array<double, bin_count> right_cost{};
+          aabb right_bounds;
+          std::uint32_t right_count = 0;
+          for (size_t b = bin_count - 1; b > 0; --b) {
+            right_bounds.expand(bins[b].bounds);
+            right_count += bins[b].count;
+            right_cost[b] = right_bounds.surface_area() * static_cast<double>(right_count);
+          }
+
+          aabb left_bounds;
+          std::uint32_t left_count = 0;
+          for (size_t b = 0; b + 1 < bin_count; ++b) {
+            left_bounds.expand(bins[b].bounds);
+            left_count += bins[b].count;
+            if (left_count == 0 || left_count == end - begin) {
+              continue;
+            }
+            const double cost = traversal_cost +
+              intersection_cost * (left_bounds.surface_area() * static_cast<double>(left_count) + right_cost[b + 1]) / node_area;
+            if (cost < best.cost) {
+              best = split{cost, axis, b};
+            }
+          }
+        }
+        return best;
+      }
+
+      std::uint32_t build(std::uint32_t begin, std::uint32_t end, int depth) {
+        const auto node_index = static_cast<std::uint32_t>(nodes.size());
+        nodes.emplace_back();
+
+        aabb node_bounds;
+        aabb centroid_bounds;
+        for (std::uint32_t i = begin; i < end; ++i) {
+          node_bounds.expand(bounds[indices[i]]);
+          centroid_bounds.expand(centroids[indices[i]]);
+        }
+        nodes[node_index].bounds = node_bounds;
+
+        const std::uint32_t count = end - begin;
+        const auto make_leaf = [&] {
+          nodes[node_index].offset = begin;
+          nodes[node_index].count = count;
+          return node_index;
+        };
+
+        if (count == 1) {
+          return make_leaf();
+        }
+
+        const split best = depth < max_sah_depth ? find_split(begin, end, centroid_bounds, node_bounds.surface_area()) : split{};
+        const double leaf_cost = intersection_cost * static_cast<double>(count);
+        if (count <= max_leaf_size && !(best.cost < leaf_cost)) {
+          return make_leaf();
+        }
+
+        std::uint32_t mid = begin;
+        size_t axis = best.axis;
+        if (best.cost < std::numeric_limits<double>::infinity()) {
+          const double min = centroid_bounds.min[axis];
+          const double extent = centroid_bounds.max[axis] - min;
+          const auto middle = std::partition(indices.begin() + begin, indices.begin() + end, [&](std::uint32_t prim) {
+            return bin_of(centroids[prim][axis], min, extent) <= best.bin;
+          });
+          mid = static_cast<std::uint32_t>(middle - indices.begin());
+        }
+
+        if (mid == begin || mid == end) {
+          // All centroids coincide, binning could not separate them or the tree
+          // is already deep: split at the object median on the widest axis.
+          axis = 0;
+          for (size_t a = 1; a < 3; ++a) {
+            if (node_bounds.max[a] - node_bounds.min[a] > node_bounds.max[axis] - node_bounds.min[axis]) {
+              axis = a;
+            }
+          }
+          mid = begin + count / 2;
+          std::nth_element(indices.begin() + begin, indices.begin() + mid, indices.begin() + end, [&](std::uint32_t a, std::uint32_t b) {
+            return centroids[a][axis] < centroids[b][axis];
+          });
+        }
+
+        build(begin, mid, depth + 1);
+        const std::uint32_t second = build(mid, end, depth + 1);
+        nodes[node_index].offset = second;
+        nodes[node_index].count = 0;
+        nodes[node_index].axis = static_cast<std::uint32_t>(axis);
+        return node_index;
+      }
+    };
+
+    constexpr std::uint32_t leaf_flag = 0x80000000U;
+    constexpr size_t lbvh_30_bit_limit = size_t{1} << 20;
+
+    // Karras-style hierarchy over Morton-sorted primitives. Interior node i
+    // covers a key range that starts or ends at i, found by comparing common
+    // prefix lengths; children with the leaf flag set are positions in the
+    // sorted primitive order.
+    template <typename Key>
+    struct lbvh_builder {
+      std::span<const aabb> bounds;
+      std::vector<Key> keys;
+      std::vector<std::uint32_t> order;
+      std::vector<std::uint32_t> left;
+      std::vector<std::uint32_t> right;
+
+      [[nodiscard]] int common_prefix(std::int64_t i, std::int64_t j) const {
+        if (j < 0 || j >= static_cast<std::int64_t>(keys.size())) {
+          return -1;
+        }
+        const Key a = keys[static_cast<size_t>(i)];
+        const Key b = keys[static_cast<size_t>(j)];
+        if (a == b) {
+          // Equal codes are told apart by their position in the sorted order.
+          return static_cast<int>(8 * sizeof(Key)) + std::countl_zero(static_cast<std::uint32_t>(i ^ j));
+        }
+        return std::countl_zero(static_cast<Key>(a ^ b));
+      }
+
+      void emit_interior(std::int64_t i) {
+        const int d = (common_prefix(i, i + 1) - common_prefix(i, i - 1)) >= 0 ? 1 : -1;
+        const int prefix_min = common_prefix(i, i - d);
+
+        std::int64_t length_max = 2;
+        while (common_prefix(i, i + length_max * d) > prefix_min) {
+          length_max *= 2;
+        }
+        std::int64_t length = 0;
+        for (std::int64_t t = length_max / 2; t >= 1; t /= 2) {
+          if (common_prefix(i, i + (length + t) * d) > prefix_min) {
+            length += t;
+          }
+        }
+        const std::int64_t j = i + length * d;
+
+        const int prefix_node = common_prefix(i, j);
+        std::int64_t split = 0;
+        std::int64_t step = length;
+        do {
+          step = (step + 1) / 2;
+          if (common_prefix(i, i + (split + step) * d) > prefix_node) {
+            split += step;
+          }
+        } while (step > 1);
+        const std::int64_t gamma = i + split * d + std::min(d, 0);
+
+        const auto g = static_cast<std::uint32_t>(gamma);
+        left[static_cast<size_t>(i)] = (std::min(i, j) == gamma) ? (g | leaf_flag) : g;
+        right[static_cast<size_t>(i)] = (std::max(i, j) == gamma + 1) ? ((g + 1) | leaf_flag) : (g + 1);
+      }
+
+      // Depth-first flattening into bvh_node order, computing bounds on the way up.
+      aabb flatten(std::uint32_t child, std::vector<bvh_node>& nodes) const {
+        const auto index = static_cast<std::uint32_t>(nodes.size());
+        nodes.emplace_back();
+        if ((child & leaf_flag) != 0U) {
+          const std::uint32_t position = child & ~leaf_flag;
+          nodes[index].bounds = bounds[order[position]];
+          nodes[index].offset = position;
+          nodes[index].count = 1;
+          return nodes[index].bounds;
+        }
+
+        aabb box = flatten(left[child], nodes);
+        const auto second = static_cast<std::uint32_t>(nodes.size());
+        box.expand(flatten(right[child], nodes));
+        nodes[index].bounds = box;
+        nodes[index].offset = second;
+        return box;
+      }
+    };
+
+    template <typename Key>
+    void build_lbvh_hierarchy(std::span<const aabb> bounds, thread_pool& pool, int bits_per_axis,
+                              std::vector<bvh_node>& nodes, std::vector<std::uint32_t>& primitive_indices) {
+      const size_t n = bounds.size();
+      lbvh_builder<Key> builder{bounds, std::vector<Key>(n), std::vector<std::uint32_t>(n), {}, {}};
+
+      std::vector<aabb> partial(static_cast<size_t>(pool.size()));
+      pool.parallel_for(n, [&](size_t begin, size_t end, int worker) {
+        aabb& box = partial[static_cast<size_t>(worker)];
+        for (size_t i = begin; i < end; ++i) {
+          box.expand(bounds[i].centroid());
+        }
+      });
+      aabb centroid_bounds;
+      for (const aabb& box : partial) {
+        centroid_bounds.expand(box);
+      }
+
+      pool.parallel_for(n, [&](size_t begin, size_t end, int) {
+        for (size_t i = begin; i < end; ++i) {
+          const auto q = quantize(bounds[i].centroid(), centroid_bounds, bits_per_axis);
+          if constexpr (sizeof(Key) == 4) {
+            builder.keys[i] = morton_encode_30(static_cast<std::uint32_t>(q[0]), static_cast<std::uint32_t>(q[1]), static_cast<std::uint32_t>(q[2]));
+          } else {
+            builder.keys[i] = morton_encode_63(q[0], q[1], q[2]);
+          }
+          builder.order[i] = static_cast<std::uint32_t>(i);
+        }
+      });
+
+      radix_sort(builder.keys, builder.order, pool);
+
+      nodes.clear();
+      if (n == 1) {
+        nodes.push_back(bvh_node{bounds[0], 0, 1, 0});
+      } else {
+        builder.left.resize(n - 1);
+        builder.right.resize(n - 1);
+        pool.parallel_for(n - 1, [&](size_t begin, size_t end, int) {
+          for (size_t i = begin; i < end; ++i) {
+            builder.emit_interior(static_cast<std::int64_t>(i));
+          }
+        });
+        nodes.reserve(2 * n - 1);
+        builder.flatten(0, nodes);
+      }
+      primitive_indices = std::move(builder.order);
+    }
+
+    int subtree_depth(std::span<const bvh_node> nodes, std::uint32_t index) {
+      const bvh_node& node = nodes[index];
+      if (node.count > 0) {
+        return 1;
+      }
+      return 1 + std::max(subtree_depth(nodes, index + 1), subtree_depth(nodes, node.offset));
+    }
+
+  }
+
+  bvh::bvh(const bvh& other)
+    : node_storage_{other.node_storage_}, index_storage_{other.index_storage_},
+      nodes_{other.nodes_}, primitive_indices_{other.primitive_indices_} {
+    if (other.nodes_.data() == other.node_storage_.data()) {
+      adopt_storage();
+    }
+  }
+
+  bvh& bvh::operator=(const bvh& other) {
+    if (this != &other) {
+      *this = bvh{other};
+    }
+    return *this;
+  }
+
+  bvh bvh::view(std::span<const bvh_node> nodes, std::span<const std::uint32_t> primitive_indices) {
+    bvh result;
+    result.nodes_ = nodes;
+    result.primitive_indices_ = primitive_indices;
+    return result;
+  }
+
+  void bvh::adopt_storage() {
+    nodes_ = node_storage_;
+    primitive_indices_ = index_storage_;
+  }
+
+  bvh bvh::build_sah(std::span<const aabb> primitive_bounds) {
+    if (primitive_bounds.size() >= std::numeric_limits<std::uint32_t>::max()) {
+      throw std::invalid_argument("Too many primitives for a BVH");
+    }
+
+    bvh result;
+    if (primitive_bounds.empty()) {
+      return result;
+    }
+
+    const auto count = static_cast<std::uint32_t>(primitive_bounds.size());
+    result.index_storage_.resize(count);
+    for (std::uint32_t i = 0; i < count; ++i) {
+      result.index_storage_[i] = i;
+    }
+    result.node_storage_.reserve(2 * static_cast<size_t>(count));
+
+    sah_builder builder{primitive_bounds, {}, result.index_storage_, result.node_storage_};
+    builder.centroids.reserve(count);
+    for (const aabb& box : primitive_bounds) {
+      builder.centroids.push_back(box.centroid());
+    }
+    builder.build(0, count, 0);
+
+    result.adopt_storage();
+    return result;
+  }
+
+  bvh bvh::build_lbvh(std::span<const aabb> primitive_bounds, thread_pool& pool) {
+    if (primitive_bounds.size() >= leaf_flag) {
+      throw std::invalid_argument("Too many primitives for a BVH");
+    }
+
+    bvh result;
+    if (primitive_bounds.empty()) {
+      return result;
+    }
+
+    if (primitive_bounds.size() <= lbvh_30_bit_limit) {
+      build_lbvh_hierarchy<std::uint32_t>(primitive_bounds, pool, 10, result.node_storage_, result.index_storage_);
+    } else {
+      build_lbvh_hierarchy<std::uint64_t>(primitive_bounds, pool, 21, result.node_storage_, result.index_storage_);
+    }
+    result.adopt_storage();
+    return result;
+  }
+
+  bvh bvh::build_lbvh(const primitive_arrays& primitives, thread_pool& pool) {
+    std::vector<aabb> bounds(primitives.size());
+    pool.parallel_for(bounds.size(), [&](size_t begin, size_t end, int) {
+      for (size_t prim = begin; prim < end; ++prim) {
+        bounds[prim] = primitives.bounds(prim);
+      }
+    });
+    return build_lbvh(bounds, pool);
+  }
+
+  int bvh::get_depth() const {
+    return nodes_.empty() ? 0 : subtree_depth(nodes_, 0);
+  }
+
+  namespace {
+
+    template <typename Build>
+    std::optional<bvh> timed_build(const std::string& name, size_t primitive_count, Build&& build) {
+      const auto start = std::chrono::steady_clock::now();
+      bvh result = build();
+      const auto stop = std::chrono::steady_clock::now();
+
+      std::cout << "Built " << name << " over " << primitive_count << " primitives: "
+                << result.get_nodes().size() << " nodes, depth " << result.get_depth() << ", "
+                << std::chrono::duration<double, std::milli>(stop - start).count() << " ms\n";
+      return result;
+    }
+
+    std::string lbvh_name(size_t primitive_count) {
+      return primitive_count <= lbvh_30_bit_limit ? "LBVH (30-bit Morton)" : "LBVH (63-bit Morton)";
+    }
+
+  }
+
+  std::optional<bvh> build_acceleration(const render_config& config, std::span<const aabb> primitive_bounds) {
+    switch (config.acceleration) {
+      case acceleration_type::bvh:
+        return timed_build("SAH BVH", primitive_bounds.size(), [&] { return bvh::build_sah(primitive_bounds); });
+      case acceleration_type::lbvh: {
+        thread_pool pool{thread_pool::resolve_thread_count(config.threads)};
+        return timed_build(lbvh_name(primitive_bounds.size()), primitive_bounds.size(), [&] { return bvh::build_lbvh(primitive_bounds, pool); });
+      }
+      case acceleration_type::none:
+        break;
+    }
+    return std::nullopt;
+  }
+
+  std::optional<bvh> build_acceleration(const render_config& config, const primitive_arrays& primitives) {
+    switch (config.acceleration) {
+      case acceleration_type::bvh:
+        return timed_build("SAH BVH", primitives.size(), [&] { return bvh::build_sah(primitives.all_bounds()); });
+      case acceleration_type::lbvh: {
+        thread_pool pool{thread_pool::resolve_thread_count(config.threads)};
+        return timed_build(lbvh_name(primitives.size()), primitives.size(), [&] { return bvh::build_lbvh(primitives, pool); });
+      }
+      case acceleration_type::none:
+        break;
+    }
+    return std::nullopt;
+  }
+
+}
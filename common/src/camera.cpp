@@ -35,9 +35,27 @@ namespace render {
   }
 
   ray camera::get_ray(double u, double v) const {
-    const vector direction = lower_left_corner_ + horizontal_ * u + vertical_ * v - origin_;
+    const vector direction = lower_left_corner_.add_scaled(horizontal_, u).add_scaled(vertical_, v) - origin_;
     return ray(origin_, direction.normalize());
   }
 
+  void camera::get_rays(const double* u, const double* v, ray_packet& packet) const {
+    // Same operations, in the same order, as get_ray and vector::normalize.
+    for (std::size_t k = 0; k < packet.count; ++k) {
+      const double x = lower_left_corner_.get_x() + horizontal_.get_x() * u[k] + vertical_.get_x() * v[k] - origin_.get_x();
+      const double y = lower_left_corner_.get_y() + horizontal_.get_y() * u[k] + vertical_.get_y() * v[k] - origin_.get_y();
+      const double z = lower_left_corner_.get_z() + horizontal_.get_z() * u[k] + vertical_.get_z() * v[k] - origin_.get_z();
+      const double magnitude = std::sqrt(x * x + y * y + z * z);
+      const bool degenerate = magnitude == 0.0;
+
+      packet.origin_x[k] = origin_.get_x();
+      packet.origin_y[k] = origin_.get_y();
+      packet.origin_z[k] = origin_.get_z();
+      packet.direction_x[k] = degenerate ? 0.0 : x / magnitude;
+      packet.direction_y[k] = degenerate ? 0.0 : y / magnitude;
+      packet.direction_z[k] = degenerate ? 0.0 : z / magnitude;
+    }
+  }
+
 }
 
@@ -0,0 +1,82 @@
+#include "command_line.hpp"
+
+#include <stdexcept>
+#include <vector>
+
+namespace render {
+
+  void command_line::apply_overrides(render_config& config) const {
+    if (threads) {
+      config.threads = *threads;
+    }
+    if (tile_size) {
+      config.tile_size = *tile_size;
+    }
+  }
+
+  std::string command_line_parser::usage(const std::string& program) {
+    return "Usage: " + program + " <config_file> <scene_file> <output_file> [--threads N] [--tile-size N]"
+           " [--isa auto|scalar|avx2|avx512] [--sample-counts FILE]\n";
+  }
+
+  int command_line_parser::parse_int_option(const std::string& option, const std::string& value, int min_value) {
+    int result = 0;
+    try {
+      size_t consumed = 0;
+      result = std::stoi(value, &consumed);
+      if (consumed != value.size()) {
+        throw std::invalid_argument(value);
+      }
+    }
+    catch (const std::exception&) {
+      throw std::runtime_error("Error: Invalid value for " + option + ": " + value);
+    }
+    if (result < min_value) {
+      throw std::runtime_error("Error: Invalid value for " + option + ": " + value);
+    }
+    return result;
+  }
+
+  command_line command_line_parser::parse(int argc, const char* const argv[]) {
+    std::vector<std::string> positional;
+    command_line args;
+
+    for (int i = 1; i < argc; ++i) {
+      const std::string arg = argv[i];
+      if (arg == "--threads" || arg == "--tile-size" || arg == "--isa" || arg == "--sample-counts") {
+        if (i + 1 >= argc) {
+          throw std::runtime_error("Error: Missing value for " + arg);
+        }
+        const std::string value = argv[++i];
+        if (arg == "--threads") {
+          args.threads = parse_int_option(arg, value, 0);
+        } else if (arg == "--tile-size") {
+          args.tile_size = parse_int_option(arg, value, 1);
+        } else if (arg == "--sample-counts") {
+          args.sample_counts_file = value;
+        } else if (value != "auto") {
+          args.isa = parse_isa(value);
+          if (!args.isa) {
+            throw std::runtime_error("Error: Invalid value for " + arg + ": " + value);
+          }
+        }
+      }
+      else if (arg.starts_with("--")) {
+        throw std::runtime_error("Error: Unknown option: " + arg);
+      }
+      else {
+        positional.push_back(arg);
+      }
+    }
+
+    if (positional.size() != 3) {
+      throw std::runtime_error("Error: Expected <config_file> <scene_file> <output_file>");
+    }
+
+    args.config_file = positional[0];
+    args.scene_file = positional[1];
+    args.output_file = positional[2];
+    return args;
+  }
+
+}
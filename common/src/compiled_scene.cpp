@@ -0,0 +1,424 @@
+#include "compiled_scene.hpp"
+
+#include "cylinder.hpp"
+#include "sphere.hpp"
+#include "vector.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+namespace render {
+
+  namespace {
+
+    constexpr std::array<char, 8> compiled_magic{'R', 'N', 'D', 'S', 'C', 'E', 'N', 'E'};
+    constexpr std::uint32_t byte_order_mark = 0x01020304U;
+    constexpr std::size_t sphere_column_count = 4;
+    constexpr std::size_t cylinder_column_count = 18;
+
+    std::size_t padded_count(std::size_t count) {
+      return (count + kernel_lane_padding - 1) / kernel_lane_padding * kernel_lane_padding;
+    }
+
+    std::uint64_t align_offset(std::uint64_t offset) {
+      return (offset + cache_line_size - 1) / cache_line_size * cache_line_size;
+    }
+
+    constexpr std::size_t section_index(compiled_section which) {
+      return static_cast<std::size_t>(which);
+    }
+
+    const char* acceleration_name(acceleration_type type) {
+      return type == acceleration_type::lbvh ? "LBVH" : "SAH BVH";
+    }
+
+    // Sequential writer that starts every section on a cache line and fills
+    // in the header's section table as it goes.
+    class section_writer {
+    public:
+      section_writer(const std::string& filename, compiled_scene_header& header)
+        : out_{filename, std::ios::binary | std::ios::trunc}, header_{header}, position_{sizeof(compiled_scene_header)} {
+        if (!out_.is_open()) {
+          throw std::runtime_error("Error: Could not open output file: " + filename);
+        }
+        // The header goes in last, once the section table is complete.
+        const std::array<char, sizeof(compiled_scene_header)> placeholder{};
+        out_.write(placeholder.data(), placeholder.size());
+      }
+
+      void begin(compiled_section which) {
+        pad_to(align_offset(position_));
+        current_ = which;
+        header_.sections[section_index(which)][0] = position_;
+      }
+
+      void write(const void* data, std::size_t bytes) {
+        out_.write(static_cast<const char*>(data), static_cast<std::streamsize>(bytes));
+        position_ += bytes;
+        header_.sections[section_index(current_)][1] += bytes;
+      }
+
+      // Writes a padded column of values, entry i being value(i) for the first
+      // count entries and NaN after that.
+      void write_column(std::size_t count, const std::function<double(std::size_t)>& value) {
+        std::vector<double> column(padded_count(count), std::numeric_limits<double>::quiet_NaN());
+        for (std::size_t i = 0; i < count; ++i) {
+          column[i] = value(i);
+        }
+        write(column.data(), column.size() * sizeof(double));
+      }
+
+      void finish(const std::string& filename) {
+        out_.seekp(0);
+        out_.write(reinterpret_cast<const char*>(&header_), sizeof(header_));
+        out_.close();
+        if (!out_) {
+          throw std::runtime_error("Error: Could not write output file: " + filename);
+        }
+      }
+
+    private:
+      void pad_to(std::uint64_t offset) {
+        while (position_ < offset) {
+          out_.put('\0');
+          ++position_;
+        }
+      }
+
+      std::ofstream out_;
+      compiled_scene_header& header_;
+      std::uint64_t position_;
+      compiled_section current_ = compiled_section::materials;
+    };
+
+    material_record make_record(const material_table& materials, material_id id) {
+      material_record record{static_cast<std::uint32_t>(materials.get_type(id)), 0, {}};
+      switch (materials.get_type(id)) {
+        case material_type::matte: {
+          const vector& reflectance = materials.get_matte(id).reflectance;
+          record.values = {reflectance.get_x(), reflectance.get_y(), reflectance.get_z(), 0.0};
+          break;
+        }
+        case material_type::metal: {
+          const metal_params& params = materials.get_metal(id);
+          record.values = {params.reflectance.get_x(), params.reflectance.get_y(), params.reflectance.get_z(), params.diffusion};
+          break;
+        }
+        case material_type::refractive:
+          record.values = {materials.get_refractive(id).refraction_index, 0.0, 0.0, 0.0};
+          break;
+      }
+      return record;
+    }
+
+    std::string material_name(material_id id) {
+      return "material_" + std::to_string(id);
+    }
+
+    std::unique_ptr<material> make_material(const material_record& record, material_id id) {
+      const auto& v = record.values;
+      switch (static_cast<material_type>(record.type)) {
+        case material_type::matte:
+          return std::make_unique<matte_material>(material_name(id), v[0], v[1], v[2]);
+        case material_type::metal:
+          return std::make_unique<metal_material>(material_name(id), v[0], v[1], v[2], v[3]);
+        case material_type::refractive:
+          break;
+      }
+      return std::make_unique<refractive_material>(material_name(id), v[0]);
+    }
+
+    // Whether traversing the stored tree stays inside its sections: children
+    // come after their parent (so there are no cycles) and exist, leaves
+    // index the primitive list, levels fit the traversal stack, and the list
+    // has one entry per primitive, each a valid primitive number.
+    bool valid_bvh(std::span<const bvh_node> nodes, std::span<const std::uint32_t> indices, std::uint64_t num_primitives) {
+      if (nodes.empty() || indices.size() != num_primitives) {
+        return false;
+      }
+      // Nodes are checked in order, so every depth is known before it is read.
+      std::vector<std::uint8_t> depth(nodes.size(), 0);
+      depth[0] = 1;
+      for (std::size_t index = 0; index < nodes.size(); ++index) {
+        const bvh_node& node = nodes[index];
+        if (depth[index] == 0) {
+          return false;
+        }
+        if (node.count > 0) {
+          if (static_cast<std::uint64_t>(node.offset) + node.count > indices.size()) {
+            return false;
+          }
+          continue;
+        }
+        if (index + 1 >= nodes.size() || node.offset <= index + 1 || node.offset >= nodes.size() || depth[index] >= bvh::traversal_stack_size) {
+          return false;
+        }
+        const auto child_depth = static_cast<std::uint8_t>(depth[index] + 1);
+        depth[index + 1] = std::max(depth[index + 1], child_depth);
+        depth[node.offset] = std::max(depth[node.offset], child_depth);
+      }
+      return std::ranges::all_of(indices, [&](std::uint32_t prim) { return prim < num_primitives; });
+    }
+
+  }
+
+  bool is_compiled_scene(const std::string& filename) {
+    std::ifstream in(filename, std::ios::binary);
+    std::array<char, compiled_magic.size()> magic{};
+    in.read(magic.data(), static_cast<std::streamsize>(magic.size()));
+    return in && magic == compiled_magic;
+  }
+
+  void write_compiled_scene(const std::string& filename, const baked_scene& baked, const render_config& config, const std::optional<bvh>& accel) {
+    const auto spheres = baked.get_spheres();
+    const auto cylinders = baked.get_cylinders();
+    const material_table& materials = baked.get_materials();
+
+    compiled_scene_header header{};
+    header.magic = compiled_magic;
+    header.version = compiled_scene_version;
+    header.byte_order = byte_order_mark;
+    header.ordering = static_cast<std::uint32_t>(config.ordering);
+    header.acceleration = static_cast<std::uint32_t>(accel ? config.acceleration : acceleration_type::none);
+    header.node_size = sizeof(bvh_node);
+    header.lane_padding = kernel_lane_padding;
+    header.num_materials = materials.size();
+    header.num_spheres = spheres.size();
+    header.num_cylinders = cylinders.size();
+
+    section_writer out{filename, header};
+
+    out.begin(compiled_section::materials);
+    for (material_id id = 0; id < materials.size(); ++id) {
+      const material_record record = make_record(materials, id);
+      out.write(&record, sizeof(record));
+    }
+
+    out.begin(compiled_section::sphere_columns);
+    out.write_column(spheres.size(), [&](std::size_t i) { return spheres[i].center.get_x(); });
+    out.write_column(spheres.size(), [&](std::size_t i) { return spheres[i].center.get_y(); });
+    out.write_column(spheres.size(), [&](std::size_t i) { return spheres[i].center.get_z(); });
+    out.write_column(spheres.size(), [&](std::size_t i) { return spheres[i].radius; });
+
+    out.begin(compiled_section::sphere_materials);
+    for (const baked_sphere& sph : spheres) {
+      out.write(&sph.mat, sizeof(material_id));
+    }
+
+    out.begin(compiled_section::cylinder_columns);
+    const auto cylinder_column = [&](const std::function<double(const baked_cylinder&)>& value) {
+      out.write_column(cylinders.size(), [&](std::size_t i) { return value(cylinders[i]); });
+    };
+    cylinder_column([](const baked_cylinder& cyl) { return cyl.frame.center.get_x(); });
+    cylinder_column([](const baked_cylinder& cyl) { return cyl.frame.center.get_y(); });
+    cylinder_column([](const baked_cylinder& cyl) { return cyl.frame.center.get_z(); });
+    cylinder_column([](const baked_cylinder& cyl) { return cyl.radius; });
+    cylinder_column([](const baked_cylinder& cyl) { return cyl.axis.get_x(); });
+    cylinder_column([](const baked_cylinder& cyl) { return cyl.axis.get_y(); });
+    cylinder_column([](const baked_cylinder& cyl) { return cyl.axis.get_z(); });
+    cylinder_column([](const baked_cylinder& cyl) { return cyl.frame.unit_axis.get_x(); });
+    cylinder_column([](const baked_cylinder& cyl) { return cyl.frame.unit_axis.get_y(); });
+    cylinder_column([](const baked_cylinder& cyl) { return cyl.frame.unit_axis.get_z(); });
+    cylinder_column([](const baked_cylinder& cyl) { return cyl.frame.top_center.get_x(); });
+    cylinder_column([](const baked_cylinder& cyl) { return cyl.frame.top_center.get_y(); });
+    cylinder_column([](const baked_cylinder& cyl) { return cyl.frame.top_center.get_z(); });
+    cylinder_column([](const baked_cylinder& cyl) { return cyl.frame.bottom_center.get_x(); });
+    cylinder_column([](const baked_cylinder& cyl) { return cyl.frame.bottom_center.get_y(); });
+    cylinder_column([](const baked_cylinder& cyl) { return cyl.frame.bottom_center.get_z(); });
+    cylinder_column([](const baked_cylinder& cyl) { return cyl.frame.half_height; });
+    cylinder_column([](const baked_cylinder& cyl) { return cyl.frame.radius_squared; });
+
+    out.begin(compiled_section::cylinder_materials);
+    for (const baked_cylinder& cyl : cylinders) {
+      out.write(&cyl.mat, sizeof(material_id));
+    }
+
+    if (accel) {
+      header.num_nodes = accel->get_nodes().size();
+      header.num_indices = accel->get_primitive_indices().size();
+      out.begin(compiled_section::bvh_nodes);
+      out.write(accel->get_nodes().data(), accel->get_nodes().size_bytes());
+      out.begin(compiled_section::bvh_indices);
+      out.write(accel->get_primitive_indices().data(), accel->get_primitive_indices().size_bytes());
+    }
+
+    out.finish(filename);
+  }
+
+  compiled_scene::compiled_scene(mapped_file file, const compiled_scene_header& header)
+    : file_{std::move(file)}, header_{header} {}
+
+  compiled_scene compiled_scene::open(const std::string& filename) {
+    std::optional<mapped_file> file = mapped_file::open(filename);
+    if (!file) {
+      throw std::runtime_error("Error: Could not open scene file: " + filename);
+    }
+    const std::string_view contents = file->contents();
+    const std::runtime_error invalid{"Error: Invalid compiled scene file: " + filename};
+
+    compiled_scene_header header{};
+    if (contents.size() < sizeof(header)) {
+      throw invalid;
+    }
+    std::memcpy(&header, contents.data(), sizeof(header));
+    if (header.magic != compiled_magic) {
+      throw invalid;
+    }
+    if (header.version != compiled_scene_version || header.byte_order != byte_order_mark || header.lane_padding != kernel_lane_padding) {
+      throw std::runtime_error("Error: Compiled scene file was written by a different build, compile it again: " + filename);
+    }
+
+    if (header.acceleration > static_cast<std::uint32_t>(acceleration_type::lbvh) || header.ordering > static_cast<std::uint32_t>(primitive_order::hilbert)) {
+      throw invalid;
+    }
+
+    // No count may describe more elements than the file could hold, which also
+    // keeps the section sizes below from overflowing.
+    const bool has_bvh = static_cast<acceleration_type>(header.acceleration) != acceleration_type::none;
+    const auto fits = [&](std::uint64_t count, std::uint64_t element_size) {
+      return element_size == 0 || count <= contents.size() / element_size;
+    };
+    if (!fits(header.num_materials, sizeof(material_record)) || !fits(header.num_spheres, sphere_column_count * sizeof(double)) ||
+        !fits(header.num_cylinders, cylinder_column_count * sizeof(double)) ||
+        (has_bvh && (header.node_size > contents.size() || !fits(header.num_nodes, header.node_size) ||
+                     !fits(header.num_indices, sizeof(std::uint32_t))))) {
+      throw invalid;
+    }
+
+    // Every section must lie in the file and hold exactly what the counts say.
+    const std::array<std::uint64_t, section_index(compiled_section::count)> expected{
+      header.num_materials * sizeof(material_record),
+      sphere_column_count * padded_count(header.num_spheres) * sizeof(double),
+      header.num_spheres * sizeof(material_id),
+      cylinder_column_count * padded_count(header.num_cylinders) * sizeof(double),
+      header.num_cylinders * sizeof(material_id),
+      has_bvh ? header.num_nodes * header.node_size : 0,
+      has_bvh ? header.num_indices * sizeof(std::uint32_t) : 0
+    };
+    for (std::size_t i = 0; i < expected.size(); ++i) {
+      const auto [offset, bytes] = header.sections[i];
+      if (bytes != expected[i] || offset % cache_line_size != 0 || offset > contents.size() || bytes > contents.size() - offset) {
+        throw invalid;
+      }
+    }
+
+    compiled_scene result{std::move(*file), header};
+
+    const auto* records = result.section<material_record>(compiled_section::materials);
+    for (std::size_t id = 0; id < header.num_materials; ++id) {
+      if (records[id].type > static_cast<std::uint32_t>(material_type::refractive)) {
+        throw invalid;
+      }
+      result.materials_.add(*make_material(records[id], static_cast<material_id>(id)));
+    }
+    const auto valid_material = [&](material_id id) { return id < header.num_materials; };
+    if (!std::ranges::all_of(result.get_sphere_materials(), valid_material) || !std::ranges::all_of(result.get_cylinder_materials(), valid_material)) {
+      throw invalid;
+    }
+
+    // A tree of another build's node layout is never read; see load_acceleration.
+    if (has_bvh && header.node_size == sizeof(bvh_node) &&
+        !valid_bvh({result.section<bvh_node>(compiled_section::bvh_nodes), header.num_nodes},
+                   {result.section<std::uint32_t>(compiled_section::bvh_indices), header.num_indices},
+                   header.num_spheres + header.num_cylinders)) {
+      throw invalid;
+    }
+
+    return result;
+  }
+
+  template <typename T>
+  const T* compiled_scene::section(compiled_section which) const {
+    return reinterpret_cast<const T*>(file_.contents().data() + header_.sections[section_index(which)][0]);
+  }
+
+  const double* compiled_scene::column(compiled_section which, std::size_t index) const {
+    const std::size_t count = which == compiled_section::sphere_columns ? header_.num_spheres : header_.num_cylinders;
+    return section<double>(which) + index * padded_count(count);
+  }
+
+  sphere_lanes compiled_scene::get_sphere_lanes() const {
+    const auto col = [&](std::size_t index) { return column(compiled_section::sphere_columns, index); };
+    return sphere_lanes{col(0), col(1), col(2), col(3), padded_count(header_.num_spheres)};
+  }
+
+  cylinder_lanes compiled_scene::get_cylinder_lanes() const {
+    const auto col = [&](std::size_t index) { return column(compiled_section::cylinder_columns, index); };
+    return cylinder_lanes{
+      col(0), col(1), col(2),
+      col(7), col(8), col(9),
+      col(10), col(11), col(12),
+      col(13), col(14), col(15),
+      col(16), col(17),
+      padded_count(header_.num_cylinders)
+    };
+  }
+
+  std::span<const material_id> compiled_scene::get_sphere_materials() const {
+    return {section<material_id>(compiled_section::sphere_materials), header_.num_spheres};
+  }
+
+  std::span<const material_id> compiled_scene::get_cylinder_materials() const {
+    return {section<material_id>(compiled_section::cylinder_materials), header_.num_cylinders};
+  }
+
+  primitive_arrays compiled_scene::get_primitive_arrays() const {
+    const auto sphere_col = [&](std::size_t index) {
+      return std::span<const double>{column(compiled_section::sphere_columns, index), header_.num_spheres};
+    };
+    const auto cylinder_col = [&](std::size_t index) {
+      return std::span<const double>{column(compiled_section::cylinder_columns, index), header_.num_cylinders};
+    };
+    return primitive_arrays{
+      sphere_col(0), sphere_col(1), sphere_col(2), sphere_col(3),
+      cylinder_col(0), cylinder_col(1), cylinder_col(2), cylinder_col(3),
+      cylinder_col(4), cylinder_col(5), cylinder_col(6)
+    };
+  }
+
+  std::optional<bvh> compiled_scene::load_acceleration(const render_config& config) const {
+    const auto stored = static_cast<acceleration_type>(header_.acceleration);
+    if (config.acceleration == acceleration_type::none) {
+      return std::nullopt;
+    }
+    if (stored == config.acceleration && header_.node_size == sizeof(bvh_node)) {
+      std::cout << "Using the " << acceleration_name(stored) << " stored in the compiled scene: " << header_.num_nodes << " nodes\n";
+      return bvh::view({section<bvh_node>(compiled_section::bvh_nodes), header_.num_nodes},
+                       {section<std::uint32_t>(compiled_section::bvh_indices), header_.num_indices});
+    }
+    if (stored == config.acceleration) {
+      std::cout << "The compiled scene's " << acceleration_name(stored) << " was stored by a build with another node layout; rebuilding.\n";
+    }
+    return build_acceleration(config, get_primitive_arrays());
+  }
+
+  scene compiled_scene::to_scene() const {
+    scene sc;
+    const auto* records = section<material_record>(compiled_section::materials);
+    for (material_id id = 0; id < header_.num_materials; ++id) {
+      sc.add_material(*make_material(records[id], id));
+    }
+
+    const primitive_arrays prims = get_primitive_arrays();
+    const auto sphere_materials = get_sphere_materials();
+    const auto cylinder_materials = get_cylinder_materials();
+    sc.reserve(prims.get_num_spheres(), prims.get_num_cylinders());
+    for (std::size_t i = 0; i < prims.get_num_spheres(); ++i) {
+      sc.add_sphere(vector{prims.sphere_centers_x[i], prims.sphere_centers_y[i], prims.sphere_centers_z[i]}, prims.sphere_radii[i], sphere_materials[i]);
+    }
+    for (std::size_t i = 0; i < prims.get_num_cylinders(); ++i) {
+      sc.add_cylinder(vector{prims.cylinder_centers_x[i], prims.cylinder_centers_y[i], prims.cylinder_centers_z[i]}, prims.cylinder_radii[i],
+                      vector{prims.cylinder_axes_x[i], prims.cylinder_axes_y[i], prims.cylinder_axes_z[i]}, cylinder_materials[i]);
+    }
+    return sc;
+  }
+
+}
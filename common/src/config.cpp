@@ -99,6 +99,24 @@ namespace render {
         throw std::runtime_error("Error: Invalid samples_per_pixel parameters\nLine: \"" + line + "\"");
       }
     }
+    else if (key == "adaptive_threshold:") {
+      if (values.size() != 1) {
+        throw std::runtime_error("Error: Invalid adaptive_threshold parameters\nLine: \"" + line + "\"");
+      }
+      config.adaptive_threshold = std::stod(values[0]);
+      if (!(config.adaptive_threshold >= 0.0)) {
+        throw std::runtime_error("Error: Invalid adaptive_threshold parameters\nLine: \"" + line + "\"");
+      }
+    }
+    else if (key == "adaptive_min_samples:") {
+      if (values.size() != 1) {
+        throw std::runtime_error("Error: Invalid adaptive_min_samples parameters\nLine: \"" + line + "\"");
+      }
+      config.adaptive_min_samples = std::stoi(values[0]);
+      if (config.adaptive_min_samples < 2) {
+        throw std::runtime_error("Error: Invalid adaptive_min_samples parameters\nLine: \"" + line + "\"");
+      }
+    }
     else if (key == "max_depth:") {
       if (values.size() != 1) {
         throw std::runtime_error("Error: Invalid max_depth parameters\nLine: \"" + line + "\"");
@@ -108,6 +126,15 @@ namespace render {
         throw std::runtime_error("Error: Invalid max_depth parameters\nLine: \"" + line + "\"");
       }
     }
+    else if (key == "russian_roulette_depth:") {
+      if (values.size() != 1) {
+        throw std::runtime_error("Error: Invalid russian_roulette_depth parameters\nLine: \"" + line + "\"");
+      }
+      config.russian_roulette_depth = std::stoi(values[0]);
+      if (config.russian_roulette_depth < 0) {
+        throw std::runtime_error("Error: Invalid russian_roulette_depth parameters\nLine: \"" + line + "\"");
+      }
+    }
     else if (key == "material_rng_seed:") {
       if (values.size() != 1) {
         throw std::runtime_error("Error: Invalid material_rng_seed parameters\nLine: \"" + line + "\"");
@@ -120,6 +147,130 @@ namespace render {
       }
       config.ray_rng_seed = static_cast<unsigned int>(std::stoul(values[0]));
     }
+    else if (key == "threads:") {
+      if (values.size() != 1) {
+        throw std::runtime_error("Error: Invalid threads parameters\nLine: \"" + line + "\"");
+      }
+      config.threads = std::stoi(values[0]);
+      if (config.threads < 0) {
+        throw std::runtime_error("Error: Invalid threads parameters\nLine: \"" + line + "\"");
+      }
+    }
+    else if (key == "tile_size:") {
+      if (values.size() != 1) {
+        throw std::runtime_error("Error: Invalid tile_size parameters\nLine: \"" + line + "\"");
+      }
+      config.tile_size = std::stoi(values[0]);
+      if (config.tile_size <= 0) {
+        throw std::runtime_error("Error: Invalid tile_size parameters\nLine: \"" + line + "\"");
+      }
+    }
+    else if (key == "acceleration:") {
+      if (values.size() != 1) {
+        throw std::runtime_error("Error: Invalid acceleration parameters\nLine: \"" + line + "\"");
+      }
+      if (values[0] == "none") {
+        config.acceleration = acceleration_type::none;
+      } else if (values[0] == "bvh") {
+        config.acceleration = acceleration_type::bvh;
+      } else if (values[0] == "lbvh") {
+        config.acceleration = acceleration_type::lbvh;
+      } else {
+        throw std::runtime_error("Error: Invalid acceleration parameters\nLine: \"" + line + "\"");
+      }
+    }
+    else if (key == "sampler:") {
+      if (values.size() != 1) {
+        throw std::runtime_error("Error: Invalid sampler parameters\nLine: \"" + line + "\"");
+      }
+      if (values[0] == "independent") {
+        config.sampler = sampler_type::independent;
+      } else if (values[0] == "stratified") {
+        config.sampler = sampler_type::stratified;
+      } else if (values[0] == "sobol") {
+        config.sampler = sampler_type::sobol;
+      } else {
+        throw std::runtime_error("Error: Invalid sampler parameters\nLine: \"" + line + "\"");
+      }
+    }
+    else if (key == "engine:") {
+      if (values.size() != 1) {
+        throw std::runtime_error("Error: Invalid engine parameters\nLine: \"" + line + "\"");
+      }
+      if (values[0] == "recursive") {
+        config.engine = render_engine::recursive;
+      } else if (values[0] == "wavefront") {
+        config.engine = render_engine::wavefront;
+      } else {
+        throw std::runtime_error("Error: Invalid engine parameters\nLine: \"" + line + "\"");
+      }
+    }
+    else if (key == "precision:") {
+      if (values.size() != 1) {
+        throw std::runtime_error("Error: Invalid precision parameters\nLine: \"" + line + "\"");
+      }
+      if (values[0] == "float") {
+        config.precision = render_precision::single_precision;
+      } else if (values[0] == "double") {
+        config.precision = render_precision::double_precision;
+      } else {
+        throw std::runtime_error("Error: Invalid precision parameters\nLine: \"" + line + "\"");
+      }
+    }
+    else if (key == "layout:") {
+      if (values.size() != 1) {
+        throw std::runtime_error("Error: Invalid layout parameters\nLine: \"" + line + "\"");
+      }
+      if (values[0] == "aos") {
+        config.layout = memory_layout::aos;
+      } else if (values[0] == "soa") {
+        config.layout = memory_layout::soa;
+      } else if (values[0] == "aosoa") {
+        config.layout = memory_layout::aosoa;
+      } else {
+        throw std::runtime_error("Error: Invalid layout parameters\nLine: \"" + line + "\"");
+      }
+    }
+    else if (key == "primitive_order:") {
+      if (values.size() != 1) {
+        throw std::runtime_error("Error: Invalid primitive_order parameters\nLine: \"" + line + "\"");
+      }
+      if (values[0] == "file") {
+        config.ordering = primitive_order::file;
+      } else if (values[0] == "morton") {
+        config.ordering = primitive_order::morton;
+      } else if (values[0] == "hilbert") {
+        config.ordering = primitive_order::hilbert;
+      } else {
+        throw std::runtime_error("Error: Invalid primitive_order parameters\nLine: \"" + line + "\"");
+      }
+    }
+    else if (key == "output_format:") {
+      if (values.size() != 1) {
+        throw std::runtime_error("Error: Invalid output_format parameters\nLine: \"" + line + "\"");
+      }
+      if (values[0] == "p3") {
+        config.output_format = image_format::p3;
+      } else if (values[0] == "p6") {
+        config.output_format = image_format::p6;
+      } else if (values[0] == "pfm") {
+        config.output_format = image_format::pfm;
+      } else {
+        throw std::runtime_error("Error: Invalid output_format parameters\nLine: \"" + line + "\"");
+      }
+    }
+    else if (key == "stream_output:") {
+      if (values.size() != 1) {
+        throw std::runtime_error("Error: Invalid stream_output parameters\nLine: \"" + line + "\"");
+      }
+      if (values[0] == "true") {
+        config.stream_output = true;
+      } else if (values[0] == "false") {
+        config.stream_output = false;
+      } else {
+        throw std::runtime_error("Error: Invalid stream_output parameters\nLine: \"" + line + "\"");
+      }
+    }
     else if (key == "background_dark_color:") {
       if (values.size() != 3) {
         throw std::runtime_error("Error: Invalid background_dark_color parameters\nLine: \"" + line + "\"");
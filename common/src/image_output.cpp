@@ -0,0 +1,82 @@
+#include "image_output.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+
+namespace render {
+
+  image_output::image_output(const render_config& config, const std::string& filename, int width, int height)
+      : filename_{filename}, format_{output_format_for(config, filename)}, gamma_{config.gamma}, width_{width}, height_{height},
+        tile_size_{config.tile_size} {
+    if (!config.stream_output) {
+      image_.emplace(width, height);
+      return;
+    }
+    if (format_ == image_format::p3) {
+      std::cout << "P3 output cannot be streamed; keeping the image in memory.\n";
+      image_.emplace(width, height);
+      return;
+    }
+
+    const std::string header = image_header(format_, width, height);
+    header_size_ = header.size();
+    pixel_size_ = format_ == image_format::pfm ? 3 * sizeof(float) : 3;
+    file_ = mapped_output_file::create(filename, header_size_ + static_cast<std::size_t>(width) * static_cast<std::size_t>(height) * pixel_size_);
+    std::memcpy(file_->data(), header.data(), header_size_);
+    if (format_ == image_format::p6) {
+      encoder_.emplace(gamma_);
+    }
+
+    const tile_grid grid{width, height, tile_size_};
+    const auto rows = grid.size() / static_cast<std::size_t>(grid.get_columns());
+    tiles_left_ = std::make_unique<std::atomic<int>[]>(rows);
+    for (std::size_t row = 0; row < rows; ++row) {
+      tiles_left_[row] = grid.get_columns();
+    }
+    std::cout << "Streaming tiles into " << filename << "\n";
+  }
+
+  std::size_t image_output::byte_offset(int x, int y) const {
+    // P6 stores the top row first, PFM the bottom one.
+    const int file_row = format_ == image_format::pfm ? y : height_ - 1 - y;
+    return header_size_ + (static_cast<std::size_t>(file_row) * static_cast<std::size_t>(width_) + static_cast<std::size_t>(x)) * pixel_size_;
+  }
+
+  void image_output::store_tile(const tile& t, const framebuffer& pixels) {
+    if (image_) {
+      image_->set_block(t.x_begin, t.y_begin, pixels);
+      return;
+    }
+    stream_tile(t, pixels);
+  }
+
+  void image_output::stream_tile(const tile& t, const framebuffer& pixels) {
+    const auto row_components = static_cast<std::size_t>(pixels.get_width()) * 3;
+    for (int j = 0; j < pixels.get_height(); ++j) {
+      char* out = file_->data() + byte_offset(t.x_begin, t.y_begin + j);
+      const auto row = pixels.get_row(j);
+      if (encoder_) {
+        encoder_->encode(row.data(), reinterpret_cast<std::uint8_t*>(out), row_components);
+      } else {
+        std::memcpy(out, row.data(), row.size_bytes());
+      }
+    }
+
+    // The last tile of a row of tiles releases the rows' pages. All tiles of
+    // a row span the same image rows.
+    if (--tiles_left_[static_cast<std::size_t>(t.y_begin / tile_size_)] == 0) {
+      const std::size_t first = std::min(byte_offset(0, t.y_begin), byte_offset(0, t.y_end - 1));
+      file_->release_range(first, static_cast<std::size_t>(t.y_end - t.y_begin) * static_cast<std::size_t>(width_) * pixel_size_);
+    }
+  }
+
+  void image_output::finish() {
+    if (image_) {
+      write_image(filename_, *image_, format_, gamma_);
+    }
+    file_.reset();
+  }
+
+}
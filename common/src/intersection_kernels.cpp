@@ -0,0 +1,211 @@
+#include "intersection_kernels.hpp"
+
+#include "kernel_dispatch.hpp"
+
+#include <cmath>
+
+namespace render {
+
+  namespace {
+
+    using kernels::parallel_epsilon;
+
+    // The scalar loops use the same arithmetic, in the same order, as the
+    // per-lane SIMD variants in simd_kernels.inl, so every path produces
+    // identical distances.
+    void scan_spheres_scalar(const sphere_lanes& spheres, std::size_t begin, std::size_t end, const ray& r, double t_min,
+                             double& t_max, std::optional<primitive_hit>& best) {
+      const vector& o = r.get_origin();
+      const vector& d = r.get_direction();
+      const double a = d.dot(d);
+
+      for (std::size_t i = begin; i < end; ++i) {
+        const std::size_t offset = column_offset(spheres, i);
+        const double ocx = o.get_x() - spheres.centers_x[offset];
+        const double ocy = o.get_y() - spheres.centers_y[offset];
+        const double ocz = o.get_z() - spheres.centers_z[offset];
+        const double b = 2.0 * (ocx * d.get_x() + ocy * d.get_y() + ocz * d.get_z());
+        const double c = (ocx * ocx + ocy * ocy + ocz * ocz) - spheres.radii[offset] * spheres.radii[offset];
+        const double discriminant = b * b - 4.0 * a * c;
+
+        if (discriminant >= 0.0) {
+          const double sqrt_d = std::sqrt(discriminant);
+          const double t1 = (-b - sqrt_d) / (2.0 * a);
+          const double t2 = (-b + sqrt_d) / (2.0 * a);
+          const double t = (t1 > t_min) ? t1 : ((t2 > t_min) ? t2 : -1.0);
+
+          if (t > t_min && t < t_max) {
+            t_max = t;
+            best = primitive_hit{t, static_cast<std::uint32_t>(i)};
+          }
+        }
+      }
+    }
+
+    void scan_cylinders_scalar(const cylinder_lanes& cylinders, std::size_t begin, std::size_t end, const ray& r, double t_min,
+                               double& t_max, std::optional<primitive_hit>& best) {
+      const vector& o = r.get_origin();
+      const vector& d = r.get_direction();
+
+      for (std::size_t i = begin; i < end; ++i) {
+        const std::size_t offset = column_offset(cylinders, i);
+        const double ax = cylinders.unit_axes_x[offset];
+        const double ay = cylinders.unit_axes_y[offset];
+        const double az = cylinders.unit_axes_z[offset];
+        const double radius_squared = cylinders.radii_squared[offset];
+
+        const double ocx = o.get_x() - cylinders.centers_x[offset];
+        const double ocy = o.get_y() - cylinders.centers_y[offset];
+        const double ocz = o.get_z() - cylinders.centers_z[offset];
+
+        const double dir_axis = d.get_x() * ax + d.get_y() * ay + d.get_z() * az;
+        const double dpx = d.get_x() - ax * dir_axis;
+        const double dpy = d.get_y() - ay * dir_axis;
+        const double dpz = d.get_z() - az * dir_axis;
+        const double oc_axis = ocx * ax + ocy * ay + ocz * az;
+        const double opx = ocx - ax * oc_axis;
+        const double opy = ocy - ay * oc_axis;
+        const double opz = ocz - az * oc_axis;
+
+        const double a = dpx * dpx + dpy * dpy + dpz * dpz;
+        const double b = 2.0 * (dpx * opx + dpy * opy + dpz * opz);
+        const double c = (opx * opx + opy * opy + opz * opz) - radius_squared;
+        const double discriminant = b * b - 4.0 * a * c;
+
+        if (discriminant >= 0.0 && a > parallel_epsilon) {
+          const double sqrt_d = std::sqrt(discriminant);
+          for (const double t : {(-b - sqrt_d) / (2.0 * a), (-b + sqrt_d) / (2.0 * a)}) {
+            if (t > t_min && t < t_max) {
+              const double tpx = (o.get_x() + d.get_x() * t) - cylinders.centers_x[offset];
+              const double tpy = (o.get_y() + d.get_y() * t) - cylinders.centers_y[offset];
+              const double tpz = (o.get_z() + d.get_z() * t) - cylinders.centers_z[offset];
+              if (std::abs(tpx * ax + tpy * ay + tpz * az) <= cylinders.half_heights[offset]) {
+                t_max = t;
+                best = primitive_hit{t, static_cast<std::uint32_t>(i)};
+              }
+            }
+          }
+        }
+
+        if (std::abs(dir_axis) > parallel_epsilon) {
+          const double* cap_x[] = {cylinders.top_centers_x, cylinders.bottom_centers_x};
+          const double* cap_y[] = {cylinders.top_centers_y, cylinders.bottom_centers_y};
+          const double* cap_z[] = {cylinders.top_centers_z, cylinders.bottom_centers_z};
+          for (std::size_t cap = 0; cap < 2; ++cap) {
+            const double kx = cap_x[cap][offset];
+            const double ky = cap_y[cap][offset];
+            const double kz = cap_z[cap][offset];
+            const double t = ((kx - o.get_x()) * ax + (ky - o.get_y()) * ay + (kz - o.get_z()) * az) / dir_axis;
+            if (t > t_min && t < t_max) {
+              const double qx = (o.get_x() + d.get_x() * t) - kx;
+              const double qy = (o.get_y() + d.get_y() * t) - ky;
+              const double qz = (o.get_z() + d.get_z() * t) - kz;
+              if (qx * qx + qy * qy + qz * qz <= radius_squared) {
+                t_max = t;
+                best = primitive_hit{t, static_cast<std::uint32_t>(i)};
+              }
+            }
+          }
+        }
+      }
+    }
+
+    kernels::flat_ray flatten(const ray& r) {
+      const vector& o = r.get_origin();
+      const vector& d = r.get_direction();
+      return kernels::flat_ray{{o.get_x(), o.get_y(), o.get_z()}, {d.get_x(), d.get_y(), d.get_z()}};
+    }
+
+    // Runs a variant's full-register scan, if it has one, and returns how
+    // many primitives it covered.
+    template <typename Lanes, typename Scan>
+    std::size_t scan_simd(Scan scan, const Lanes& primitives, const ray& r, double t_min, double& t_max,
+                          std::optional<primitive_hit>& best) {
+      if (scan == nullptr) {
+        return 0;
+      }
+      kernels::flat_hit hit{t_max, -1};
+      const std::size_t done = scan(primitives, flatten(r), t_min, hit);
+      if (hit.index >= 0) {
+        t_max = hit.t;
+        best = primitive_hit{hit.t, static_cast<std::uint32_t>(hit.index)};
+      }
+      return done;
+    }
+
+    // Scalar packet fallback: the single-ray loop once per lane.
+    template <typename Lanes, typename Scan>
+    void packet_scalar(const Lanes& primitives, std::size_t begin, std::size_t end, std::uint32_t first_primitive,
+                       const ray_packet& packet, double t_min, packet_hits& hits, Scan&& scan) {
+      for (std::size_t k = 0; k < packet.count; ++k) {
+        std::optional<primitive_hit> best;
+        scan(primitives, begin, end, packet.get_ray(k), t_min, hits.t[k], best);
+        if (best) {
+          hits.primitive[k] = static_cast<double>(first_primitive + best->index);
+        }
+      }
+    }
+
+  }
+
+  std::optional<primitive_hit> closest_sphere_hit(const sphere_lanes& spheres, const ray& r, double t_min, double t_max) {
+    std::optional<primitive_hit> best;
+    const std::size_t done = scan_simd(kernels::active().closest_spheres, spheres, r, t_min, t_max, best);
+    scan_spheres_scalar(spheres, done, spheres.count, r, t_min, t_max, best);
+    return best;
+  }
+
+  std::optional<primitive_hit> closest_cylinder_hit(const cylinder_lanes& cylinders, const ray& r, double t_min, double t_max) {
+    std::optional<primitive_hit> best;
+    const std::size_t done = scan_simd(kernels::active().closest_cylinders, cylinders, r, t_min, t_max, best);
+    scan_cylinders_scalar(cylinders, done, cylinders.count, r, t_min, t_max, best);
+    return best;
+  }
+
+  std::optional<primitive_hit> closest_sphere_hit_scalar(const sphere_lanes& spheres, const ray& r, double t_min, double t_max) {
+    std::optional<primitive_hit> best;
+    scan_spheres_scalar(spheres, 0, spheres.count, r, t_min, t_max, best);
+    return best;
+  }
+
+  std::optional<primitive_hit> closest_cylinder_hit_scalar(const cylinder_lanes& cylinders, const ray& r, double t_min, double t_max) {
+    std::optional<primitive_hit> best;
+    scan_cylinders_scalar(cylinders, 0, cylinders.count, r, t_min, t_max, best);
+    return best;
+  }
+
+  std::optional<double> sphere_hit_distance(const sphere_lanes& spheres, std::size_t index, const ray& r, double t_min, double t_max) {
+    std::optional<primitive_hit> best;
+    scan_spheres_scalar(spheres, index, index + 1, r, t_min, t_max, best);
+    return best ? std::optional<double>{best->t} : std::nullopt;
+  }
+
+  std::optional<double> cylinder_hit_distance(const cylinder_lanes& cylinders, std::size_t index, const ray& r, double t_min, double t_max) {
+    std::optional<primitive_hit> best;
+    scan_cylinders_scalar(cylinders, index, index + 1, r, t_min, t_max, best);
+    return best ? std::optional<double>{best->t} : std::nullopt;
+  }
+
+  void intersect_packet_spheres(const sphere_lanes& spheres, std::size_t begin, std::size_t end, std::uint32_t first_primitive,
+                                const ray_packet& packet, double t_min, packet_hits& hits) {
+    if (const auto kernel = kernels::active().packet_spheres) {
+      kernel(spheres, begin, end, first_primitive, packet, t_min, hits);
+    } else {
+      packet_scalar(spheres, begin, end, first_primitive, packet, t_min, hits, scan_spheres_scalar);
+    }
+  }
+
+  void intersect_packet_cylinders(const cylinder_lanes& cylinders, std::size_t begin, std::size_t end, std::uint32_t first_primitive,
+                                  const ray_packet& packet, double t_min, packet_hits& hits) {
+    if (const auto kernel = kernels::active().packet_cylinders) {
+      kernel(cylinders, begin, end, first_primitive, packet, t_min, hits);
+    } else {
+      packet_scalar(cylinders, begin, end, first_primitive, packet, t_min, hits, scan_cylinders_scalar);
+    }
+  }
+
+  const char* intersection_kernel_isa() {
+    return isa_name(active_kernel_isa());
+  }
+
+}
@@ -0,0 +1,105 @@
+#include "kernel_dispatch.hpp"
+
+#include <atomic>
+#include <stdexcept>
+
+namespace render {
+
+  namespace {
+
+    // Portable code for every kernel.
+    constexpr kernels::table scalar_table{cpu_isa::scalar, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr};
+
+    std::atomic<const kernels::table*> active_table{nullptr};
+
+    bool cpu_supports(cpu_isa isa) {
+#if defined(RENDER_KERNEL_VARIANTS)
+      switch (isa) {
+        case cpu_isa::scalar:
+          return true;
+        case cpu_isa::avx2:
+          return __builtin_cpu_supports("avx2") != 0;
+        case cpu_isa::avx512:
+          return __builtin_cpu_supports("avx512f") != 0;
+      }
+      return false;
+#else
+      return isa == cpu_isa::scalar;
+#endif
+    }
+
+    const kernels::table& table_for([[maybe_unused]] cpu_isa isa) {
+#if defined(RENDER_KERNEL_VARIANTS)
+      if (isa == cpu_isa::avx512) {
+        return kernels::avx512_table;
+      }
+      if (isa == cpu_isa::avx2) {
+        return kernels::avx2_table;
+      }
+#endif
+      return scalar_table;
+    }
+
+  }
+
+  const char* isa_name(cpu_isa isa) {
+    switch (isa) {
+      case cpu_isa::scalar:
+        return "scalar";
+      case cpu_isa::avx2:
+        return "avx2";
+      case cpu_isa::avx512:
+        return "avx512";
+    }
+    return "unknown";
+  }
+
+  std::optional<cpu_isa> parse_isa(const std::string& name) {
+    for (const cpu_isa isa : {cpu_isa::scalar, cpu_isa::avx2, cpu_isa::avx512}) {
+      if (name == isa_name(isa)) {
+        return isa;
+      }
+    }
+    return std::nullopt;
+  }
+
+  std::vector<cpu_isa> supported_isas() {
+    std::vector<cpu_isa> isas;
+    for (const cpu_isa isa : {cpu_isa::scalar, cpu_isa::avx2, cpu_isa::avx512}) {
+      if (cpu_supports(isa)) {
+        isas.push_back(isa);
+      }
+    }
+    return isas;
+  }
+
+  cpu_isa detect_cpu_isa() {
+    return supported_isas().back();
+  }
+
+  void select_kernel_isa(std::optional<cpu_isa> isa) {
+    const cpu_isa chosen = isa.value_or(detect_cpu_isa());
+    if (!cpu_supports(chosen)) {
+      throw std::runtime_error(std::string("Error: Instruction set not supported on this machine: ") + isa_name(chosen));
+    }
+    active_table.store(&table_for(chosen), std::memory_order_relaxed);
+  }
+
+  cpu_isa active_kernel_isa() {
+    return kernels::active().isa;
+  }
+
+  namespace kernels {
+
+    const table& active() {
+      const table* current = active_table.load(std::memory_order_relaxed);
+      if (current == nullptr) {
+        current = &table_for(detect_cpu_isa());
+        active_table.store(current, std::memory_order_relaxed);
+      }
+      return *current;
+    }
+
+  }
+
+}
@@ -0,0 +1,5 @@
+// Compiled with -mavx2 (see common/CMakeLists.txt) and only called once
+// select_kernel_isa has checked that the CPU supports it.
+#define RENDER_SIMD_AVX2
+#define RENDER_KERNEL_TABLE avx2_table
+#include "simd_kernels.inl"
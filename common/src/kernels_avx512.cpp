@@ -0,0 +1,5 @@
+// Compiled with -mavx512f (see common/CMakeLists.txt) and only called once
+// select_kernel_isa has checked that the CPU supports it.
+#define RENDER_SIMD_AVX512
+#define RENDER_KERNEL_TABLE avx512_table
+#include "simd_kernels.inl"
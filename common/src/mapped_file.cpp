@@ -0,0 +1,173 @@
+#include "mapped_file.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <utility>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define RENDER_HAS_MMAP 1
+#endif
+
+namespace render {
+
+  std::optional<mapped_file> mapped_file::open(const std::string& path) {
+    mapped_file file;
+#if defined(RENDER_HAS_MMAP)
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+      return std::nullopt;
+    }
+    struct stat info{};
+    if (::fstat(fd, &info) != 0 || !S_ISREG(info.st_mode)) {
+      ::close(fd);
+      return std::nullopt;
+    }
+    file.size_ = static_cast<std::size_t>(info.st_size);
+    if (file.size_ > 0) {
+      void* addr = ::mmap(nullptr, file.size_, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (addr == MAP_FAILED) {
+        ::close(fd);
+        return std::nullopt;
+      }
+      // Parsers read front to back, so ask for aggressive read-ahead.
+      ::madvise(addr, file.size_, MADV_SEQUENTIAL);
+      file.data_ = static_cast<const char*>(addr);
+      file.mapped_ = true;
+    }
+    ::close(fd);
+#else
+    std::ifstream in(path, std::ios::binary);
+    if (!in.is_open()) {
+      return std::nullopt;
+    }
+    file.buffer_.assign(std::istreambuf_iterator<char>{in}, std::istreambuf_iterator<char>{});
+    file.data_ = file.buffer_.data();
+    file.size_ = file.buffer_.size();
+#endif
+    return file;
+  }
+
+  mapped_file::mapped_file(mapped_file&& other) noexcept {
+    *this = std::move(other);
+  }
+
+  mapped_file& mapped_file::operator=(mapped_file&& other) noexcept {
+    if (this != &other) {
+      release();
+      mapped_ = std::exchange(other.mapped_, false);
+      size_ = std::exchange(other.size_, 0);
+      buffer_ = std::move(other.buffer_);
+      data_ = std::exchange(other.data_, nullptr);
+    }
+    return *this;
+  }
+
+  mapped_file::~mapped_file() {
+    release();
+  }
+
+  void mapped_file::release() noexcept {
+#if defined(RENDER_HAS_MMAP)
+    if (mapped_) {
+      ::munmap(const_cast<char*>(data_), size_);
+    }
+#endif
+    mapped_ = false;
+    data_ = nullptr;
+    size_ = 0;
+    buffer_.clear();
+  }
+
+  mapped_output_file mapped_output_file::create(const std::string& path, std::size_t size) {
+    mapped_output_file file;
+    file.size_ = size;
+#if defined(RENDER_HAS_MMAP)
+    const int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+      throw std::runtime_error("Error: Could not open output file: " + path);
+    }
+    if (::ftruncate(fd, static_cast<off_t>(size)) != 0) {
+      ::close(fd);
+      throw std::runtime_error("Error: Could not resize output file: " + path);
+    }
+    if (size > 0) {
+      void* addr = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+      if (addr == MAP_FAILED) {
+        ::close(fd);
+        throw std::runtime_error("Error: Could not map output file: " + path);
+      }
+      file.data_ = static_cast<char*>(addr);
+      file.mapped_ = true;
+    }
+    ::close(fd);
+#else
+    if (!std::ofstream(path, std::ios::binary).is_open()) {
+      throw std::runtime_error("Error: Could not open output file: " + path);
+    }
+    file.path_ = path;
+    file.buffer_.assign(size, '\0');
+    file.data_ = file.buffer_.data();
+#endif
+    return file;
+  }
+
+  mapped_output_file::mapped_output_file(mapped_output_file&& other) noexcept {
+    *this = std::move(other);
+  }
+
+  mapped_output_file& mapped_output_file::operator=(mapped_output_file&& other) noexcept {
+    if (this != &other) {
+      release();
+      mapped_ = std::exchange(other.mapped_, false);
+      size_ = std::exchange(other.size_, 0);
+      path_ = std::move(other.path_);
+      buffer_ = std::move(other.buffer_);
+      data_ = std::exchange(other.data_, nullptr);
+    }
+    return *this;
+  }
+
+  mapped_output_file::~mapped_output_file() {
+    release();
+  }
+
+  void mapped_output_file::release_range([[maybe_unused]] std::size_t offset, [[maybe_unused]] std::size_t size) {
+#if defined(RENDER_HAS_MMAP)
+    if (!mapped_ || size == 0) {
+      return;
+    }
+    // Widened to whole pages. Neighbouring ranges may share the edge pages;
+    // with a shared mapping dropping them loses nothing.
+    const auto page = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+    const std::size_t begin = offset / page * page;
+    const std::size_t end = std::min(size_, offset + size);
+    ::msync(data_ + begin, end - begin, MS_ASYNC);
+    ::madvise(data_ + begin, end - begin, MADV_DONTNEED);
+#endif
+  }
+
+  void mapped_output_file::release() noexcept {
+#if defined(RENDER_HAS_MMAP)
+    if (mapped_) {
+      ::munmap(data_, size_);
+    }
+#else
+    if (!path_.empty()) {
+      std::ofstream out(path_, std::ios::binary);
+      out.write(buffer_.data(), static_cast<std::streamsize>(buffer_.size()));
+    }
+#endif
+    mapped_ = false;
+    data_ = nullptr;
+    size_ = 0;
+    path_.clear();
+    buffer_.clear();
+  }
+
+}
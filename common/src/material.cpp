@@ -0,0 +1,34 @@
+#include "material.hpp"
+
+namespace render {
+
+  material_id material_table::add(const material& mat) {
+    const auto id = static_cast<material_id>(entries_.size());
+
+    // The type tag identifies the concrete class, so no dynamic_cast is needed.
+    switch (mat.get_type()) {
+      case material_type::matte: {
+        const auto& matte = static_cast<const matte_material&>(mat);
+        entries_.push_back(entry{material_type::matte, static_cast<std::uint32_t>(matte_.size())});
+        matte_.push_back(matte_params{matte.get_reflectance()});
+        break;
+      }
+      case material_type::metal: {
+        const auto& metal = static_cast<const metal_material&>(mat);
+        entries_.push_back(entry{material_type::metal, static_cast<std::uint32_t>(metal_.size())});
+        metal_.push_back(metal_params{metal.get_reflectance(), metal.get_diffusion()});
+        break;
+      }
+      case material_type::refractive: {
+        const double index = static_cast<const refractive_material&>(mat).get_refraction_index();
+        double r0 = (1.0 - index) / (1.0 + index);
+        r0 = r0 * r0;
+        entries_.push_back(entry{material_type::refractive, static_cast<std::uint32_t>(refractive_.size())});
+        refractive_.push_back(refractive_params{index, 1.0 / index, r0});
+        break;
+      }
+    }
+    return id;
+  }
+
+}
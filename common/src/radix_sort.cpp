@@ -0,0 +1,84 @@
+#include "radix_sort.hpp"
+
+#include <array>
+#include <stdexcept>
+#include <utility>
+
+namespace render {
+
+  namespace {
+
+    constexpr size_t radix = 256;
+
+    template <typename Key>
+    void radix_sort_pairs(std::vector<Key>& keys, std::vector<std::uint32_t>& values, thread_pool& pool) {
+      if (keys.size() != values.size()) {
+        throw std::invalid_argument("radix_sort needs one value per key");
+      }
+
+      const size_t n = keys.size();
+      if (n < 2) {
+        return;
+      }
+
+      std::vector<Key> key_scratch(n);
+      std::vector<std::uint32_t> value_scratch(n);
+      const auto workers = static_cast<size_t>(pool.size());
+      std::vector<std::array<size_t, radix>> counts(workers);
+
+      for (unsigned int shift = 0; shift < 8 * sizeof(Key); shift += 8) {
+        const auto digit = [shift](Key key) { return static_cast<size_t>((key >> shift) & 0xFFU); };
+
+        for (auto& histogram : counts) {
+          histogram.fill(0);
+        }
+        pool.parallel_for(n, [&](size_t begin, size_t end, int worker) {
+          auto& histogram = counts[static_cast<size_t>(worker)];
+          for (size_t i = begin; i < end; ++i) {
+            ++histogram[digit(keys[i])];
+          }
+        });
+
+        // Exclusive prefix sum in (digit, worker) order: worker chunks are
+        // contiguous and in order, so the scatter below is stable.
+        size_t offset = 0;
+        bool trivial = false;
+        for (size_t d = 0; d < radix; ++d) {
+          size_t bucket = 0;
+          for (size_t w = 0; w < workers; ++w) {
+            const size_t count = counts[w][d];
+            counts[w][d] = offset;
+            offset += count;
+            bucket += count;
+          }
+          trivial = trivial || bucket == n;
+        }
+        if (trivial) {
+          continue;
+        }
+
+        pool.parallel_for(n, [&](size_t begin, size_t end, int worker) {
+          auto& next = counts[static_cast<size_t>(worker)];
+          for (size_t i = begin; i < end; ++i) {
+            const size_t slot = next[digit(keys[i])]++;
+            key_scratch[slot] = keys[i];
+            value_scratch[slot] = values[i];
+          }
+        });
+
+        std::swap(keys, key_scratch);
+        std::swap(values, value_scratch);
+      }
+    }
+
+  }
+
+  void radix_sort(std::vector<std::uint32_t>& keys, std::vector<std::uint32_t>& values, thread_pool& pool) {
+    radix_sort_pairs(keys, values, pool);
+  }
+
+  void radix_sort(std::vector<std::uint64_t>& keys, std::vector<std::uint32_t>& values, thread_pool& pool) {
+    radix_sort_pairs(keys, values, pool);
+  }
+
+}
@@ -0,0 +1,179 @@
+#include "random.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+
+namespace render {
+
+  namespace {
+
+    // Wellons' lowbias32 integer hash.
+    constexpr std::uint32_t hash(std::uint32_t x) {
+      x ^= x >> 16;
+      x *= 0x7FEB352DU;
+      x ^= x >> 15;
+      x *= 0x846CA68BU;
+      x ^= x >> 16;
+      return x;
+    }
+
+    constexpr std::uint32_t reverse_bits(std::uint32_t x) {
+      x = ((x >> 1) & 0x55555555U) | ((x & 0x55555555U) << 1);
+      x = ((x >> 2) & 0x33333333U) | ((x & 0x33333333U) << 2);
+      x = ((x >> 4) & 0x0F0F0F0FU) | ((x & 0x0F0F0F0FU) << 4);
+      x = ((x >> 8) & 0x00FF00FFU) | ((x & 0x00FF00FFU) << 8);
+      return (x >> 16) | (x << 16);
+    }
+
+    // Laine-Karras permutation with Vegdahl's constants: each bit is flipped
+    // depending only on the bits below it.
+    constexpr std::uint32_t laine_karras(std::uint32_t x, std::uint32_t seed) {
+      x += seed;
+      x ^= x * 0x6C50B47CU;
+      x ^= x * 0xB82F1E52U;
+      x ^= x * 0xC7AFE638U;
+      x ^= x * 0x8D22F6E6U;
+      return x;
+    }
+
+    // Base-2 Owen scrambling by hashing (Burley, "Practical Hash-based Owen
+    // Scrambling"): each bit is flipped depending only on the bits above it.
+    // Applied to sample indices it shuffles them so that every aligned
+    // power-of-two block of indices still maps to one.
+    constexpr std::uint32_t owen_scramble(std::uint32_t x, std::uint32_t seed) {
+      return reverse_bits(laine_karras(reverse_bits(x), seed));
+    }
+
+    // Owen-scrambled point `index` of the first two Sobol dimensions, as
+    // bits of a binary fraction; scrambling keeps their stratification. The
+    // first dimension is the bit-reversed index. The second multiplies it by
+    // Pascal's triangle mod 2: by Lucas' theorem, digit r is the xor of the
+    // index bits k with r a subset of k, a superset sum done in five steps.
+    // Both are scrambled in bit-reversed order, where the digits that Owen
+    // scrambling conditions on are the lower bits.
+    std::array<std::uint32_t, 2> scrambled_sobol(std::uint32_t index, std::uint32_t seed) {
+      std::uint32_t pascal = index;
+      pascal ^= (pascal >> 1) & 0x55555555U;
+      pascal ^= (pascal >> 2) & 0x33333333U;
+      pascal ^= (pascal >> 4) & 0x0F0F0F0FU;
+      pascal ^= (pascal >> 8) & 0x00FF00FFU;
+      pascal ^= (pascal >> 16) & 0x0000FFFFU;
+      return {reverse_bits(laine_karras(index, hash(seed + 1))), reverse_bits(laine_karras(pascal, hash(seed + 2)))};
+    }
+
+    // Kensler's hashed permutation of [0, length) ("Correlated Multi-Jittered
+    // Sampling"): a bijection on the enclosing power of two, walked until the
+    // value falls back inside the range.
+    std::uint32_t permute(std::uint32_t i, std::uint32_t length, std::uint32_t seed) {
+      std::uint32_t mask = length - 1;
+      mask |= mask >> 1;
+      mask |= mask >> 2;
+      mask |= mask >> 4;
+      mask |= mask >> 8;
+      mask |= mask >> 16;
+      do {
+        i ^= seed;
+        i *= 0xE170893DU;
+        i ^= seed >> 16;
+        i ^= (i & mask) >> 4;
+        i ^= seed >> 8;
+        i *= 0x0929EB3FU;
+        i ^= seed >> 23;
+        i ^= (i & mask) >> 1;
+        i *= 1U | seed >> 27;
+        i *= 0x6935FA69U;
+        i ^= (i & mask) >> 11;
+        i *= 0x74DCB303U;
+        i ^= (i & mask) >> 2;
+        i *= 0x9E501CC3U;
+        i ^= (i & mask) >> 2;
+        i *= 0xC860A3DFU;
+        i &= mask;
+        i ^= i >> 5;
+      } while (i >= length);
+      return (i + seed) % length;
+    }
+
+    // Kensler's hash of an index to a uniform offset within its stratum.
+    double jitter(std::uint32_t i, std::uint32_t seed) {
+      i ^= seed;
+      i ^= i >> 17;
+      i ^= i >> 10;
+      i *= 0xB36534E5U;
+      i ^= i >> 12;
+      i ^= i >> 21;
+      i *= 0x93FC4795U;
+      i ^= 0xDF6E307FU;
+      i ^= i >> 17;
+      i *= 1U | seed >> 18;
+      return static_cast<double>(i) * 0x1.0p-32;
+    }
+
+  }
+
+  void random_stream::fill_block() {
+    if (generated_blocks_ == 0 || bounce_ < generated_blocks_) {
+      // Dimension word 0 of bounce 0 is never used by overflow(), which starts at
+      // dimensions_per_bounce, so the key block cannot collide with a draw.
+      const philox_counter seed = philox4x32(philox_counter{pixel_, sample_, domain_bits_, 0U}, key_);
+      generator_.reseed((static_cast<std::uint64_t>(seed[0]) << 32) | seed[1],
+                        (static_cast<std::uint64_t>(seed[2]) << 32) | seed[3]);
+      generated_blocks_ = 0;
+    }
+
+    while (generated_blocks_ <= bounce_) {
+      generator_.fill_uniform(block_, dimensions_per_bounce);
+      ++generated_blocks_;
+    }
+    block_bounce_ = bounce_;
+    has_block_ = true;
+  }
+
+  double random_stream::overflow(std::uint32_t dimension) const {
+    const philox_counter bits = philox4x32(philox_counter{pixel_, sample_, domain_bits_ | bounce_, dimension}, key_);
+    return to_unit_double(bits[0], bits[1]);
+  }
+
+  std::uint32_t random_stream::scramble_seed(const philox_key& key, std::uint32_t pixel, std::uint32_t domain_bits) {
+    return hash(key[0] ^ hash(key[1] ^ hash(pixel))) ^ domain_bits;
+  }
+
+  double random_stream::pattern_draw(std::uint32_t dimension) {
+    // Pairs are usually drawn in order, so the second coordinate is kept.
+    if (dimension % 2 == 1 && paired_dimension_ == dimension && paired_bounce_ == bounce_) {
+      return paired_;
+    }
+    const std::array<double, 2> point = pattern_point(dimension / 2);
+    paired_bounce_ = bounce_;
+    paired_dimension_ = dimension | 1U;
+    paired_ = point[1];
+    return point[dimension % 2];
+  }
+
+  std::array<double, 2> random_stream::pattern_point(std::uint32_t pair) const {
+    // One scrambling per (seed, pixel, domain, bounce, pair), shared by all
+    // samples of the pixel.
+    const std::uint32_t seed = hash(hash(pattern_seed_ ^ bounce_) ^ pair);
+
+    if (pattern_.sampler == sampler_type::sobol) {
+      const std::array<std::uint32_t, 2> bits = scrambled_sobol(owen_scramble(sample_, seed), seed);
+      return {static_cast<double>(bits[0]) * 0x1.0p-32, static_cast<double>(bits[1]) * 0x1.0p-32};
+    }
+
+    // Correlated multi-jittering over an m x n grid of at least
+    // samples_per_pixel cells: the samples fall in distinct cells, and their
+    // x and y coordinates in distinct columns and rows of the finer grid.
+    const std::uint32_t samples = std::max(pattern_.samples_per_pixel, 1U);
+    const std::uint32_t m = std::max(static_cast<std::uint32_t>(std::sqrt(static_cast<double>(samples))), 1U);
+    const std::uint32_t n = (samples + m - 1) / m;
+    const std::uint32_t s = permute(sample_, m * n, seed * 0x51633E2DU);
+    const std::uint32_t sx = permute(s % m, m, seed * 0x68BC21EBU);
+    const std::uint32_t sy = permute(s / m, n, seed * 0x02E5BE93U);
+    const double x = (static_cast<double>(sx) + (static_cast<double>(sy) + jitter(s, seed * 0x967A889BU)) / static_cast<double>(n)) / static_cast<double>(m);
+    const double y = (static_cast<double>(s / m) + (static_cast<double>(sx) + jitter(s, seed * 0x368CC8B7U)) / static_cast<double>(m)) / static_cast<double>(n);
+    return {x, y};
+  }
+
+}
@@ -1,11 +1,40 @@
 #include "renderer_utils.hpp"
 
+#include "kernel_dispatch.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <charconv>
 #include <cmath>
 #include <fstream>
 #include <iostream>
+#include <limits>
+#include <numbers>
+#include <stdexcept>
 
 namespace render {
 
+  template <typename T>
+  bool continue_path(const render_config& config, int depth, basic_vector<T>& throughput, random_stream& rng) {
+    const T max_component = std::max({throughput.get_x(), throughput.get_y(), throughput.get_z()});
+    if (max_component <= T{0}) {
+      return false;
+    }
+    if (config.russian_roulette_depth == 0 || depth + 1 < config.russian_roulette_depth) {
+      return true;
+    }
+
+    const T survival = std::min(T{1}, max_component);
+    if (rng.uniform() >= survival) {
+      return false;
+    }
+    throughput = throughput / survival;
+    return true;
+  }
+
+  template bool continue_path(const render_config& config, int depth, basic_vector<float>& throughput, random_stream& rng);
+  template bool continue_path(const render_config& config, int depth, basic_vector<double>& throughput, random_stream& rng);
+
   vector gamma_correct(const vector& color, double gamma) {
     const double inv_gamma = 1.0 / gamma;
     return vector{
@@ -27,25 +56,224 @@ namespace render {
     return static_cast<int>(255.999 * component);
   }
 
-  void write_ppm(const std::string& filename, const std::vector<std::vector<vector>>& image, int width, int height) {
-    std::ofstream file(filename);
-    if (!file.is_open()) {
-      throw std::runtime_error("Error: Could not open output file: " + filename);
+  vector sphere_direction(double u, double v) {
+    const double z = 1.0 - 2.0 * u;
+    const double r = std::sqrt(std::max(0.0, 1.0 - z * z));
+    const double phi = 2.0 * std::numbers::pi * v;
+    return vector{r * std::cos(phi), r * std::sin(phi), z};
+  }
+
+  double luminance(const vector& color) {
+    return 0.2126 * color.get_x() + 0.7152 * color.get_y() + 0.0722 * color.get_z();
+  }
+
+  void pixel_estimate::add(const vector& sample) {
+    sum = sum + sample;
+    ++count;
+    const double y = luminance(sample);
+    const double delta = y - luminance_mean;
+    luminance_mean += delta / static_cast<double>(count);
+    luminance_m2 += delta * (y - luminance_mean);
+  }
+
+  bool pixel_estimate::needs_sample(const render_config& config) const {
+    if (count >= config.samples_per_pixel) {
+      return false;
+    }
+    if (config.adaptive_threshold <= 0.0 || count < config.adaptive_min_samples) {
+      return true;
     }
+    const double n = static_cast<double>(count);
+    const double half_width = 1.96 * std::sqrt(luminance_m2 / (n - 1.0) / n);
+    return half_width > config.adaptive_threshold * std::max(luminance_mean, adaptive_luminance_floor);
+  }
 
-    file << "P3\n";
-    file << width << " " << height << "\n";
-    file << "255\n";
+  framebuffer::framebuffer(int width, int height)
+      : width_{width}, height_{height}, components_(static_cast<std::size_t>(width) * static_cast<std::size_t>(height) * 3, 0.0F) {}
 
-    for (int j = height - 1; j >= 0; --j) {
-      for (int i = 0; i < width; ++i) {
-        const vector& color = image[i][j];
-        file << color_to_int(color.get_x()) << " "
-             << color_to_int(color.get_y()) << " "
-             << color_to_int(color.get_z()) << "\n";
+  void framebuffer::set_block(int x, int y, const framebuffer& block) {
+    for (int j = 0; j < block.get_height(); ++j) {
+      const auto row = block.get_row(j);
+      std::copy(row.begin(), row.end(), components_.begin() + static_cast<std::ptrdiff_t>(component_index(x, y + j)));
+    }
+  }
+
+  namespace {
+
+    // The per-component path the thresholds reproduce.
+    std::uint8_t encode_with_pow(float component, double gamma) {
+      const double c = component < 0.0F ? 0.0 : component;
+      return static_cast<std::uint8_t>(color_to_int(clamp_color(gamma_correct(vector{c, c, c}, gamma)).get_x()));
+    }
+
+    // The 8-bit levels of the image, top row first as PPM stores them.
+    std::vector<char> encode_rows(const framebuffer& image, double gamma) {
+      const gamma_encoder encoder{gamma};
+      const auto row_size = static_cast<std::size_t>(image.get_width()) * 3;
+      std::vector<char> bytes(row_size * static_cast<std::size_t>(image.get_height()));
+      auto* out = reinterpret_cast<std::uint8_t*>(bytes.data());
+      for (int j = image.get_height() - 1; j >= 0; --j, out += row_size) {
+        encoder.encode(image.get_row(j).data(), out, row_size);
+      }
+      return bytes;
+    }
+
+    void write_bytes(const std::string& filename, std::span<const char> header, std::span<const char> data) {
+      std::ofstream file(filename, std::ios::binary);
+      if (!file.is_open()) {
+        throw std::runtime_error("Error: Could not open output file: " + filename);
+      }
+      file.write(header.data(), static_cast<std::streamsize>(header.size()));
+      file.write(data.data(), static_cast<std::streamsize>(data.size()));
+      if (!file) {
+        throw std::runtime_error("Error: Could not write output file: " + filename);
       }
     }
+
   }
 
-}
+  gamma_encoder::gamma_encoder(double gamma) : gamma_{gamma}, monotonic_{1.0 / gamma >= 0.0} {
+    if (!monotonic_) {
+      return;
+    }
+    // Non-negative floats order like their bit patterns, so each threshold is
+    // a lower bound over the bits of [0, 1]; 1 always encodes as 255.
+    constexpr auto one_bits = std::bit_cast<std::uint32_t>(1.0F);
+    thresholds_.assign(257, 0.0F);
+    for (std::size_t level = 1; level < 256; ++level) {
+      std::uint32_t low = 0;
+      std::uint32_t high = one_bits;
+      while (low < high) {
+        const std::uint32_t mid = low + (high - low) / 2;
+        if (encode_with_pow(std::bit_cast<float>(mid), gamma) >= level) {
+          high = mid;
+        } else {
+          low = mid + 1;
+        }
+      }
+      thresholds_[level] = std::bit_cast<float>(low);
+    }
+    thresholds_[256] = std::numeric_limits<float>::quiet_NaN();
+
+    const auto level_of = [&](std::uint32_t bits) {
+      return static_cast<int>(std::upper_bound(thresholds_.begin() + 1, thresholds_.begin() + 256, std::bit_cast<float>(bits)) - thresholds_.begin()) - 1;
+    };
+    constexpr std::uint32_t last_bucket = one_bits >> kernels::level_bucket_shift;
+    buckets_.assign(last_bucket + 4, 0);
+    for (std::uint32_t bucket = 0; bucket <= last_bucket; ++bucket) {
+      const std::uint32_t first = bucket << kernels::level_bucket_shift;
+      buckets_[bucket] = static_cast<std::uint8_t>(level_of(first));
+      if (bucket < last_bucket) {
+        const std::uint32_t last = first + (1U << kernels::level_bucket_shift) - 1;
+        steps_ = std::max(steps_, level_of(last) - buckets_[bucket]);
+      }
+    }
+  }
+
+  void gamma_encoder::encode(const float* components, std::uint8_t* levels, std::size_t n) const {
+    if (!monotonic_) {
+      for (std::size_t i = 0; i < n; ++i) {
+        levels[i] = encode_with_pow(components[i], gamma_);
+      }
+      return;
+    }
+    const kernels::level_tables tables{buckets_.data(), thresholds_.data(), steps_};
+    if (const auto kernel = kernels::active().encode_levels) {
+      kernel(tables, components, levels, n);
+      return;
+    }
+    for (std::size_t i = 0; i < n; ++i) {
+      // As clamp_color: NaN and anything above 1 become 1, negatives 0.
+      float c = components[i] < 1.0F ? components[i] : 1.0F;
+      c = c > 0.0F ? c : 0.0F;
+      int level = tables.buckets[std::bit_cast<std::uint32_t>(c) >> kernels::level_bucket_shift];
+      for (int step = 0; step < tables.steps; ++step) {
+        level += c >= tables.thresholds[level + 1] ? 1 : 0;
+      }
+      levels[i] = static_cast<std::uint8_t>(level);
+    }
+  }
+
+  image_format output_format_for(const render_config& config, const std::string& filename) {
+    if (config.output_format) {
+      return *config.output_format;
+    }
+    return filename.ends_with(".pfm") ? image_format::pfm : image_format::p3;
+  }
+
+  std::string image_header(image_format format, int width, int height) {
+    const std::string size = std::to_string(width) + " " + std::to_string(height) + "\n";
+    switch (format) {
+      case image_format::p3:
+        return "P3\n" + size + "255\n";
+      case image_format::p6:
+        return "P6\n" + size + "255\n";
+      case image_format::pfm:
+        // A negative scale marks little-endian samples.
+        return "PF\n" + size + (std::endian::native == std::endian::little ? "-1.0\n" : "1.0\n");
+    }
+    return {};
+  }
+
+  void write_ppm_ascii(const std::string& filename, const framebuffer& image, double gamma) {
+    const std::string header = image_header(image_format::p3, image.get_width(), image.get_height());
+    const std::vector<char> levels = encode_rows(image, gamma);
 
+    // At most "255 255 255\n" per pixel.
+    std::vector<char> text(levels.size() / 3 * 12);
+    char* out = text.data();
+    for (std::size_t k = 0; k < levels.size(); ++k) {
+      out = std::to_chars(out, text.data() + text.size(), static_cast<std::uint8_t>(levels[k])).ptr;
+      *out++ = k % 3 == 2 ? '\n' : ' ';
+    }
+    text.resize(static_cast<std::size_t>(out - text.data()));
+    write_bytes(filename, header, text);
+  }
+
+  void write_ppm(const std::string& filename, const framebuffer& image, double gamma) {
+    const std::string header = image_header(image_format::p6, image.get_width(), image.get_height());
+    const std::vector<char> levels = encode_rows(image, gamma);
+    write_bytes(filename, header, levels);
+  }
+
+  void write_pfm(const std::string& filename, const framebuffer& image) {
+    const std::string header = image_header(image_format::pfm, image.get_width(), image.get_height());
+    const std::span<const float> components = image.get_components();
+    write_bytes(filename, header, std::span<const char>{reinterpret_cast<const char*>(components.data()), components.size_bytes()});
+  }
+
+  void write_image(const std::string& filename, const framebuffer& image, image_format format, double gamma) {
+    switch (format) {
+      case image_format::p3:
+        write_ppm_ascii(filename, image, gamma);
+        return;
+      case image_format::p6:
+        write_ppm(filename, image, gamma);
+        return;
+      case image_format::pfm:
+        write_pfm(filename, image);
+        return;
+    }
+  }
+
+  sample_count_image::sample_count_image(int width, int height, int samples_per_pixel)
+      : width_{width}, height_{height}, max_value_{static_cast<std::uint16_t>(std::clamp(samples_per_pixel, 1, 65535))},
+        counts_(static_cast<std::size_t>(width) * static_cast<std::size_t>(height), 0) {}
+
+  void sample_count_image::write(const std::string& filename) const {
+    const std::string header = "P5\n" + std::to_string(width_) + " " + std::to_string(height_) + "\n" + std::to_string(max_value_) + "\n";
+    // One byte per sample up to 255, else two, most significant first.
+    const bool wide = max_value_ > 255;
+    std::vector<char> data(counts_.size() * (wide ? 2 : 1));
+    for (std::size_t k = 0; k < counts_.size(); ++k) {
+      if (wide) {
+        data[2 * k] = static_cast<char>(counts_[k] >> 8);
+        data[2 * k + 1] = static_cast<char>(counts_[k] & 0xFF);
+      } else {
+        data[k] = static_cast<char>(counts_[k]);
+      }
+    }
+    write_bytes(filename, header, data);
+  }
+
+}
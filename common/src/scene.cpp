@@ -1,202 +1,490 @@
 #include "scene.hpp"
 
 #include "cylinder.hpp"
+#include "mapped_file.hpp"
 #include "material.hpp"
+#include "morton.hpp"
 #include "sphere.hpp"
+#include "thread_pool.hpp"
 #include "vector.hpp"
 
-#include <fstream>
-#include <sstream>
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <limits>
+#include <numeric>
 #include <stdexcept>
+#include <string_view>
+#include <system_error>
+#include <unordered_map>
+#include <utility>
 
 namespace render {
 
-  void scene::add_material(std::shared_ptr<material> mat) {
-    const std::string& name = mat->get_name();
-    if (materials_.find(name) != materials_.end()) {
+  namespace {
+
+    // Bits per axis of the grid the centroids are placed on.
+    constexpr int order_bits = 21;
+
+    std::vector<std::uint32_t> sort_by_keys(const std::uint64_t* keys, std::size_t count) {
+      std::vector<std::uint32_t> order(count);
+      std::iota(order.begin(), order.end(), 0U);
+      std::stable_sort(order.begin(), order.end(), [keys](std::uint32_t a, std::uint32_t b) { return keys[a] < keys[b]; });
+      return order;
+    }
+
+    template <typename T>
+    void permute(std::vector<T>& items, const std::vector<std::uint32_t>& order) {
+      std::vector<T> sorted;
+      sorted.reserve(items.size());
+      for (const std::uint32_t index : order) {
+        sorted.push_back(std::move(items[index]));
+      }
+      items = std::move(sorted);
+    }
+
+  }
+
+  material_id scene::add_material(const material& mat) {
+    const std::string& name = mat.get_name();
+    if (material_ids_.find(name) != material_ids_.end()) {
       throw std::runtime_error("Material with name [" + name + "] already exists");
     }
-    materials_[name] = mat;
+    const material_id id = materials_.add(mat);
+    material_ids_[name] = id;
+    return id;
   }
 
   void scene::add_sphere(std::shared_ptr<sphere> sph) {
-    spheres_.push_back(sph);
+    spheres_.push_back(std::move(sph));
   }
 
   void scene::add_cylinder(std::shared_ptr<cylinder> cyl) {
-    cylinders_.push_back(cyl);
+    cylinders_.push_back(std::move(cyl));
+  }
+
+  void scene::add_sphere(const vector& center, double radius, material_id mat) {
+    spheres_.push_back(std::make_shared<sphere>(center, radius, mat));
+  }
+
+  void scene::add_cylinder(const vector& center, double radius, const vector& axis, material_id mat) {
+    cylinders_.push_back(std::make_shared<cylinder>(center, radius, axis, mat));
+  }
+
+  void scene::reserve(std::size_t num_spheres, std::size_t num_cylinders) {
+    spheres_.reserve(spheres_.size() + num_spheres);
+    cylinders_.reserve(cylinders_.size() + num_cylinders);
   }
 
-  std::shared_ptr<material> scene::get_material(const std::string& name) const {
-    auto it = materials_.find(name);
-    if (it == materials_.end()) {
-      return nullptr;
+  std::optional<material_id> scene::get_material(std::string_view name) const {
+    auto it = material_ids_.find(name);
+    if (it == material_ids_.end()) {
+      return std::nullopt;
     }
     return it->second;
   }
 
-  std::vector<std::string> scene_parser::split_line(const std::string& line) {
-    std::vector<std::string> tokens;
-    std::istringstream iss(line);
-    std::string token;
-    
-    while (iss >> token) {
-      tokens.push_back(token);
+  std::vector<aabb> scene::get_primitive_bounds() const {
+    std::vector<aabb> bounds;
+    bounds.reserve(spheres_.size() + cylinders_.size());
+    for (const auto& sph : spheres_) {
+      bounds.push_back(sph->bounds());
     }
-    
-    return tokens;
+    for (const auto& cyl : cylinders_) {
+      bounds.push_back(cyl->bounds());
+    }
+    return bounds;
   }
 
-  bool scene_parser::is_whitespace(const std::string& line) {
-    for (char c : line) {
-      if (c != ' ' && c != '\t' && c != '\r' && c != '\n') {
-        return false;
-      }
+  primitive_permutation curve_order(std::span<const aabb> bounds, std::size_t num_spheres, primitive_order order) {
+    if (order == primitive_order::file) {
+      primitive_permutation identity{std::vector<std::uint32_t>(num_spheres), std::vector<std::uint32_t>(bounds.size() - num_spheres)};
+      std::iota(identity.spheres.begin(), identity.spheres.end(), 0U);
+      std::iota(identity.cylinders.begin(), identity.cylinders.end(), 0U);
+      return identity;
+    }
+
+    aabb centroid_bounds;
+    for (const aabb& box : bounds) {
+      centroid_bounds.expand(box.centroid());
+    }
+    // Cubic cells: on a flat scene, per-axis scaling would let the thin axis
+    // decide the order as much as the wide ones.
+    double extent = 0.0;
+    for (size_t axis = 0; axis < 3; ++axis) {
+      extent = std::max(extent, centroid_bounds.max[axis] - centroid_bounds.min[axis]);
+    }
+    for (size_t axis = 0; axis < 3; ++axis) {
+      centroid_bounds.max[axis] = centroid_bounds.min[axis] + extent;
+    }
+
+    std::vector<std::uint64_t> keys(bounds.size());
+    for (size_t i = 0; i < bounds.size(); ++i) {
+      const auto q = quantize(bounds[i].centroid(), centroid_bounds, order_bits);
+      keys[i] = order == primitive_order::morton ? morton_encode_63(q[0], q[1], q[2]) : hilbert_encode(q[0], q[1], q[2], order_bits);
     }
-    return true;
+    return primitive_permutation{sort_by_keys(keys.data(), num_spheres), sort_by_keys(keys.data() + num_spheres, bounds.size() - num_spheres)};
   }
 
-  scene scene_parser::parse(const std::string& filename) {
-    std::ifstream file(filename);
-    if (!file.is_open()) {
-      throw std::runtime_error("Error: Could not open scene file: " + filename);
+  void scene::reorder(primitive_order order) {
+    if (order == primitive_order::file) {
+      return;
     }
+    const primitive_permutation permutation = curve_order(get_primitive_bounds(), spheres_.size(), order);
+    permute(spheres_, permutation.spheres);
+    permute(cylinders_, permutation.cylinders);
+  }
 
-    scene sc;
-    std::string line;
-    int line_number = 0;
+  void log_reorder(std::size_t num_primitives, primitive_order order, double milliseconds) {
+    std::cout << "Sorted " << num_primitives << " primitives along a " << (order == primitive_order::morton ? "Morton" : "Hilbert")
+              << " curve: " << milliseconds << " ms\n";
+  }
+
+  namespace {
+
+    // Below this size a file is parsed on the calling thread alone.
+    constexpr std::size_t parallel_parse_min_bytes = std::size_t{1} << 20;
 
-    while (std::getline(file, line)) {
-      line_number++;
+    // Tokens kept per line: enough for the longest entity plus the first
+    // extra token, which error messages quote.
+    constexpr std::size_t max_line_tokens = 10;
 
+    // The characters operator>> skips in the "C" locale.
+    bool is_space(char c) {
+      return c == ' ' || c == '\t' || c == '\n' || c == '\v' || c == '\f' || c == '\r';
+    }
+
+    struct line_tokens {
+      std::array<std::string_view, max_line_tokens> tokens;
+      std::size_t count = 0;
+    };
+
+    line_tokens split_line(std::string_view line) {
+      line_tokens result;
+      std::size_t pos = 0;
+      while (pos < line.size()) {
+        while (pos < line.size() && is_space(line[pos])) {
+          ++pos;
+        }
+        const std::size_t start = pos;
+        while (pos < line.size() && !is_space(line[pos])) {
+          ++pos;
+        }
+        if (pos > start) {
+          if (result.count < max_line_tokens) {
+            result.tokens[result.count] = line.substr(start, pos - start);
+          }
+          ++result.count;
+        }
+      }
+      return result;
+    }
+
+    // Drops what std::getline would keep but the file format ignores.
+    std::string_view trim_line(std::string_view line) {
       while (!line.empty() && (line.back() == ' ' || line.back() == '\t' || line.back() == '\r')) {
-        line.pop_back();
+        line.remove_suffix(1);
       }
+      return line;
+    }
 
-      if (is_whitespace(line)) {
-        continue;
+    // The line starting at offset, as error messages quote it.
+    std::string_view line_at(std::string_view text, std::size_t offset) {
+      const std::size_t end = text.find('\n', offset);
+      return trim_line(text.substr(offset, end == std::string_view::npos ? std::string_view::npos : end - offset));
+    }
+
+    // std::from_chars for plain decimal numbers; anything it does not accept
+    // in full (a leading '+', hex, trailing characters, values stod treats as
+    // out of range) goes through std::stod so results and failures match.
+    double parse_double(std::string_view token) {
+      double value = 0.0;
+      const auto [end, ec] = std::from_chars(token.data(), token.data() + token.size(), value);
+      if (ec == std::errc{} && end == token.data() + token.size() && (value == 0.0 || !(std::abs(value) < std::numeric_limits<double>::min()))) {
+        return value;
       }
+      return std::stod(std::string(token));
+    }
 
-      std::vector<std::string> tokens = split_line(line);
+    std::string line_error(const std::string& what, std::string_view line) {
+      return what + "\nLine: \"" + std::string(line) + "\"";
+    }
+
+    // Entities of one chunk; primitives get their material ids once all
+    // materials are known. Offsets are those of the line starts in the file
+    // and order everything across chunks.
+    struct pending_material {
+      std::unique_ptr<material> mat;
+      std::size_t offset;
+    };
+
+    struct pending_sphere {
+      vector center;
+      double radius;
+      std::string_view material_name;
+      std::size_t offset;
+      material_id mat = 0;
+    };
+
+    struct pending_cylinder {
+      vector center;
+      double radius;
+      vector axis;
+      std::string_view material_name;
+      std::size_t offset;
+      material_id mat = 0;
+    };
 
-      if (tokens.empty()) {
-        continue;
+    struct parse_error {
+      std::size_t offset;
+      std::string message;
+    };
+
+    struct parsed_chunk {
+      std::vector<pending_material> materials;
+      std::vector<pending_sphere> spheres;
+      std::vector<pending_cylinder> cylinders;
+      // The first bad line of the chunk; parsing of the chunk stops there.
+      std::optional<parse_error> error;
+    };
+
+    void check_color(double r, double g, double b, const char* what, std::string_view line) {
+      if (r < 0.0 || r > 1.0 || g < 0.0 || g > 1.0 || b < 0.0 || b > 1.0) {
+        throw std::runtime_error(line_error(std::string("Error: Invalid ") + what + " material parameters", line));
       }
+    }
 
-      try {
-        const std::string& first = tokens[0];
+    void parse_line(std::string_view line, std::size_t offset, parsed_chunk& chunk) {
+      const line_tokens split = split_line(line);
+      if (split.count == 0) {
+        return;
+      }
+      const auto& tokens = split.tokens;
+      const std::string_view first = tokens[0];
 
-        if (first == "matte:") {
-          if (tokens.size() != 5) {
-            throw std::runtime_error("Error: Invalid matte material parameters\nLine: \"" + line + "\"");
-          }
-          const std::string& name = tokens[1];
-          const double r = std::stod(tokens[2]);
-          const double g = std::stod(tokens[3]);
-          const double b = std::stod(tokens[4]);
-          
-          if (r < 0.0 || r > 1.0 || g < 0.0 || g > 1.0 || b < 0.0 || b > 1.0) {
-            throw std::runtime_error("Error: Invalid matte material parameters\nLine: \"" + line + "\"");
-          }
-          
-          sc.add_material(std::make_shared<matte_material>(name, r, g, b));
+      if (first == "matte:") {
+        if (split.count != 5) {
+          throw std::runtime_error(line_error("Error: Invalid matte material parameters", line));
         }
-        else if (first == "metal:") {
-          if (tokens.size() != 6) {
-            throw std::runtime_error("Error: Invalid metal material parameters\nLine: \"" + line + "\"");
-          }
-          const std::string& name = tokens[1];
-          const double r = std::stod(tokens[2]);
-          const double g = std::stod(tokens[3]);
-          const double b = std::stod(tokens[4]);
-          const double diffusion = std::stod(tokens[5]);
-          
-          if (r < 0.0 || r > 1.0 || g < 0.0 || g > 1.0 || b < 0.0 || b > 1.0) {
-            throw std::runtime_error("Error: Invalid metal material parameters\nLine: \"" + line + "\"");
-          }
-          
-          sc.add_material(std::make_shared<metal_material>(name, r, g, b, diffusion));
+        const double r = parse_double(tokens[2]);
+        const double g = parse_double(tokens[3]);
+        const double b = parse_double(tokens[4]);
+        check_color(r, g, b, "matte", line);
+        chunk.materials.push_back({std::make_unique<matte_material>(std::string(tokens[1]), r, g, b), offset});
+      }
+      else if (first == "metal:") {
+        if (split.count != 6) {
+          throw std::runtime_error(line_error("Error: Invalid metal material parameters", line));
         }
-        else if (first == "refractive:") {
-          if (tokens.size() != 3) {
-            throw std::runtime_error("Error: Invalid refractive material parameters\nLine: \"" + line + "\"");
-          }
-          const std::string& name = tokens[1];
-          const double refraction_index = std::stod(tokens[2]);
-          
-          if (refraction_index <= 0.0) {
-            throw std::runtime_error("Error: Invalid refractive material parameters\nLine: \"" + line + "\"");
-          }
-          
-          sc.add_material(std::make_shared<refractive_material>(name, refraction_index));
+        const double r = parse_double(tokens[2]);
+        const double g = parse_double(tokens[3]);
+        const double b = parse_double(tokens[4]);
+        const double diffusion = parse_double(tokens[5]);
+        check_color(r, g, b, "metal", line);
+        chunk.materials.push_back({std::make_unique<metal_material>(std::string(tokens[1]), r, g, b, diffusion), offset});
+      }
+      else if (first == "refractive:") {
+        if (split.count != 3) {
+          throw std::runtime_error(line_error("Error: Invalid refractive material parameters", line));
         }
-        else if (first == "sphere:") {
-          if (tokens.size() < 6) {
-            throw std::runtime_error("Error: Invalid sphere parameters\nLine: \"" + line + "\"");
-          }
-          if (tokens.size() > 6) {
-            throw std::runtime_error("Error: Extra data after configuration value for key: [sphere:]\nExtra: \"" + tokens[6] + "\"\nLine: \"" + line + "\"");
-          }
-          
-          const double cx = std::stod(tokens[1]);
-          const double cy = std::stod(tokens[2]);
-          const double cz = std::stod(tokens[3]);
-          const double radius = std::stod(tokens[4]);
-          const std::string& mat_name = tokens[5];
-          
-          if (radius <= 0.0) {
-            throw std::runtime_error("Error: Invalid sphere parameters\nLine: \"" + line + "\"");
-          }
-          
-          auto mat = sc.get_material(mat_name);
-          if (!mat) {
-            throw std::runtime_error("Error: Material not found: [" + mat_name + "]\nLine: \"" + line + "\"");
-          }
-          
-          sc.add_sphere(std::make_shared<sphere>(vector{cx, cy, cz}, radius, mat));
+        const double refraction_index = parse_double(tokens[2]);
+        if (refraction_index <= 0.0) {
+          throw std::runtime_error(line_error("Error: Invalid refractive material parameters", line));
         }
-        else if (first == "cylinder:") {
-          if (tokens.size() < 9) {
-            throw std::runtime_error("Error: Invalid cylinder parameters\nLine: \"" + line + "\"");
-          }
-          if (tokens.size() > 9) {
-            throw std::runtime_error("Error: Extra data after configuration value for key: [cylinder:]\nExtra: \"" + tokens[9] + "\"\nLine: \"" + line + "\"");
-          }
-          
-          const double cx = std::stod(tokens[1]);
-          const double cy = std::stod(tokens[2]);
-          const double cz = std::stod(tokens[3]);
-          const double radius = std::stod(tokens[4]);
-          const double ax = std::stod(tokens[5]);
-          const double ay = std::stod(tokens[6]);
-          const double az = std::stod(tokens[7]);
-          const std::string& mat_name = tokens[8];
-          
-          if (radius <= 0.0) {
-            throw std::runtime_error("Error: Invalid cylinder parameters\nLine: \"" + line + "\"");
-          }
-          
-          auto mat = sc.get_material(mat_name);
-          if (!mat) {
-            throw std::runtime_error("Error: Material not found: [" + mat_name + "]\nLine: \"" + line + "\"");
-          }
-          
-          sc.add_cylinder(std::make_shared<cylinder>(vector{cx, cy, cz}, radius, vector{ax, ay, az}, mat));
+        chunk.materials.push_back({std::make_unique<refractive_material>(std::string(tokens[1]), refraction_index), offset});
+      }
+      else if (first == "sphere:") {
+        if (split.count < 6) {
+          throw std::runtime_error(line_error("Error: Invalid sphere parameters", line));
+        }
+        if (split.count > 6) {
+          throw std::runtime_error(line_error("Error: Extra data after configuration value for key: [sphere:]\nExtra: \"" + std::string(tokens[6]) + "\"", line));
+        }
+        const double cx = parse_double(tokens[1]);
+        const double cy = parse_double(tokens[2]);
+        const double cz = parse_double(tokens[3]);
+        const double radius = parse_double(tokens[4]);
+        if (radius <= 0.0) {
+          throw std::runtime_error(line_error("Error: Invalid sphere parameters", line));
+        }
+        chunk.spheres.push_back({vector{cx, cy, cz}, radius, tokens[5], offset});
+      }
+      else if (first == "cylinder:") {
+        if (split.count < 9) {
+          throw std::runtime_error(line_error("Error: Invalid cylinder parameters", line));
+        }
+        if (split.count > 9) {
+          throw std::runtime_error(line_error("Error: Extra data after configuration value for key: [cylinder:]\nExtra: \"" + std::string(tokens[9]) + "\"", line));
+        }
+        const double cx = parse_double(tokens[1]);
+        const double cy = parse_double(tokens[2]);
+        const double cz = parse_double(tokens[3]);
+        const double radius = parse_double(tokens[4]);
+        const double ax = parse_double(tokens[5]);
+        const double ay = parse_double(tokens[6]);
+        const double az = parse_double(tokens[7]);
+        if (radius <= 0.0) {
+          throw std::runtime_error(line_error("Error: Invalid cylinder parameters", line));
+        }
+        chunk.cylinders.push_back({vector{cx, cy, cz}, radius, vector{ax, ay, az}, tokens[8], offset});
+      }
+      else {
+        throw std::runtime_error("Error: Unknown scene entity: " + std::string(first));
+      }
+    }
+
+    // Parses the lines starting in [begin, end), which both lie on line starts.
+    void parse_chunk(std::string_view text, std::size_t begin, std::size_t end, parsed_chunk& chunk) {
+      std::size_t pos = begin;
+      while (pos < end) {
+        const std::size_t newline = text.find('\n', pos);
+        const std::size_t line_end = newline == std::string_view::npos ? text.size() : newline;
+        const std::string_view line = trim_line(text.substr(pos, line_end - pos));
+        try {
+          parse_line(line, pos, chunk);
+        }
+        catch (const std::runtime_error& e) {
+          chunk.error = parse_error{pos, e.what()};
+          return;
         }
-        else {
-          throw std::runtime_error("Error: Unknown scene entity: " + first);
+        catch (const std::exception&) {
+          chunk.error = parse_error{pos, line_error("Error: Invalid scene file format", line)};
+          return;
         }
+        pos = line_end + 1;
       }
-      catch (const std::runtime_error& e) {
-        throw;
+    }
+
+    // Splits the text into `count` ranges of about equal size that start on
+    // line starts; returns count + 1 boundaries.
+    std::vector<std::size_t> chunk_bounds(std::string_view text, std::size_t count) {
+      std::vector<std::size_t> bounds{0};
+      for (std::size_t i = 1; i < count; ++i) {
+        const std::size_t newline = text.find('\n', text.size() * i / count);
+        const std::size_t start = newline == std::string_view::npos ? text.size() : newline + 1;
+        bounds.push_back(std::max(start, bounds.back()));
       }
-      catch (const std::exception& e) {
-        throw std::runtime_error("Error: Invalid scene file format\nLine: \"" + line + "\"");
+      bounds.push_back(text.size());
+      return bounds;
+    }
+
+    struct material_definition {
+      material_id id;
+      std::size_t offset;
+    };
+
+    void keep_earliest(std::optional<parse_error>& current, std::optional<parse_error> candidate) {
+      if (candidate && (!current || candidate->offset < current->offset)) {
+        current = std::move(candidate);
       }
     }
 
+  }
+
+  scene scene_parser::parse(const std::string& filename, int threads) {
+    scene sc;
+    parse(filename, sc, threads);
     return sc;
   }
 
-}
+  void scene_parser::parse(const std::string& filename, scene_builder& builder, int threads) {
+    const std::optional<mapped_file> file = mapped_file::open(filename);
+    if (!file) {
+      throw std::runtime_error("Error: Could not open scene file: " + filename);
+    }
+    const std::string_view text = file->contents();
+
+    const int workers = text.size() < parallel_parse_min_bytes ? 1 : thread_pool::resolve_thread_count(threads);
+    thread_pool pool{workers};
+    const std::vector<std::size_t> bounds = chunk_bounds(text, static_cast<std::size_t>(workers));
+
+    std::vector<parsed_chunk> chunks(static_cast<std::size_t>(workers));
+    pool.parallel_for(chunks.size(), [&](size_t begin, size_t end, int) {
+      for (size_t c = begin; c < end; ++c) {
+        parse_chunk(text, bounds[c], bounds[c + 1], chunks[c]);
+      }
+    });
+
+    // Nothing from the first bad line on takes part, just as if reading had
+    // stopped there.
+    std::optional<parse_error> error;
+    std::size_t num_spheres = 0;
+    std::size_t num_cylinders = 0;
+    for (parsed_chunk& chunk : chunks) {
+      keep_earliest(error, std::move(chunk.error));
+      num_spheres += chunk.spheres.size();
+      num_cylinders += chunk.cylinders.size();
+    }
+    std::size_t limit = error ? error->offset : text.size();
+    builder.reserve(num_spheres, num_cylinders);
+
+    // Materials are few; add them in file order, remembering where each was
+    // defined so primitives cannot use one defined further down.
+    std::unordered_map<std::string_view, material_definition> definitions;
+    for (const parsed_chunk& chunk : chunks) {
+      for (const pending_material& pending : chunk.materials) {
+        if (pending.offset >= limit) {
+          break;
+        }
+        const std::string& name = pending.mat->get_name();
+        if (definitions.contains(name)) {
+          error = parse_error{pending.offset, "Material with name [" + name + "] already exists"};
+          limit = pending.offset;
+          break;
+        }
+        definitions.emplace(name, material_definition{builder.add_material(*pending.mat), pending.offset});
+      }
+    }
+
+    // Resolve material names in parallel; spheres and cylinders are listed
+    // apart, so each kind stops at its own first failure and the earlier of
+    // the two is kept.
+    std::vector<std::optional<parse_error>> resolve_errors(chunks.size());
+    pool.parallel_for(chunks.size(), [&](size_t begin, size_t end, int) {
+      for (size_t c = begin; c < end; ++c) {
+        const auto resolve = [&](auto& primitives) {
+          std::optional<parse_error> failure;
+          for (auto& pending : primitives) {
+            if (pending.offset >= limit) {
+              break;
+            }
+            // A primitive may only use a material defined above it.
+            const auto it = definitions.find(pending.material_name);
+            if (it == definitions.end() || it->second.offset > pending.offset) {
+              failure = parse_error{pending.offset, line_error("Error: Material not found: [" + std::string(pending.material_name) + "]",
+                                                               line_at(text, pending.offset))};
+              break;
+            }
+            pending.mat = it->second.id;
+          }
+          return failure;
+        };
+        keep_earliest(resolve_errors[c], resolve(chunks[c].spheres));
+        keep_earliest(resolve_errors[c], resolve(chunks[c].cylinders));
+      }
+    });
+
+    for (std::optional<parse_error>& chunk_error : resolve_errors) {
+      keep_earliest(error, std::move(chunk_error));
+    }
+    if (error) {
+      throw std::runtime_error(error->message);
+    }
 
+    // Hand over chunk by chunk, releasing each once it is delivered.
+    for (parsed_chunk& chunk : chunks) {
+      for (const pending_sphere& pending : chunk.spheres) {
+        builder.add_sphere(pending.center, pending.radius, pending.mat);
+      }
+      for (const pending_cylinder& pending : chunk.cylinders) {
+        builder.add_cylinder(pending.center, pending.radius, pending.axis, pending.mat);
+      }
+      chunk = parsed_chunk{};
+    }
+  }
+
+}
@@ -0,0 +1,74 @@
+#include "scene_layout.hpp"
+
+#include <cstdint>
+#include <limits>
+
+namespace render {
+
+  template <typename T>
+  std::optional<ray_hit> aos_layout<T>::find_closest_primitive(const basic_ray<T>& r, const std::optional<bvh>& accel) const {
+    constexpr T t_min = static_cast<T>(0.0001);
+    const auto spheres = scene_->get_spheres();
+    const auto cylinders = scene_->get_cylinders();
+    std::optional<ray_hit> closest;
+
+    if (accel) {
+      // t_max only ever holds T values, so narrowing it back is exact.
+      accel->traverse(r, t_min, std::numeric_limits<T>::max(), [&](std::uint32_t prim, double t_max) -> std::optional<double> {
+        if (prim < spheres.size()) {
+          const auto t = spheres[prim].hit_distance(r, t_min, static_cast<T>(t_max));
+          if (!t) {
+            return std::nullopt;
+          }
+          closest = ray_hit{*t, primitive_kind::sphere, prim};
+          return *t;
+        }
+        const auto index = static_cast<std::uint32_t>(prim - spheres.size());
+        const auto t = cylinders[index].hit_distance(r, t_min, static_cast<T>(t_max));
+        if (!t) {
+          return std::nullopt;
+        }
+        closest = ray_hit{*t, primitive_kind::cylinder, index};
+        return *t;
+      });
+      return closest;
+    }
+
+    T t_max = std::numeric_limits<T>::max();
+
+    for (std::uint32_t i = 0; i < spheres.size(); ++i) {
+      if (const auto t = spheres[i].hit_distance(r, t_min, t_max)) {
+        t_max = *t;
+        closest = ray_hit{*t, primitive_kind::sphere, i};
+      }
+    }
+
+    for (std::uint32_t i = 0; i < cylinders.size(); ++i) {
+      if (const auto t = cylinders[i].hit_distance(r, t_min, t_max)) {
+        t_max = *t;
+        closest = ray_hit{*t, primitive_kind::cylinder, i};
+      }
+    }
+
+    return closest;
+  }
+
+  template <typename T>
+  void aos_layout<T>::find_closest_primitives(const ray_packet& packet, const std::optional<bvh>& accel, packet_ray_hits& hits) const {
+    for (std::size_t k = 0; k < packet.count; ++k) {
+      hits[k] = find_closest_primitive(basic_ray<T>{packet.get_ray(k)}, accel);
+    }
+  }
+
+  template <typename T>
+  basic_hit_info<T> aos_layout<T>::surface_at(const basic_ray<T>& r, const ray_hit& hit) const {
+    if (hit.kind == primitive_kind::sphere) {
+      return scene_->get_spheres()[hit.index].surface_at(r, static_cast<T>(hit.t));
+    }
+    return scene_->get_cylinders()[hit.index].surface_at(r, static_cast<T>(hit.t));
+  }
+
+  template class aos_layout<float>;
+  template class aos_layout<double>;
+
+}
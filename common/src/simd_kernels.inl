@@ -0,0 +1,441 @@
+// Body of one kernel variant. Included by kernels_avx2.cpp and
+// kernels_avx512.cpp after they define RENDER_SIMD_AVX2 or RENDER_SIMD_AVX512
+// and RENDER_KERNEL_TABLE, the name of the table to define. Everything here
+// has internal linkage, and only plain doubles, the simd:: wrappers and the
+// POD kernel structs are touched, so no inline function shared with the
+// portable code is compiled with this file's instruction set.
+
+#include "kernel_dispatch.hpp"
+#include "simd_lanes.hpp"
+
+#include <cstring>
+
+namespace render::kernels {
+
+  namespace {
+
+    using simd::vdouble;
+    using simd::vmask;
+
+    // render::column_offset, as a local copy for the reason given above.
+    template <typename Lanes>
+    std::size_t block_offset(const Lanes& lanes, std::size_t i) {
+      return i / kernel_lane_padding * lanes.block_stride + i % kernel_lane_padding;
+    }
+
+    // Per-lane running minimum: each lane keeps the closest t of the
+    // primitives it has seen and the index they came from.
+    struct lane_best {
+      vdouble t;
+      vdouble index;
+
+      void update(vmask hit, vdouble candidate_t, vdouble candidate_index) {
+        t = simd::select(hit, candidate_t, t);
+        index = simd::select(hit, candidate_index, index);
+      }
+
+      // Folds the lanes into one: smallest t, then lowest index.
+      void reduce(flat_hit& best) const {
+        alignas(64) double lane_t[simd::lanes];
+        alignas(64) double lane_index[simd::lanes];
+        simd::store(lane_t, t);
+        simd::store(lane_index, index);
+
+        for (std::size_t lane = 0; lane < simd::lanes; ++lane) {
+          if (lane_index[lane] < 0.0) {
+            continue;
+          }
+          const auto i = static_cast<std::int64_t>(lane_index[lane]);
+          if (lane_t[lane] < best.t || (best.index >= 0 && lane_t[lane] == best.t && i < best.index)) {
+            best = flat_hit{lane_t[lane], i};
+          }
+        }
+      }
+    };
+
+    std::size_t closest_spheres(const sphere_lanes& spheres, const flat_ray& r, double t_min, flat_hit& best) {
+      const double* d = r.direction;
+      const double a = d[0] * d[0] + d[1] * d[1] + d[2] * d[2];
+
+      const vdouble ox = simd::broadcast(r.origin[0]);
+      const vdouble oy = simd::broadcast(r.origin[1]);
+      const vdouble oz = simd::broadcast(r.origin[2]);
+      const vdouble dx = simd::broadcast(d[0]);
+      const vdouble dy = simd::broadcast(d[1]);
+      const vdouble dz = simd::broadcast(d[2]);
+      const vdouble two = simd::broadcast(2.0);
+      const vdouble two_a = simd::broadcast(2.0 * a);
+      const vdouble four_a = simd::broadcast(4.0 * a);
+      const vdouble zero = simd::broadcast(0.0);
+      const vdouble minus_one = simd::broadcast(-1.0);
+      const vdouble lower = simd::broadcast(t_min);
+      const vdouble offsets = simd::lane_offsets();
+
+      lane_best lanes{simd::broadcast(best.t), minus_one};
+
+      const std::size_t full = spheres.count - spheres.count % simd::lanes;
+      for (std::size_t i = 0; i < full; i += simd::lanes) {
+        const std::size_t offset = block_offset(spheres, i);
+        const vdouble ocx = ox - simd::load(spheres.centers_x + offset);
+        const vdouble ocy = oy - simd::load(spheres.centers_y + offset);
+        const vdouble ocz = oz - simd::load(spheres.centers_z + offset);
+        const vdouble radius = simd::load(spheres.radii + offset);
+
+        const vdouble b = two * (ocx * dx + ocy * dy + ocz * dz);
+        const vdouble c = (ocx * ocx + ocy * ocy + ocz * ocz) - radius * radius;
+        const vdouble discriminant = b * b - four_a * c;
+        const vmask real_roots = simd::greater_equal(discriminant, zero);
+        if (simd::none(real_roots)) {
+          // Most rays miss most spheres; skip the square root and divisions.
+          continue;
+        }
+
+        const vdouble sqrt_d = simd::sqrt(discriminant);
+        const vdouble minus_b = zero - b;
+        const vdouble t1 = (minus_b - sqrt_d) / two_a;
+        const vdouble t2 = (minus_b + sqrt_d) / two_a;
+        vdouble t = simd::select(simd::greater(t2, lower), t2, minus_one);
+        t = simd::select(simd::greater(t1, lower), t1, t);
+
+        const vmask hit = simd::both(real_roots, simd::both(simd::greater(t, lower), simd::less(t, lanes.t)));
+        lanes.update(hit, t, simd::broadcast(static_cast<double>(i)) + offsets);
+      }
+
+      lanes.reduce(best);
+      return full;
+    }
+
+    std::size_t closest_cylinders(const cylinder_lanes& cylinders, const flat_ray& r, double t_min, flat_hit& best) {
+      const vdouble ox = simd::broadcast(r.origin[0]);
+      const vdouble oy = simd::broadcast(r.origin[1]);
+      const vdouble oz = simd::broadcast(r.origin[2]);
+      const vdouble dx = simd::broadcast(r.direction[0]);
+      const vdouble dy = simd::broadcast(r.direction[1]);
+      const vdouble dz = simd::broadcast(r.direction[2]);
+      const vdouble two = simd::broadcast(2.0);
+      const vdouble four = simd::broadcast(4.0);
+      const vdouble zero = simd::broadcast(0.0);
+      const vdouble epsilon = simd::broadcast(parallel_epsilon);
+      const vdouble lower = simd::broadcast(t_min);
+      const vdouble offsets = simd::lane_offsets();
+
+      lane_best lanes{simd::broadcast(best.t), simd::broadcast(-1.0)};
+
+      const std::size_t full = cylinders.count - cylinders.count % simd::lanes;
+      for (std::size_t i = 0; i < full; i += simd::lanes) {
+        const std::size_t offset = block_offset(cylinders, i);
+        const vdouble cx = simd::load(cylinders.centers_x + offset);
+        const vdouble cy = simd::load(cylinders.centers_y + offset);
+        const vdouble cz = simd::load(cylinders.centers_z + offset);
+        const vdouble ax = simd::load(cylinders.unit_axes_x + offset);
+        const vdouble ay = simd::load(cylinders.unit_axes_y + offset);
+        const vdouble az = simd::load(cylinders.unit_axes_z + offset);
+        const vdouble radius_squared = simd::load(cylinders.radii_squared + offset);
+        const vdouble index = simd::broadcast(static_cast<double>(i)) + offsets;
+
+        const vdouble ocx = ox - cx;
+        const vdouble ocy = oy - cy;
+        const vdouble ocz = oz - cz;
+
+        const vdouble dir_axis = dx * ax + dy * ay + dz * az;
+        const vdouble dpx = dx - ax * dir_axis;
+        const vdouble dpy = dy - ay * dir_axis;
+        const vdouble dpz = dz - az * dir_axis;
+        const vdouble oc_axis = ocx * ax + ocy * ay + ocz * az;
+        const vdouble opx = ocx - ax * oc_axis;
+        const vdouble opy = ocy - ay * oc_axis;
+        const vdouble opz = ocz - az * oc_axis;
+
+        const vdouble a = dpx * dpx + dpy * dpy + dpz * dpz;
+        const vdouble b = two * (dpx * opx + dpy * opy + dpz * opz);
+        const vdouble c = (opx * opx + opy * opy + opz * opz) - radius_squared;
+        const vdouble discriminant = b * b - four * a * c;
+
+        const vmask side = simd::both(simd::greater_equal(discriminant, zero), simd::greater(a, epsilon));
+        if (!simd::none(side)) {
+          const vdouble half_height = simd::load(cylinders.half_heights + offset);
+          const vdouble sqrt_d = simd::sqrt(discriminant);
+          const vdouble minus_b = zero - b;
+          const vdouble two_a = two * a;
+          for (const vdouble t : {(minus_b - sqrt_d) / two_a, (minus_b + sqrt_d) / two_a}) {
+            const vdouble projection = ((ox + dx * t) - cx) * ax + ((oy + dy * t) - cy) * ay + ((oz + dz * t) - cz) * az;
+            const vmask hit = simd::both(simd::both(side, simd::greater(t, lower)),
+                                         simd::both(simd::less(t, lanes.t), simd::less_equal(simd::abs(projection), half_height)));
+            lanes.update(hit, t, index);
+          }
+        }
+
+        const vmask caps = simd::greater(simd::abs(dir_axis), epsilon);
+        if (!simd::none(caps)) {
+          const double* cap_x[] = {cylinders.top_centers_x, cylinders.bottom_centers_x};
+          const double* cap_y[] = {cylinders.top_centers_y, cylinders.bottom_centers_y};
+          const double* cap_z[] = {cylinders.top_centers_z, cylinders.bottom_centers_z};
+          for (std::size_t cap = 0; cap < 2; ++cap) {
+            const vdouble kx = simd::load(cap_x[cap] + offset);
+            const vdouble ky = simd::load(cap_y[cap] + offset);
+            const vdouble kz = simd::load(cap_z[cap] + offset);
+            const vdouble t = ((kx - ox) * ax + (ky - oy) * ay + (kz - oz) * az) / dir_axis;
+            const vdouble qx = (ox + dx * t) - kx;
+            const vdouble qy = (oy + dy * t) - ky;
+            const vdouble qz = (oz + dz * t) - kz;
+            const vmask hit = simd::both(simd::both(caps, simd::greater(t, lower)),
+                                         simd::both(simd::less(t, lanes.t), simd::less_equal(qx * qx + qy * qy + qz * qz, radius_squared)));
+            lanes.update(hit, t, index);
+          }
+        }
+      }
+
+      lanes.reduce(best);
+      return full;
+    }
+
+    // Packet kernels: one primitive at a time against simd::lanes rays, so each
+    // primitive is loaded once per packet instead of once per ray.
+    void packet_spheres(const sphere_lanes& spheres, std::size_t begin, std::size_t end, std::uint32_t first_primitive,
+                        const ray_packet& packet, double t_min, packet_hits& hits) {
+      const vdouble two = simd::broadcast(2.0);
+      const vdouble four = simd::broadcast(4.0);
+      const vdouble zero = simd::broadcast(0.0);
+      const vdouble minus_one = simd::broadcast(-1.0);
+      const vdouble lower = simd::broadcast(t_min);
+      const std::size_t active = (packet.count + simd::lanes - 1) / simd::lanes * simd::lanes;
+
+      for (std::size_t k = 0; k < active; k += simd::lanes) {
+        const vdouble ox = simd::load(packet.origin_x + k);
+        const vdouble oy = simd::load(packet.origin_y + k);
+        const vdouble oz = simd::load(packet.origin_z + k);
+        const vdouble dx = simd::load(packet.direction_x + k);
+        const vdouble dy = simd::load(packet.direction_y + k);
+        const vdouble dz = simd::load(packet.direction_z + k);
+        const vdouble a = dx * dx + dy * dy + dz * dz;
+        const vdouble two_a = two * a;
+        const vdouble four_a = four * a;
+        lane_best lanes{simd::load(hits.t + k), simd::load(hits.primitive + k)};
+
+        for (std::size_t i = begin; i < end; ++i) {
+          const std::size_t offset = block_offset(spheres, i);
+          const vdouble ocx = ox - simd::broadcast(spheres.centers_x[offset]);
+          const vdouble ocy = oy - simd::broadcast(spheres.centers_y[offset]);
+          const vdouble ocz = oz - simd::broadcast(spheres.centers_z[offset]);
+          const vdouble radius_squared = simd::broadcast(spheres.radii[offset] * spheres.radii[offset]);
+
+          const vdouble b = two * (ocx * dx + ocy * dy + ocz * dz);
+          const vdouble c = (ocx * ocx + ocy * ocy + ocz * ocz) - radius_squared;
+          const vdouble discriminant = b * b - four_a * c;
+          const vmask real_roots = simd::greater_equal(discriminant, zero);
+          if (simd::none(real_roots)) {
+            continue;
+          }
+
+          const vdouble sqrt_d = simd::sqrt(discriminant);
+          const vdouble minus_b = zero - b;
+          const vdouble t1 = (minus_b - sqrt_d) / two_a;
+          const vdouble t2 = (minus_b + sqrt_d) / two_a;
+          vdouble t = simd::select(simd::greater(t2, lower), t2, minus_one);
+          t = simd::select(simd::greater(t1, lower), t1, t);
+
+          const vmask hit = simd::both(real_roots, simd::both(simd::greater(t, lower), simd::less(t, lanes.t)));
+          lanes.update(hit, t, simd::broadcast(static_cast<double>(first_primitive + i)));
+        }
+
+        simd::store(hits.t + k, lanes.t);
+        simd::store(hits.primitive + k, lanes.index);
+      }
+    }
+
+    void packet_cylinders(const cylinder_lanes& cylinders, std::size_t begin, std::size_t end, std::uint32_t first_primitive,
+                          const ray_packet& packet, double t_min, packet_hits& hits) {
+      const vdouble two = simd::broadcast(2.0);
+      const vdouble four = simd::broadcast(4.0);
+      const vdouble zero = simd::broadcast(0.0);
+      const vdouble epsilon = simd::broadcast(parallel_epsilon);
+      const vdouble lower = simd::broadcast(t_min);
+      const std::size_t active = (packet.count + simd::lanes - 1) / simd::lanes * simd::lanes;
+
+      for (std::size_t k = 0; k < active; k += simd::lanes) {
+        const vdouble ox = simd::load(packet.origin_x + k);
+        const vdouble oy = simd::load(packet.origin_y + k);
+        const vdouble oz = simd::load(packet.origin_z + k);
+        const vdouble dx = simd::load(packet.direction_x + k);
+        const vdouble dy = simd::load(packet.direction_y + k);
+        const vdouble dz = simd::load(packet.direction_z + k);
+        lane_best lanes{simd::load(hits.t + k), simd::load(hits.primitive + k)};
+
+        for (std::size_t i = begin; i < end; ++i) {
+          const std::size_t offset = block_offset(cylinders, i);
+          const vdouble cx = simd::broadcast(cylinders.centers_x[offset]);
+          const vdouble cy = simd::broadcast(cylinders.centers_y[offset]);
+          const vdouble cz = simd::broadcast(cylinders.centers_z[offset]);
+          const vdouble ax = simd::broadcast(cylinders.unit_axes_x[offset]);
+          const vdouble ay = simd::broadcast(cylinders.unit_axes_y[offset]);
+          const vdouble az = simd::broadcast(cylinders.unit_axes_z[offset]);
+          const vdouble radius_squared = simd::broadcast(cylinders.radii_squared[offset]);
+          const vdouble index = simd::broadcast(static_cast<double>(first_primitive + i));
+
+          const vdouble ocx = ox - cx;
+          const vdouble ocy = oy - cy;
+          const vdouble ocz = oz - cz;
+
+          const vdouble dir_axis = dx * ax + dy * ay + dz * az;
+          const vdouble dpx = dx - ax * dir_axis;
+          const vdouble dpy = dy - ay * dir_axis;
+          const vdouble dpz = dz - az * dir_axis;
+          const vdouble oc_axis = ocx * ax + ocy * ay + ocz * az;
+          const vdouble opx = ocx - ax * oc_axis;
+          const vdouble opy = ocy - ay * oc_axis;
+          const vdouble opz = ocz - az * oc_axis;
+
+          const vdouble a = dpx * dpx + dpy * dpy + dpz * dpz;
+          const vdouble b = two * (dpx * opx + dpy * opy + dpz * opz);
+          const vdouble c = (opx * opx + opy * opy + opz * opz) - radius_squared;
+          const vdouble discriminant = b * b - four * a * c;
+
+          const vmask side = simd::both(simd::greater_equal(discriminant, zero), simd::greater(a, epsilon));
+          if (!simd::none(side)) {
+            const vdouble half_height = simd::broadcast(cylinders.half_heights[offset]);
+            const vdouble sqrt_d = simd::sqrt(discriminant);
+            const vdouble minus_b = zero - b;
+            const vdouble two_a = two * a;
+            for (const vdouble t : {(minus_b - sqrt_d) / two_a, (minus_b + sqrt_d) / two_a}) {
+              const vdouble projection = ((ox + dx * t) - cx) * ax + ((oy + dy * t) - cy) * ay + ((oz + dz * t) - cz) * az;
+              const vmask hit = simd::both(simd::both(side, simd::greater(t, lower)),
+                                           simd::both(simd::less(t, lanes.t), simd::less_equal(simd::abs(projection), half_height)));
+              lanes.update(hit, t, index);
+            }
+          }
+
+          const vmask caps = simd::greater(simd::abs(dir_axis), epsilon);
+          if (!simd::none(caps)) {
+            const double cap_x[] = {cylinders.top_centers_x[offset], cylinders.bottom_centers_x[offset]};
+            const double cap_y[] = {cylinders.top_centers_y[offset], cylinders.bottom_centers_y[offset]};
+            const double cap_z[] = {cylinders.top_centers_z[offset], cylinders.bottom_centers_z[offset]};
+            for (std::size_t cap = 0; cap < 2; ++cap) {
+              const vdouble kx = simd::broadcast(cap_x[cap]);
+              const vdouble ky = simd::broadcast(cap_y[cap]);
+              const vdouble kz = simd::broadcast(cap_z[cap]);
+              const vdouble t = ((kx - ox) * ax + (ky - oy) * ay + (kz - oz) * az) / dir_axis;
+              const vdouble qx = (ox + dx * t) - kx;
+              const vdouble qy = (oy + dy * t) - ky;
+              const vdouble qz = (oz + dz * t) - kz;
+              const vmask hit = simd::both(simd::both(caps, simd::greater(t, lower)),
+                                           simd::both(simd::less(t, lanes.t), simd::less_equal(qx * qx + qy * qy + qz * qz, radius_squared)));
+              lanes.update(hit, t, index);
+            }
+          }
+        }
+
+        simd::store(hits.t + k, lanes.t);
+        simd::store(hits.primitive + k, lanes.index);
+      }
+    }
+
+    // Same xoshiro256+ step as the portable loop in simd_random.cpp, four
+    // lanes per 256-bit register.
+    void random_fill(std::uint64_t* state, std::uint64_t* out, std::size_t n) {
+      constexpr std::size_t lanes = 4;
+      auto* words = reinterpret_cast<__m256i*>(state);
+      __m256i s0 = _mm256_load_si256(words);
+      __m256i s1 = _mm256_load_si256(words + 1);
+      __m256i s2 = _mm256_load_si256(words + 2);
+      __m256i s3 = _mm256_load_si256(words + 3);
+
+      std::size_t i = 0;
+      while (i < n) {
+        const __m256i result = _mm256_add_epi64(s0, s3);
+        const __m256i t = _mm256_slli_epi64(s1, 17);
+        s2 = _mm256_xor_si256(s2, s0);
+        s3 = _mm256_xor_si256(s3, s1);
+        s1 = _mm256_xor_si256(s1, s2);
+        s0 = _mm256_xor_si256(s0, s3);
+        s2 = _mm256_xor_si256(s2, t);
+        s3 = _mm256_or_si256(_mm256_slli_epi64(s3, 45), _mm256_srli_epi64(s3, 19));
+
+        if (n - i >= lanes) {
+          _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), result);
+          i += lanes;
+        } else {
+          alignas(32) std::uint64_t tail[lanes];
+          _mm256_store_si256(reinterpret_cast<__m256i*>(tail), result);
+          for (std::size_t lane = 0; i < n; ++lane, ++i) {
+            out[i] = tail[lane];
+          }
+        }
+      }
+
+      _mm256_store_si256(words, s0);
+      _mm256_store_si256(words + 1, s1);
+      _mm256_store_si256(words + 2, s2);
+      _mm256_store_si256(words + 3, s3);
+    }
+
+    // The portable loop of gamma_encoder::encode, with the bucket levels and
+    // thresholds gathered per lane. min and max return their second operand
+    // for NaN, so NaN clamps to 1 and -0 to +0. The AVX-512 forms are masked
+    // for the reason given in simd_lanes.hpp.
+    void encode_levels(const level_tables& tables, const float* in, std::uint8_t* out, std::size_t n) {
+      std::size_t i = 0;
+#if defined(RENDER_SIMD_AVX512)
+      constexpr std::size_t width = 16;
+      const __m512 zero = _mm512_setzero_ps();
+      const __m512 one = _mm512_set1_ps(1.0F);
+      const __m512i level_one = _mm512_set1_epi32(1);
+      const __m512i byte_mask = _mm512_set1_epi32(0xFF);
+      for (; i + width <= n; i += width) {
+        const __m512 c = _mm512_maskz_max_ps(0xFFFF, _mm512_maskz_min_ps(0xFFFF, _mm512_loadu_ps(in + i), one), zero);
+        const __m512i bucket = _mm512_maskz_srli_epi32(0xFFFF, _mm512_castps_si512(c), level_bucket_shift);
+        __m512i level = _mm512_and_si512(_mm512_mask_i32gather_epi32(_mm512_setzero_si512(), 0xFFFF, bucket, tables.buckets, 1), byte_mask);
+        for (int step = 0; step < tables.steps; ++step) {
+          const __m512i next = _mm512_add_epi32(level, level_one);
+          const __mmask16 reached = _mm512_cmp_ps_mask(c, _mm512_mask_i32gather_ps(zero, 0xFFFF, next, tables.thresholds, 4), _CMP_GE_OQ);
+          level = _mm512_mask_blend_epi32(reached, level, next);
+        }
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm512_maskz_cvtepi32_epi8(0xFFFF, level));
+      }
+#else
+      constexpr std::size_t width = 8;
+      const __m256 zero = _mm256_setzero_ps();
+      const __m256 one = _mm256_set1_ps(1.0F);
+      const __m256i level_one = _mm256_set1_epi32(1);
+      const __m256i byte_mask = _mm256_set1_epi32(0xFF);
+      for (; i + width <= n; i += width) {
+        const __m256 c = _mm256_max_ps(_mm256_min_ps(_mm256_loadu_ps(in + i), one), zero);
+        const __m256i bucket = _mm256_srli_epi32(_mm256_castps_si256(c), level_bucket_shift);
+        __m256i level = _mm256_and_si256(_mm256_i32gather_epi32(reinterpret_cast<const int*>(tables.buckets), bucket, 1), byte_mask);
+        for (int step = 0; step < tables.steps; ++step) {
+          const __m256i next = _mm256_add_epi32(level, level_one);
+          const __m256 reached = _mm256_cmp_ps(c, _mm256_i32gather_ps(tables.thresholds, next, 4), _CMP_GE_OQ);
+          level = _mm256_castps_si256(_mm256_blendv_ps(_mm256_castsi256_ps(level), _mm256_castsi256_ps(next), reached));
+        }
+        alignas(32) std::int32_t levels[width];
+        _mm256_store_si256(reinterpret_cast<__m256i*>(levels), level);
+        for (std::size_t lane = 0; lane < width; ++lane) {
+          out[i + lane] = static_cast<std::uint8_t>(levels[lane]);
+        }
+      }
+#endif
+      for (; i < n; ++i) {
+        float c = in[i] < 1.0F ? in[i] : 1.0F;
+        c = c > 0.0F ? c : 0.0F;
+        std::uint32_t bits = 0;
+        std::memcpy(&bits, &c, sizeof(bits));
+        int level = tables.buckets[bits >> level_bucket_shift];
+        for (int step = 0; step < tables.steps; ++step) {
+          level += c >= tables.thresholds[level + 1] ? 1 : 0;
+        }
+        out[i] = static_cast<std::uint8_t>(level);
+      }
+    }
+
+  }
+
+  const table RENDER_KERNEL_TABLE{
+    simd::lanes == 8 ? cpu_isa::avx512 : cpu_isa::avx2,
+    closest_spheres,
+    closest_cylinders,
+    packet_spheres,
+    packet_cylinders,
+    random_fill,
+    encode_levels
+  };
+
+}
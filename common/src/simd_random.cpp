@@ -0,0 +1,78 @@
+#include "simd_random.hpp"
+
+#include "kernel_dispatch.hpp"
+
+namespace render {
+
+  namespace {
+
+    [[nodiscard]] inline std::uint64_t rotl(std::uint64_t x, int k) {
+      return (x << k) | (x >> (64 - k));
+    }
+
+  }
+
+  void xoshiro256x4::reseed(std::uint64_t seed, std::uint64_t stream) {
+    std::uint64_t state = seed ^ (stream * 0xD1B54A32D192ED03ULL);
+    for (std::size_t lane = 0; lane < lanes; ++lane) {
+      for (auto& word : s_) {
+        word[lane] = splitmix64(state);
+      }
+      if ((s_[0][lane] | s_[1][lane] | s_[2][lane] | s_[3][lane]) == 0) {
+        s_[0][lane] = 1;
+      }
+    }
+  }
+
+  void xoshiro256x4::fill(std::uint64_t* out, std::size_t n) {
+    if (const auto kernel = kernels::active().random_fill) {
+      kernel(s_[0], out, n);
+      return;
+    }
+
+    auto& [s0, s1, s2, s3] = s_;
+    std::size_t i = 0;
+    while (i < n) {
+      std::uint64_t result[lanes];
+      for (std::size_t lane = 0; lane < lanes; ++lane) {
+        result[lane] = s0[lane] + s3[lane];
+        const std::uint64_t t = s1[lane] << 17;
+        s2[lane] ^= s0[lane];
+        s3[lane] ^= s1[lane];
+        s1[lane] ^= s2[lane];
+        s0[lane] ^= s3[lane];
+        s2[lane] ^= t;
+        s3[lane] = rotl(s3[lane], 45);
+      }
+      for (std::size_t lane = 0; lane < lanes && i < n; ++lane, ++i) {
+        out[i] = result[lane];
+      }
+    }
+  }
+
+  void xoshiro256x4::fill_uniform(double* out, std::size_t n) {
+    constexpr std::size_t chunk = 64;
+    std::uint64_t bits[chunk];
+    for (std::size_t i = 0; i < n; i += chunk) {
+      const std::size_t count = (n - i < chunk) ? n - i : chunk;
+      fill(bits, count);
+      for (std::size_t k = 0; k < count; ++k) {
+        out[i + k] = bits_to_unit_double(bits[k]);
+      }
+    }
+  }
+
+  void xoshiro256x4::fill_uniform(float* out, std::size_t n) {
+    constexpr std::size_t chunk = 64;
+    std::uint64_t bits[chunk];
+    for (std::size_t i = 0; i < n; i += 2 * chunk) {
+      const std::size_t count = (n - i < 2 * chunk) ? n - i : 2 * chunk;
+      fill(bits, (count + 1) / 2);
+      for (std::size_t k = 0; k < count; ++k) {
+        const std::uint64_t word = bits[k / 2];
+        out[i + k] = bits_to_unit_float(static_cast<std::uint32_t>((k % 2 == 0) ? (word >> 32) : word));
+      }
+    }
+  }
+
+}
@@ -0,0 +1,107 @@
+#include "thread_pool.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+
+namespace render {
+
+  thread_pool::thread_pool(int num_threads)
+    : num_threads_{num_threads} {
+    if (num_threads <= 0) {
+      throw std::invalid_argument("Thread pool size must be positive");
+    }
+
+    workers_.reserve(static_cast<size_t>(num_threads - 1));
+    for (int i = 1; i < num_threads; ++i) {
+      workers_.emplace_back([this, i] { worker_loop(i); });
+    }
+  }
+
+  thread_pool::~thread_pool() {
+    {
+      const std::lock_guard<std::mutex> lock(mutex_);
+      stopping_ = true;
+    }
+    start_cv_.notify_all();
+    for (auto& worker : workers_) {
+      worker.join();
+    }
+  }
+
+  int thread_pool::resolve_thread_count(int requested) {
+    if (requested > 0) {
+      return requested;
+    }
+    const unsigned int hardware = std::thread::hardware_concurrency();
+    return std::max(1, static_cast<int>(hardware));
+  }
+
+  void thread_pool::execute(int index) {
+    try {
+      (*task_)(index);
+    }
+    catch (...) {
+      const std::lock_guard<std::mutex> lock(mutex_);
+      if (!error_) {
+        error_ = std::current_exception();
+      }
+    }
+  }
+
+  void thread_pool::worker_loop(int index) {
+    std::size_t seen_generation = 0;
+    while (true) {
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        start_cv_.wait(lock, [&] { return stopping_ || generation_ != seen_generation; });
+        if (stopping_) {
+          return;
+        }
+        seen_generation = generation_;
+      }
+
+      execute(index);
+
+      {
+        const std::lock_guard<std::mutex> lock(mutex_);
+        --pending_;
+      }
+      done_cv_.notify_one();
+    }
+  }
+
+  void thread_pool::parallel_for(size_t count, const std::function<void(size_t, size_t, int)>& body) {
+    const auto workers = static_cast<size_t>(num_threads_);
+    run([&](int worker) {
+      const auto w = static_cast<size_t>(worker);
+      const size_t begin = count * w / workers;
+      const size_t end = count * (w + 1) / workers;
+      if (begin < end) {
+        body(begin, end, worker);
+      }
+    });
+  }
+
+  void thread_pool::run(const std::function<void(int)>& task) {
+    {
+      const std::lock_guard<std::mutex> lock(mutex_);
+      task_ = &task;
+      error_ = nullptr;
+      pending_ = num_threads_ - 1;
+      ++generation_;
+    }
+    start_cv_.notify_all();
+
+    execute(0);
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    done_cv_.wait(lock, [&] { return pending_ == 0; });
+    task_ = nullptr;
+
+    if (error_) {
+      std::rethrow_exception(std::exchange(error_, nullptr));
+    }
+  }
+
+}
@@ -0,0 +1,97 @@
+#include "tile_renderer.hpp"
+
+#include "thread_pool.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <iostream>
+#include <stdexcept>
+
+namespace render {
+
+  tile_grid::tile_grid(int width, int height, int tile_size) : width_{width}, height_{height}, tile_size_{tile_size} {
+    if (tile_size <= 0) {
+      throw std::invalid_argument("Tile size must be positive");
+    }
+    columns_ = (width + tile_size - 1) / tile_size;
+    rows_ = (height + tile_size - 1) / tile_size;
+  }
+
+  tile tile_grid::at(std::size_t index) const {
+    const int x = static_cast<int>(index % static_cast<std::size_t>(columns_)) * tile_size_;
+    const int y = static_cast<int>(index / static_cast<std::size_t>(columns_)) * tile_size_;
+    return tile{static_cast<int>(index), x, std::min(x + tile_size_, width_), y, std::min(y + tile_size_, height_)};
+  }
+
+  std::vector<tile> make_tiles(int width, int height, int tile_size) {
+    const tile_grid grid{width, height, tile_size};
+    std::vector<tile> tiles;
+    tiles.reserve(grid.size());
+    for (std::size_t i = 0; i < grid.size(); ++i) {
+      tiles.push_back(grid.at(i));
+    }
+    return tiles;
+  }
+
+  tile_queue::tile_queue(const tile_grid& grid, int num_workers) : grid_{grid} {
+    if (num_workers <= 0) {
+      throw std::invalid_argument("Tile queue needs at least one worker");
+    }
+
+    const auto workers = static_cast<std::size_t>(num_workers);
+    for (std::size_t w = 0; w < workers; ++w) {
+      auto run = std::make_unique<worker_run>();
+      // Tile i goes to worker i * workers / size.
+      run->begin = (w * grid.size() + workers - 1) / workers;
+      run->end = ((w + 1) * grid.size() + workers - 1) / workers;
+      runs_.push_back(std::move(run));
+    }
+  }
+
+  std::optional<tile> tile_queue::pop(int worker) {
+    const auto own = static_cast<std::size_t>(worker);
+    {
+      worker_run& run = *runs_[own];
+      const std::lock_guard<std::mutex> lock(run.mutex);
+      if (run.begin < run.end) {
+        return grid_.at(run.begin++);
+      }
+    }
+
+    for (std::size_t offset = 1; offset < runs_.size(); ++offset) {
+      worker_run& victim = *runs_[(own + offset) % runs_.size()];
+      const std::lock_guard<std::mutex> lock(victim.mutex);
+      if (victim.begin < victim.end) {
+        return grid_.at(--victim.end);
+      }
+    }
+
+    return std::nullopt;
+  }
+
+  void render_tiles(const render_config& config, int width, int height, const std::function<void(const tile&)>& shade_tile) {
+    const tile_grid tiles{width, height, config.tile_size};
+    const int num_threads = std::min(thread_pool::resolve_thread_count(config.threads), std::max(1, static_cast<int>(tiles.size())));
+
+    std::cout << "Using " << num_threads << " threads with " << tiles.size() << " tiles of " << config.tile_size << "x" << config.tile_size << " pixels\n";
+
+    tile_queue queue{tiles, num_threads};
+    std::atomic<size_t> completed{0};
+    const size_t report_every = std::max<size_t>(1, tiles.size() / 10);
+    std::mutex progress_mutex;
+
+    thread_pool pool{num_threads};
+    pool.run([&](int worker) {
+      while (const auto t = queue.pop(worker)) {
+        shade_tile(*t);
+
+        const size_t done = ++completed;
+        if (done % report_every == 0 || done == tiles.size()) {
+          const std::lock_guard<std::mutex> lock(progress_mutex);
+          std::cout << "Progress: " << done << "/" << tiles.size() << " tiles\n";
+        }
+      }
+    });
+  }
+
+}
@@ -0,0 +1,64 @@
+#ifndef RENDER_LANES_LAYOUT_HPP
+#define RENDER_LANES_LAYOUT_HPP
+
+#include "bvh.hpp"
+#include "compiled_scene.hpp"
+#include "intersection_kernels.hpp"
+#include "material.hpp"
+#include "ray.hpp"
+#include "ray_packet.hpp"
+#include "scene_aosoa.hpp"
+#include "scene_layout.hpp"
+#include "scene_soa.hpp"
+#include "sphere.hpp"
+
+#include <optional>
+#include <span>
+
+namespace render {
+
+  // Scene layouts (see scene_layout.hpp) that hand the kernels column views.
+  // Whether the columns are separate arrays or interleaved blocks only shows
+  // in the views' block_stride, so both layouts share this code.
+  class lanes_layout {
+  public:
+    using scalar_type = double;
+
+    [[nodiscard]] const material_table& get_materials() const { return *materials_; }
+    [[nodiscard]] std::optional<ray_hit> find_closest_primitive(const ray& r, const std::optional<bvh>& accel) const;
+    void find_closest_primitives(const ray_packet& packet, const std::optional<bvh>& accel, packet_ray_hits& hits) const;
+    [[nodiscard]] hit_info surface_at(const ray& r, const ray_hit& hit) const;
+
+  protected:
+    lanes_layout(const material_table& materials, const sphere_lanes& spheres, const cylinder_lanes& cylinders,
+                 std::span<const material_id> sphere_materials, std::span<const material_id> cylinder_materials);
+
+  private:
+    [[nodiscard]] hit_info make_sphere_hit(size_t idx, const ray& r, double t) const;
+    [[nodiscard]] hit_info make_cylinder_hit(size_t idx, const ray& r, double t) const;
+
+    const material_table* materials_;
+    sphere_lanes spheres_;
+    cylinder_lanes cylinders_;
+    std::span<const material_id> sphere_materials_;
+    std::span<const material_id> cylinder_materials_;
+  };
+
+  // One array per coordinate.
+  class soa_layout : public lanes_layout {
+  public:
+    // Not explicit, so a renderer can be built straight from the scene.
+    soa_layout(const scene_soa& sc);
+    // The same columns, read in place from a mapped compiled scene file.
+    soa_layout(const compiled_scene& sc);
+  };
+
+  // Blocks of kernel_lane_padding primitives with their columns interleaved.
+  class aosoa_layout : public lanes_layout {
+  public:
+    aosoa_layout(const scene_aosoa& sc);
+  };
+
+}
+
+#endif
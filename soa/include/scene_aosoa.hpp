@@ -0,0 +1,45 @@
+#ifndef RENDER_SCENE_AOSOA_HPP
+#define RENDER_SCENE_AOSOA_HPP
+
+#include "aligned_allocator.hpp"
+#include "baked_scene.hpp"
+#include "intersection_kernels.hpp"
+#include "material.hpp"
+
+#include <cstddef>
+#include <vector>
+
+namespace render {
+
+  // Array of structures of arrays: primitives are grouped in blocks of
+  // kernel_lane_padding, and each block holds every column of its primitives
+  // back to back, one cache line per column. A kernel iteration then reads one
+  // contiguous block instead of a line from each of 4 or 14 separate arrays.
+  // The last block is padded with NaN entries, as in scene_soa.
+  class scene_aosoa {
+  public:
+    static constexpr std::size_t sphere_columns = 4;
+    static constexpr std::size_t cylinder_columns = 14;
+
+    explicit scene_aosoa(const baked_scene& baked);
+
+    [[nodiscard]] const material_table& get_materials() const { return materials_; }
+    [[nodiscard]] size_t get_num_spheres() const { return sphere_materials_.size(); }
+    [[nodiscard]] size_t get_num_cylinders() const { return cylinder_materials_.size(); }
+    [[nodiscard]] const std::vector<material_id>& get_sphere_materials() const { return sphere_materials_; }
+    [[nodiscard]] const std::vector<material_id>& get_cylinder_materials() const { return cylinder_materials_; }
+
+    [[nodiscard]] sphere_lanes get_sphere_lanes() const;
+    [[nodiscard]] cylinder_lanes get_cylinder_lanes() const;
+
+  private:
+    material_table materials_;
+    aligned_vector<double> sphere_blocks_;
+    aligned_vector<double> cylinder_blocks_;
+    std::vector<material_id> sphere_materials_;
+    std::vector<material_id> cylinder_materials_;
+  };
+
+}
+
+#endif
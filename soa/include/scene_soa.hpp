@@ -1,53 +1,104 @@
 #ifndef RENDER_SCENE_SOA_HPP
 #define RENDER_SCENE_SOA_HPP
 
+#include "aabb.hpp"
+#include "aligned_allocator.hpp"
+#include "baked_scene.hpp"
+#include "cylinder.hpp"
 #include "material.hpp"
+#include "primitive_arrays.hpp"
+#include "intersection_kernels.hpp"
+#include "scene.hpp"
 #include "vector.hpp"
 
-#include <memory>
+#include <array>
+#include <cstddef>
 #include <string>
+#include <utility>
 #include <vector>
 
 namespace render {
 
-  class scene_soa {
+  // Coordinate arrays are cache-line aligned and padded to a multiple of
+  // kernel_lane_padding with entries that can never be hit, so SIMD kernels run
+  // whole iterations only; get_num_spheres() and get_num_cylinders() count the
+  // real primitives. Cylinders also keep their precomputed frames. As a
+  // scene_builder it can be filled by scene_parser directly.
+  class scene_soa : public scene_builder {
   public:
-    void add_sphere(const vector& center, double radius, std::shared_ptr<material> mat);
-    void add_cylinder(const vector& center, double radius, const vector& axis, std::shared_ptr<material> mat);
-
-    [[nodiscard]] size_t get_num_spheres() const { return sphere_centers_x_.size(); }
-    [[nodiscard]] size_t get_num_cylinders() const { return cylinder_centers_x_.size(); }
-
-    [[nodiscard]] const std::vector<double>& get_sphere_centers_x() const { return sphere_centers_x_; }
-    [[nodiscard]] const std::vector<double>& get_sphere_centers_y() const { return sphere_centers_y_; }
-    [[nodiscard]] const std::vector<double>& get_sphere_centers_z() const { return sphere_centers_z_; }
-    [[nodiscard]] const std::vector<double>& get_sphere_radii() const { return sphere_radii_; }
-    [[nodiscard]] const std::vector<std::shared_ptr<material>>& get_sphere_materials() const { return sphere_materials_; }
-
-    [[nodiscard]] const std::vector<double>& get_cylinder_centers_x() const { return cylinder_centers_x_; }
-    [[nodiscard]] const std::vector<double>& get_cylinder_centers_y() const { return cylinder_centers_y_; }
-    [[nodiscard]] const std::vector<double>& get_cylinder_centers_z() const { return cylinder_centers_z_; }
-    [[nodiscard]] const std::vector<double>& get_cylinder_radii() const { return cylinder_radii_; }
-    [[nodiscard]] const std::vector<double>& get_cylinder_axes_x() const { return cylinder_axes_x_; }
-    [[nodiscard]] const std::vector<double>& get_cylinder_axes_y() const { return cylinder_axes_y_; }
-    [[nodiscard]] const std::vector<double>& get_cylinder_axes_z() const { return cylinder_axes_z_; }
-    [[nodiscard]] const std::vector<std::shared_ptr<material>>& get_cylinder_materials() const { return cylinder_materials_; }
+    scene_soa() = default;
+    // Columns filled straight from the baked records, frames included.
+    explicit scene_soa(const baked_scene& baked);
+
+    void set_materials(material_table materials) { materials_ = std::move(materials); }
+    material_id add_material(const material& mat) override { return materials_.add(mat); }
+    void add_sphere(const vector& center, double radius, material_id mat) override;
+    void add_cylinder(const vector& center, double radius, const vector& axis, material_id mat) override;
+    void reserve(std::size_t num_spheres, std::size_t num_cylinders) override;
+
+    // Sorts the primitives like scene::reorder does.
+    void reorder(primitive_order order);
+
+    [[nodiscard]] const material_table& get_materials() const { return materials_; }
+    [[nodiscard]] size_t get_num_spheres() const { return sphere_materials_.size(); }
+    [[nodiscard]] size_t get_num_cylinders() const { return cylinder_materials_.size(); }
+
+    [[nodiscard]] const aligned_vector<double>& get_sphere_centers_x() const { return sphere_centers_x_; }
+    [[nodiscard]] const aligned_vector<double>& get_sphere_centers_y() const { return sphere_centers_y_; }
+    [[nodiscard]] const aligned_vector<double>& get_sphere_centers_z() const { return sphere_centers_z_; }
+    [[nodiscard]] const aligned_vector<double>& get_sphere_radii() const { return sphere_radii_; }
+    [[nodiscard]] const std::vector<material_id>& get_sphere_materials() const { return sphere_materials_; }
+
+    [[nodiscard]] const aligned_vector<double>& get_cylinder_centers_x() const { return cylinder_centers_x_; }
+    [[nodiscard]] const aligned_vector<double>& get_cylinder_centers_y() const { return cylinder_centers_y_; }
+    [[nodiscard]] const aligned_vector<double>& get_cylinder_centers_z() const { return cylinder_centers_z_; }
+    [[nodiscard]] const aligned_vector<double>& get_cylinder_radii() const { return cylinder_radii_; }
+    [[nodiscard]] const aligned_vector<double>& get_cylinder_axes_x() const { return cylinder_axes_x_; }
+    [[nodiscard]] const aligned_vector<double>& get_cylinder_axes_y() const { return cylinder_axes_y_; }
+    [[nodiscard]] const aligned_vector<double>& get_cylinder_axes_z() const { return cylinder_axes_z_; }
+    [[nodiscard]] const std::vector<material_id>& get_cylinder_materials() const { return cylinder_materials_; }
+
+    [[nodiscard]] sphere_lanes get_sphere_lanes() const;
+    [[nodiscard]] cylinder_lanes get_cylinder_lanes() const;
+    [[nodiscard]] primitive_arrays get_primitive_arrays() const;
+
+    // Bounds of every primitive, spheres first and then cylinders; the position
+    // in this list is the primitive number used by acceleration structures.
+    [[nodiscard]] std::vector<aabb> get_primitive_bounds() const { return get_primitive_arrays().all_bounds(); }
 
   private:
-    std::vector<double> sphere_centers_x_;
-    std::vector<double> sphere_centers_y_;
-    std::vector<double> sphere_centers_z_;
-    std::vector<double> sphere_radii_;
-    std::vector<std::shared_ptr<material>> sphere_materials_;
-
-    std::vector<double> cylinder_centers_x_;
-    std::vector<double> cylinder_centers_y_;
-    std::vector<double> cylinder_centers_z_;
-    std::vector<double> cylinder_radii_;
-    std::vector<double> cylinder_axes_x_;
-    std::vector<double> cylinder_axes_y_;
-    std::vector<double> cylinder_axes_z_;
-    std::vector<std::shared_ptr<material>> cylinder_materials_;
+    void add_cylinder(const vector& center, double radius, const vector& axis, const cylinder_frame& frame, material_id mat);
+
+    [[nodiscard]] std::array<aligned_vector<double>*, 4> sphere_columns();
+    [[nodiscard]] std::array<aligned_vector<double>*, 18> cylinder_columns();
+
+    material_table materials_;
+
+    aligned_vector<double> sphere_centers_x_;
+    aligned_vector<double> sphere_centers_y_;
+    aligned_vector<double> sphere_centers_z_;
+    aligned_vector<double> sphere_radii_;
+    std::vector<material_id> sphere_materials_;
+
+    aligned_vector<double> cylinder_centers_x_;
+    aligned_vector<double> cylinder_centers_y_;
+    aligned_vector<double> cylinder_centers_z_;
+    aligned_vector<double> cylinder_radii_;
+    aligned_vector<double> cylinder_axes_x_;
+    aligned_vector<double> cylinder_axes_y_;
+    aligned_vector<double> cylinder_axes_z_;
+    aligned_vector<double> cylinder_unit_axes_x_;
+    aligned_vector<double> cylinder_unit_axes_y_;
+    aligned_vector<double> cylinder_unit_axes_z_;
+    aligned_vector<double> cylinder_top_centers_x_;
+    aligned_vector<double> cylinder_top_centers_y_;
+    aligned_vector<double> cylinder_top_centers_z_;
+    aligned_vector<double> cylinder_bottom_centers_x_;
+    aligned_vector<double> cylinder_bottom_centers_y_;
+    aligned_vector<double> cylinder_bottom_centers_z_;
+    aligned_vector<double> cylinder_half_heights_;
+    aligned_vector<double> cylinder_radii_squared_;
+    std::vector<material_id> cylinder_materials_;
   };
 
 }
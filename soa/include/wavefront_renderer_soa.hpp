@@ -0,0 +1,94 @@
+#ifndef RENDER_WAVEFRONT_RENDERER_SOA_HPP
+#define RENDER_WAVEFRONT_RENDERER_SOA_HPP
+
+#include "camera.hpp"
+#include "config.hpp"
+#include "random.hpp"
+#include "ray.hpp"
+#include "lanes_layout.hpp"
+#include "renderer.hpp"
+#include "renderer_soa.hpp"
+#include "renderer_utils.hpp"
+#include "sphere.hpp"
+#include "tile_renderer.hpp"
+#include "vector.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+namespace render {
+
+  // One camera sample in flight: the current ray, the product of all
+  // reflectances so far and the sample's material stream.
+  struct wavefront_path {
+    ray r;
+    vector throughput;
+    random_stream rng;
+    std::uint32_t slot;  // pixel within the tile
+  };
+
+  // Breadth-first alternative to layout_renderer::trace_ray, over any double
+  // precision scene layout. The samples of a tile are advanced one bounce at a
+  // time: a batched intersection stage over the whole queue of live paths, then
+  // hits are bucketed by material type and each bucket is scattered by its own
+  // loop. Paths use the same random streams and scatter functions as
+  // layout_renderer::trace_ray, and their colors are added to the pixels in
+  // sample order, so results agree with it up to rounding.
+  template <typename Layout>
+  class basic_wavefront_renderer {
+  public:
+    // Live paths per batch; tiles with more samples are traced in several
+    // batches. A path state is about 400 bytes, so a batch stays in L2; larger
+    // queues measured slower on the CPU this was tuned on.
+    static constexpr std::size_t max_paths = std::size_t{1} << 9;
+
+    basic_wavefront_renderer(const render_config& config, const camera& cam, const layout_renderer<Layout>& tracer);
+
+    // Estimates of every pixel of the tile, row-major within the tile. Pixels
+    // are sampled in rounds until pixel_estimate::needs_sample says they are
+    // done: without adaptive sampling each round takes as many samples per
+    // pixel as fit a batch, with it only pixels past the minimum batch that
+    // still need a sample take one more.
+    void render_tile(const tile& t, std::vector<pixel_estimate>& pixels) const;
+
+  private:
+    struct pending_hit {
+      hit_info hit;
+      std::uint32_t path;
+    };
+
+    // Paths stay in place; the per-bounce queues hold their indices and are
+    // reused across bounces and batches. colors holds what each path has
+    // brought back from the background.
+    struct queues {
+      std::vector<wavefront_path> paths;
+      std::vector<vector> colors;
+      std::vector<std::uint32_t> active;
+      std::vector<std::uint32_t> next;
+      std::array<std::vector<pending_hit>, 3> by_material;
+    };
+
+    void trace_paths(queues& q) const;
+    void intersect_paths(queues& q, int depth) const;
+    void advance(queues& q, std::uint32_t index, const std::optional<scatter_event>& event, int depth) const;
+    void scatter_matte(queues& q, int depth) const;
+    void scatter_metal(queues& q, int depth) const;
+    void scatter_refractive(queues& q, int depth) const;
+
+    const render_config& config_;
+    const camera& camera_;
+    const layout_renderer<Layout>& tracer_;
+  };
+
+  extern template class basic_wavefront_renderer<aos_layout<double>>;
+  extern template class basic_wavefront_renderer<soa_layout>;
+  extern template class basic_wavefront_renderer<aosoa_layout>;
+
+  using wavefront_renderer_soa = basic_wavefront_renderer<soa_layout>;
+
+}
+
+#endif
@@ -0,0 +1,115 @@
+#include "lanes_layout.hpp"
+
+#include "cylinder.hpp"
+
+#include <cstdint>
+#include <limits>
+
+namespace render {
+
+  lanes_layout::lanes_layout(const material_table& materials, const sphere_lanes& spheres, const cylinder_lanes& cylinders,
+                             std::span<const material_id> sphere_materials, std::span<const material_id> cylinder_materials)
+    : materials_{&materials}, spheres_{spheres}, cylinders_{cylinders},
+      sphere_materials_{sphere_materials}, cylinder_materials_{cylinder_materials} {}
+
+  hit_info lanes_layout::make_sphere_hit(size_t idx, const ray& r, double t) const {
+    const size_t offset = column_offset(spheres_, idx);
+    const vector center{spheres_.centers_x[offset], spheres_.centers_y[offset], spheres_.centers_z[offset]};
+    const vector point = r.point_at(t);
+    return hit_info{t, point, (point - center).normalize(), sphere_materials_[idx]};
+  }
+
+  hit_info lanes_layout::make_cylinder_hit(size_t idx, const ray& r, double t) const {
+    const size_t offset = column_offset(cylinders_, idx);
+    cylinder_frame frame;
+    frame.center = vector{cylinders_.centers_x[offset], cylinders_.centers_y[offset], cylinders_.centers_z[offset]};
+    frame.unit_axis = vector{cylinders_.unit_axes_x[offset], cylinders_.unit_axes_y[offset], cylinders_.unit_axes_z[offset]};
+    frame.top_center = vector{cylinders_.top_centers_x[offset], cylinders_.top_centers_y[offset], cylinders_.top_centers_z[offset]};
+    frame.bottom_center = vector{cylinders_.bottom_centers_x[offset], cylinders_.bottom_centers_y[offset], cylinders_.bottom_centers_z[offset]};
+    frame.half_height = cylinders_.half_heights[offset];
+    frame.radius_squared = cylinders_.radii_squared[offset];
+
+    const vector point = r.point_at(t);
+    return hit_info{t, point, frame.normal_at(frame.part_at(r, t), point), cylinder_materials_[idx]};
+  }
+
+  hit_info lanes_layout::surface_at(const ray& r, const ray_hit& hit) const {
+    return hit.kind == primitive_kind::sphere ? make_sphere_hit(hit.index, r, hit.t) : make_cylinder_hit(hit.index, r, hit.t);
+  }
+
+  std::optional<ray_hit> lanes_layout::find_closest_primitive(const ray& r, const std::optional<bvh>& accel) const {
+    std::optional<ray_hit> closest;
+
+    if (accel) {
+      const size_t num_spheres = sphere_materials_.size();
+      accel->traverse(r, 0.0001, std::numeric_limits<double>::max(), [&](std::uint32_t prim, double t_max) -> std::optional<double> {
+        if (prim < num_spheres) {
+          const auto t = sphere_hit_distance(spheres_, prim, r, 0.0001, t_max);
+          if (t) {
+            closest = ray_hit{*t, primitive_kind::sphere, prim};
+          }
+          return t;
+        }
+        const auto index = static_cast<std::uint32_t>(prim - num_spheres);
+        const auto t = cylinder_hit_distance(cylinders_, index, r, 0.0001, t_max);
+        if (t) {
+          closest = ray_hit{*t, primitive_kind::cylinder, index};
+        }
+        return t;
+      });
+      return closest;
+    }
+
+    double t_max = std::numeric_limits<double>::max();
+    if (const auto sphere = closest_sphere_hit(spheres_, r, 0.0001, t_max)) {
+      t_max = sphere->t;
+      closest = ray_hit{sphere->t, primitive_kind::sphere, sphere->index};
+    }
+    if (const auto cylinder = closest_cylinder_hit(cylinders_, r, 0.0001, t_max)) {
+      closest = ray_hit{cylinder->t, primitive_kind::cylinder, cylinder->index};
+    }
+    return closest;
+  }
+
+  void lanes_layout::find_closest_primitives(const ray_packet& packet, const std::optional<bvh>& accel, packet_ray_hits& hits) const {
+    const size_t num_spheres = sphere_materials_.size();
+    const auto first_cylinder = static_cast<std::uint32_t>(num_spheres);
+
+    packet_hits closest;
+    closest.reset(packet.count, std::numeric_limits<double>::max());
+
+    if (accel) {
+      accel->traverse_packet(packet, 0.0001, closest.t, [&](std::uint32_t prim) {
+        if (prim < num_spheres) {
+          intersect_packet_spheres(spheres_, prim, prim + 1, 0, packet, 0.0001, closest);
+        } else {
+          const size_t idx = prim - num_spheres;
+          intersect_packet_cylinders(cylinders_, idx, idx + 1, first_cylinder, packet, 0.0001, closest);
+        }
+      });
+    } else {
+      intersect_packet_spheres(spheres_, 0, num_spheres, 0, packet, 0.0001, closest);
+      intersect_packet_cylinders(cylinders_, 0, cylinder_materials_.size(), first_cylinder, packet, 0.0001, closest);
+    }
+
+    for (size_t k = 0; k < packet.count; ++k) {
+      hits[k].reset();
+      if (closest.primitive[k] < 0.0) {
+        continue;
+      }
+      const auto prim = static_cast<std::uint32_t>(closest.primitive[k]);
+      hits[k] = (prim < num_spheres) ? ray_hit{closest.t[k], primitive_kind::sphere, prim}
+                                     : ray_hit{closest.t[k], primitive_kind::cylinder, prim - first_cylinder};
+    }
+  }
+
+  soa_layout::soa_layout(const scene_soa& sc)
+    : lanes_layout{sc.get_materials(), sc.get_sphere_lanes(), sc.get_cylinder_lanes(), sc.get_sphere_materials(), sc.get_cylinder_materials()} {}
+
+  soa_layout::soa_layout(const compiled_scene& sc)
+    : lanes_layout{sc.get_materials(), sc.get_sphere_lanes(), sc.get_cylinder_lanes(), sc.get_sphere_materials(), sc.get_cylinder_materials()} {}
+
+  aosoa_layout::aosoa_layout(const scene_aosoa& sc)
+    : lanes_layout{sc.get_materials(), sc.get_sphere_lanes(), sc.get_cylinder_lanes(), sc.get_sphere_materials(), sc.get_cylinder_materials()} {}
+
+}
@@ -1,80 +1,215 @@
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <iomanip>
 #include <iostream>
-#include <random>
+#include <optional>
+#include <type_traits>
 #include <vector>
 
+#include "baked_scene.hpp"
+#include "bvh.hpp"
 #include "camera.hpp"
+#include "command_line.hpp"
+#include "compiled_scene.hpp"
 #include "config.hpp"
-#include "cylinder.hpp"
+#include "image_output.hpp"
+#include "kernel_dispatch.hpp"
+#include "lanes_layout.hpp"
+#include "random.hpp"
 #include "renderer_soa.hpp"
 #include "renderer_utils.hpp"
 #include "scene.hpp"
+#include "scene_aosoa.hpp"
 #include "scene_soa.hpp"
-#include "sphere.hpp"
+#include "tile_renderer.hpp"
 #include "vector.hpp"
+#include "wavefront_renderer_soa.hpp"
 
 int main(int argc, char* argv[]) {
-  if (argc != 4) {
-    std::cerr << "Usage: " << argv[0] << " <config_file> <scene_file> <output_file>\n";
+  render::command_line args;
+  try {
+    args = render::command_line_parser::parse(argc, argv);
+  } catch (const std::exception& e) {
+    std::cerr << e.what() << "\n" << render::command_line_parser::usage(argv[0]);
     return 1;
   }
 
-  const std::string config_file = argv[1];
-  const std::string scene_file = argv[2];
-  const std::string output_file = argv[3];
-
   try {
-    const auto config = render::config_parser::parse(config_file);
-    const auto scene_aos = render::scene_parser::parse(scene_file);
-
-    render::scene_soa scene_soa;
-    for (const auto& sphere : scene_aos.get_spheres()) {
-      scene_soa.add_sphere(sphere->get_center(), sphere->get_radius(), sphere->get_material());
-    }
-    for (const auto& cylinder : scene_aos.get_cylinders()) {
-      scene_soa.add_cylinder(cylinder->get_center(), cylinder->get_radius(), cylinder->get_axis(), cylinder->get_material());
+    auto config = render::config_parser::parse(args.config_file);
+    args.apply_overrides(config);
+    render::select_kernel_isa(args.isa);
+    std::cout << "Kernels: " << render::isa_name(render::active_kernel_isa()) << (args.isa ? " (--isa)" : " (detected)") << "\n";
+    const render::memory_layout layout = config.layout.value_or(render::memory_layout::soa);
+
+    // A compiled scene is rendered in place for the SOA layout, and a text
+    // scene is parsed straight into its columns; the other layouts bake
+    // their own copy of the primitives. A compiled scene keeps its primitive
+    // order, so its BVH stays valid.
+    std::optional<render::compiled_scene> compiled;
+    std::optional<render::scene_soa> parsed_soa;
+    std::optional<render::baked_scene> baked;
+    if (render::is_compiled_scene(args.scene_file)) {
+      compiled = render::compiled_scene::open(args.scene_file);
+      std::cout << "Mapped compiled scene: " << compiled->get_num_spheres() << " spheres, " << compiled->get_num_cylinders() << " cylinders\n";
+      if (config.ordering != compiled->get_ordering()) {
+        std::cout << "The compiled scene keeps the primitive order it was compiled with.\n";
+      }
+      if (layout != render::memory_layout::soa) {
+        baked = render::bake_scene(compiled->to_scene());
+      }
+    } else if (layout == render::memory_layout::soa) {
+      parsed_soa.emplace();
+      render::scene_parser::parse(args.scene_file, *parsed_soa, config.threads);
+      render::reorder_scene(*parsed_soa, config.ordering);
+    } else {
+      auto parsed = render::scene_parser::parse(args.scene_file, config.threads);
+      render::reorder_scene(parsed, config.ordering);
+      baked = render::bake_scene(parsed);
     }
 
     const render::camera cam{config};
-    const render::renderer_soa renderer{config, scene_soa};
+    const auto accel = compiled     ? compiled->load_acceleration(config)
+                       : parsed_soa ? render::build_acceleration(config, parsed_soa->get_primitive_arrays())
+                                    : render::build_acceleration(config, baked->get_primitive_bounds());
 
     const int width = cam.get_image_width();
     const int height = cam.get_image_height();
 
-    std::mt19937 ray_rng(config.ray_rng_seed);
-    std::mt19937 material_rng(config.material_rng_seed);
-    std::uniform_real_distribution<double> dist(0.0, 1.0);
-
-    std::vector<std::vector<render::vector>> image(static_cast<size_t>(width));
-    for (int i = 0; i < width; ++i) {
-      image[i].resize(static_cast<size_t>(height));
+    render::image_output output{config, args.output_file, width, height};
+    std::optional<render::sample_count_image> sample_counts;
+    if (args.sample_counts_file) {
+      sample_counts.emplace(width, height, config.samples_per_pixel);
     }
+    std::atomic<std::uint64_t> total_samples{0};
+    const render::sample_pattern pattern = render::sample_pattern_for(config);
 
-    std::cout << "Rendering " << width << "x" << height << " image with " << config.samples_per_pixel << " samples per pixel (SOA)...\n";
-
-    for (int j = 0; j < height; ++j) {
-      for (int i = 0; i < width; ++i) {
-        render::vector color{0.0, 0.0, 0.0};
-
-        for (int s = 0; s < config.samples_per_pixel; ++s) {
-          const double u = (static_cast<double>(i) + dist(ray_rng)) / static_cast<double>(width);
-          const double v = (static_cast<double>(j) + dist(ray_rng)) / static_cast<double>(height);
-          const render::ray r = cam.get_ray(u, v);
-          color = color + renderer.trace_ray(r, 0, ray_rng, material_rng);
+    if (config.precision == render::render_precision::single_precision) {
+      std::cout << "Single precision is only available in the AOS renderer; using double.\n";
+    }
+    const bool use_wavefront = config.engine == render::render_engine::wavefront;
+    const char* layout_label = layout == render::memory_layout::aos ? "AOS" : layout == render::memory_layout::aosoa ? "AOSOA" : "SOA";
+    std::cout << "Rendering " << width << "x" << height << " image with " << config.samples_per_pixel << " samples per pixel (" << layout_label
+              << (use_wavefront ? ", wavefront" : "") << ")...\n";
+
+    // Every layout goes through the same tracer template, so the tile loop is shared.
+    const auto render_image = [&](const auto& renderer) {
+      using layout_type = typename std::decay_t<decltype(renderer)>::layout_type;
+      const render::basic_wavefront_renderer<layout_type> wavefront{config, cam, renderer};
+
+      render::render_tiles(config, width, height, [&](const render::tile& t) {
+        render::framebuffer pixels{t.x_end - t.x_begin, t.y_end - t.y_begin};
+        std::uint64_t tile_samples = 0;
+        const auto store_pixel = [&](int i, int j, const render::pixel_estimate& estimate) {
+          pixels.set_pixel(i - t.x_begin, j - t.y_begin, estimate.mean());
+          if (sample_counts) {
+            sample_counts->set_count(i, j, estimate.count);
+          }
+          tile_samples += static_cast<std::uint64_t>(estimate.count);
+        };
+
+        if (use_wavefront) {
+          std::vector<render::pixel_estimate> estimates;
+          wavefront.render_tile(t, estimates);
+          const int tile_width = t.x_end - t.x_begin;
+          for (int j = t.y_begin; j < t.y_end; ++j) {
+            for (int i = t.x_begin; i < t.x_end; ++i) {
+              store_pixel(i, j, estimates[static_cast<size_t>((j - t.y_begin) * tile_width + (i - t.x_begin))]);
+            }
+          }
+          output.store_tile(t, pixels);
+          total_samples += tile_samples;
+          return;
         }
 
-        color = color / static_cast<double>(config.samples_per_pixel);
-        color = render::gamma_correct(color, config.gamma);
-        color = render::clamp_color(color);
-        image[i][j] = color;
-      }
-
-      if ((j + 1) % 50 == 0) {
-        std::cout << "Progress: " << (j + 1) << "/" << height << " lines\n";
+        constexpr size_t packet_width = render::ray_packet::capacity;
+        render::ray_packet packet;
+        std::array<double, packet_width> u{};
+        std::array<double, packet_width> v{};
+        std::array<render::vector, packet_width> colors;
+        std::vector<render::random_stream> material_rngs;
+        material_rngs.reserve(packet_width);
+
+        // Primary rays go out as packets of up to packet_width neighbouring pixels
+        // of a tile row; bounces continue one ray at a time.
+        for (int j = t.y_begin; j < t.y_end; ++j) {
+          for (int i0 = t.x_begin; i0 < t.x_end; i0 += static_cast<int>(packet_width)) {
+            const size_t run = std::min(packet_width, static_cast<size_t>(t.x_end - i0));
+            std::array<render::pixel_estimate, packet_width> estimates{};
+            // Pixel of the run each packet lane samples; pixels that adaptive
+            // sampling has finished drop out of the packet.
+            std::array<size_t, packet_width> lanes{};
+
+            // Every sample draws from streams addressed by pixel and sample index, so
+            // the image does not depend on tile order, thread count or packet width.
+            while (true) {
+              packet.count = 0;
+              for (size_t k = 0; k < run; ++k) {
+                if (estimates[k].needs_sample(config)) {
+                  lanes[packet.count++] = k;
+                }
+              }
+              if (packet.count == 0) {
+                break;
+              }
+
+              material_rngs.clear();
+              for (size_t lane = 0; lane < packet.count; ++lane) {
+                const int i = i0 + static_cast<int>(lanes[lane]);
+                const auto pixel = static_cast<std::uint64_t>(j) * static_cast<std::uint64_t>(width) + static_cast<std::uint64_t>(i);
+                const auto s = static_cast<std::uint32_t>(estimates[lanes[lane]].count);
+                render::random_stream ray_rng{config.ray_rng_seed, pixel, s, render::random_domain::camera, pattern};
+                material_rngs.emplace_back(config.material_rng_seed, pixel, s, render::random_domain::material, pattern);
+                u[lane] = (static_cast<double>(i) + ray_rng.uniform()) / static_cast<double>(width);
+                v[lane] = (static_cast<double>(j) + ray_rng.uniform()) / static_cast<double>(height);
+              }
+              cam.get_rays(u.data(), v.data(), packet);
+              renderer.trace_packet(packet, material_rngs, colors);
+              for (size_t lane = 0; lane < packet.count; ++lane) {
+                estimates[lanes[lane]].add(colors[lane]);
+              }
+            }
+
+            for (size_t k = 0; k < run; ++k) {
+              store_pixel(i0 + static_cast<int>(k), j, estimates[k]);
+            }
+          }
+        }
+        output.store_tile(t, pixels);
+        total_samples += tile_samples;
+      });
+    };
+
+    switch (layout) {
+      case render::memory_layout::aos:
+        render_image(render::renderer{config, *baked, accel});
+        break;
+      case render::memory_layout::soa:
+        if (parsed_soa) {
+          render_image(render::renderer_soa{config, *parsed_soa, accel});
+        } else {
+          render_image(render::renderer_soa{config, *compiled, accel});
+        }
+        break;
+      case render::memory_layout::aosoa: {
+        const render::scene_aosoa scene_aosoa{*baked};
+        render_image(render::renderer_aosoa{config, scene_aosoa, accel});
+        break;
       }
     }
 
-    render::write_ppm(output_file, image, width, height);
-    std::cout << "Rendering complete. Output written to " << output_file << "\n";
+    output.finish();
+    if (config.adaptive_threshold > 0.0) {
+      std::cout << "Adaptive sampling: " << std::fixed << std::setprecision(1)
+                << static_cast<double>(total_samples) / (static_cast<double>(width) * static_cast<double>(height))
+                << " samples per pixel on average\n";
+    }
+    if (sample_counts) {
+      sample_counts->write(*args.sample_counts_file);
+      std::cout << "Sample counts written to " << *args.sample_counts_file << "\n";
+    }
+    std::cout << "Rendering complete. Output written to " << args.output_file << "\n";
 
   } catch (const std::exception& e) {
     std::cerr << "Error: " << e.what() << "\n";
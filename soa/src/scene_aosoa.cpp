@@ -0,0 +1,75 @@
+#include "scene_aosoa.hpp"
+
+#include <initializer_list>
+#include <limits>
+
+namespace render {
+
+  namespace {
+
+    // Room for count primitives in whole blocks of the given number of columns.
+    aligned_vector<double> make_blocks(std::size_t count, std::size_t columns) {
+      const std::size_t blocks = (count + kernel_lane_padding - 1) / kernel_lane_padding;
+      return aligned_vector<double>(blocks * columns * kernel_lane_padding, std::numeric_limits<double>::quiet_NaN());
+    }
+
+    // Writes the columns of primitive i, in column order.
+    void store(aligned_vector<double>& blocks, std::size_t columns, std::size_t i, std::initializer_list<double> values) {
+      double* entry = blocks.data() + i / kernel_lane_padding * columns * kernel_lane_padding + i % kernel_lane_padding;
+      for (const double value : values) {
+        *entry = value;
+        entry += kernel_lane_padding;
+      }
+    }
+
+    // First entry of a column, or null when there are no blocks at all.
+    const double* column(const aligned_vector<double>& blocks, std::size_t c) {
+      return blocks.empty() ? nullptr : blocks.data() + c * kernel_lane_padding;
+    }
+
+  }
+
+  scene_aosoa::scene_aosoa(const baked_scene& baked)
+    : materials_{baked.get_materials()},
+      sphere_blocks_{make_blocks(baked.get_spheres().size(), sphere_columns)},
+      cylinder_blocks_{make_blocks(baked.get_cylinders().size(), cylinder_columns)} {
+    for (const baked_sphere& sph : baked.get_spheres()) {
+      store(sphere_blocks_, sphere_columns, sphere_materials_.size(), {
+        sph.center.get_x(), sph.center.get_y(), sph.center.get_z(), sph.radius
+      });
+      sphere_materials_.push_back(sph.mat);
+    }
+    for (const baked_cylinder& cyl : baked.get_cylinders()) {
+      const cylinder_frame& frame = cyl.frame;
+      store(cylinder_blocks_, cylinder_columns, cylinder_materials_.size(), {
+        frame.center.get_x(), frame.center.get_y(), frame.center.get_z(),
+        frame.unit_axis.get_x(), frame.unit_axis.get_y(), frame.unit_axis.get_z(),
+        frame.top_center.get_x(), frame.top_center.get_y(), frame.top_center.get_z(),
+        frame.bottom_center.get_x(), frame.bottom_center.get_y(), frame.bottom_center.get_z(),
+        frame.half_height, frame.radius_squared
+      });
+      cylinder_materials_.push_back(cyl.mat);
+    }
+  }
+
+  sphere_lanes scene_aosoa::get_sphere_lanes() const {
+    return sphere_lanes{
+      column(sphere_blocks_, 0), column(sphere_blocks_, 1), column(sphere_blocks_, 2), column(sphere_blocks_, 3),
+      sphere_blocks_.size() / sphere_columns,
+      sphere_columns * kernel_lane_padding
+    };
+  }
+
+  cylinder_lanes scene_aosoa::get_cylinder_lanes() const {
+    return cylinder_lanes{
+      column(cylinder_blocks_, 0), column(cylinder_blocks_, 1), column(cylinder_blocks_, 2),
+      column(cylinder_blocks_, 3), column(cylinder_blocks_, 4), column(cylinder_blocks_, 5),
+      column(cylinder_blocks_, 6), column(cylinder_blocks_, 7), column(cylinder_blocks_, 8),
+      column(cylinder_blocks_, 9), column(cylinder_blocks_, 10), column(cylinder_blocks_, 11),
+      column(cylinder_blocks_, 12), column(cylinder_blocks_, 13),
+      cylinder_blocks_.size() / cylinder_columns,
+      cylinder_columns * kernel_lane_padding
+    };
+  }
+
+}
@@ -0,0 +1,46 @@
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+#include <optional>
+
+#include "baked_scene.hpp"
+#include "bvh.hpp"
+#include "command_line.hpp"
+#include "compiled_scene.hpp"
+#include "config.hpp"
+#include "scene.hpp"
+
+// Turns a text scene into a compiled scene file that render-aos and
+// render-soa accept in its place. The config decides the primitive order and
+// which acceleration structure, if any, is stored with it.
+int main(int argc, char* argv[]) {
+  render::command_line args;
+  try {
+    args = render::command_line_parser::parse(argc, argv);
+  } catch (const std::exception& e) {
+    std::cerr << e.what() << "\n" << render::command_line_parser::usage(argv[0]);
+    return 1;
+  }
+
+  try {
+    auto config = render::config_parser::parse(args.config_file);
+    args.apply_overrides(config);
+    auto parsed = render::scene_parser::parse(args.scene_file, config.threads);
+    render::reorder_scene(parsed, config.ordering);
+    const auto baked = render::bake_scene(parsed);
+    const auto accel = render::build_acceleration(config, baked.get_primitive_bounds());
+
+    const auto start = std::chrono::steady_clock::now();
+    render::write_compiled_scene(args.output_file, baked, config, accel);
+    const auto stop = std::chrono::steady_clock::now();
+
+    std::cout << "Compiled scene written to " << args.output_file << ": " << std::filesystem::file_size(args.output_file) << " bytes, "
+              << std::chrono::duration<double, std::milli>(stop - start).count() << " ms\n";
+
+  } catch (const std::exception& e) {
+    std::cerr << "Error: " << e.what() << "\n";
+    return 1;
+  }
+
+  return 0;
+}
@@ -1,25 +1,168 @@
 #include "scene_soa.hpp"
 
+#include "cylinder.hpp"
+
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <utility>
+#include <vector>
+
 namespace render {
 
-  void scene_soa::add_sphere(const vector& center, double radius, std::shared_ptr<material> mat) {
-    sphere_centers_x_.push_back(center.get_x());
-    sphere_centers_y_.push_back(center.get_y());
-    sphere_centers_z_.push_back(center.get_z());
-    sphere_radii_.push_back(radius);
+  namespace {
+
+    // Appends a block of never-hit padding entries once the arrays are full.
+    template <typename Columns>
+    void reserve_slot(size_t index, const Columns& columns) {
+      for (aligned_vector<double>* column : columns) {
+        if (index == column->size()) {
+          column->resize(index + kernel_lane_padding, std::numeric_limits<double>::quiet_NaN());
+        }
+      }
+    }
+
+    size_t padded_count(size_t count) {
+      return (count + kernel_lane_padding - 1) / kernel_lane_padding * kernel_lane_padding;
+    }
+
+    // Entry i becomes old entry order[i]; padding past order.size() stays.
+    template <typename Column>
+    void permute(Column& column, const std::vector<std::uint32_t>& order) {
+      Column sorted = column;
+      for (size_t i = 0; i < order.size(); ++i) {
+        sorted[i] = column[order[i]];
+      }
+      column = std::move(sorted);
+    }
+
+  }
+
+  scene_soa::scene_soa(const baked_scene& baked) : materials_{baked.get_materials()} {
+    for (const baked_sphere& sph : baked.get_spheres()) {
+      add_sphere(sph.center, sph.radius, sph.mat);
+    }
+    for (const baked_cylinder& cyl : baked.get_cylinders()) {
+      add_cylinder(cyl.frame.center, cyl.radius, cyl.axis, cyl.frame, cyl.mat);
+    }
+  }
+
+  std::array<aligned_vector<double>*, 4> scene_soa::sphere_columns() {
+    return {&sphere_centers_x_, &sphere_centers_y_, &sphere_centers_z_, &sphere_radii_};
+  }
+
+  std::array<aligned_vector<double>*, 18> scene_soa::cylinder_columns() {
+    return {
+      &cylinder_centers_x_, &cylinder_centers_y_, &cylinder_centers_z_, &cylinder_radii_,
+      &cylinder_axes_x_, &cylinder_axes_y_, &cylinder_axes_z_,
+      &cylinder_unit_axes_x_, &cylinder_unit_axes_y_, &cylinder_unit_axes_z_,
+      &cylinder_top_centers_x_, &cylinder_top_centers_y_, &cylinder_top_centers_z_,
+      &cylinder_bottom_centers_x_, &cylinder_bottom_centers_y_, &cylinder_bottom_centers_z_,
+      &cylinder_half_heights_, &cylinder_radii_squared_
+    };
+  }
+
+  void scene_soa::reserve(std::size_t num_spheres, std::size_t num_cylinders) {
+    for (aligned_vector<double>* column : sphere_columns()) {
+      column->reserve(padded_count(get_num_spheres() + num_spheres));
+    }
+    sphere_materials_.reserve(get_num_spheres() + num_spheres);
+    for (aligned_vector<double>* column : cylinder_columns()) {
+      column->reserve(padded_count(get_num_cylinders() + num_cylinders));
+    }
+    cylinder_materials_.reserve(get_num_cylinders() + num_cylinders);
+  }
+
+  void scene_soa::reorder(primitive_order order) {
+    if (order == primitive_order::file) {
+      return;
+    }
+    const primitive_permutation permutation = curve_order(get_primitive_bounds(), get_num_spheres(), order);
+    for (aligned_vector<double>* column : sphere_columns()) {
+      permute(*column, permutation.spheres);
+    }
+    permute(sphere_materials_, permutation.spheres);
+    for (aligned_vector<double>* column : cylinder_columns()) {
+      permute(*column, permutation.cylinders);
+    }
+    permute(cylinder_materials_, permutation.cylinders);
+  }
+
+  void scene_soa::add_sphere(const vector& center, double radius, material_id mat) {
+    const size_t index = sphere_materials_.size();
+    reserve_slot(index, sphere_columns());
+
+    sphere_centers_x_[index] = center.get_x();
+    sphere_centers_y_[index] = center.get_y();
+    sphere_centers_z_[index] = center.get_z();
+    sphere_radii_[index] = radius;
     sphere_materials_.push_back(mat);
   }
 
-  void scene_soa::add_cylinder(const vector& center, double radius, const vector& axis, std::shared_ptr<material> mat) {
-    cylinder_centers_x_.push_back(center.get_x());
-    cylinder_centers_y_.push_back(center.get_y());
-    cylinder_centers_z_.push_back(center.get_z());
-    cylinder_radii_.push_back(radius);
-    cylinder_axes_x_.push_back(axis.get_x());
-    cylinder_axes_y_.push_back(axis.get_y());
-    cylinder_axes_z_.push_back(axis.get_z());
+  void scene_soa::add_cylinder(const vector& center, double radius, const vector& axis, material_id mat) {
+    add_cylinder(center, radius, axis, cylinder_frame::make(center, radius, axis), mat);
+  }
+
+  void scene_soa::add_cylinder(const vector& center, double radius, const vector& axis, const cylinder_frame& frame, material_id mat) {
+    const size_t index = cylinder_materials_.size();
+    reserve_slot(index, cylinder_columns());
+
+    cylinder_centers_x_[index] = center.get_x();
+    cylinder_centers_y_[index] = center.get_y();
+    cylinder_centers_z_[index] = center.get_z();
+    cylinder_radii_[index] = radius;
+    cylinder_axes_x_[index] = axis.get_x();
+    cylinder_axes_y_[index] = axis.get_y();
+    cylinder_axes_z_[index] = axis.get_z();
+    cylinder_unit_axes_x_[index] = frame.unit_axis.get_x();
+    cylinder_unit_axes_y_[index] = frame.unit_axis.get_y();
+    cylinder_unit_axes_z_[index] = frame.unit_axis.get_z();
+    cylinder_top_centers_x_[index] = frame.top_center.get_x();
+    cylinder_top_centers_y_[index] = frame.top_center.get_y();
+    cylinder_top_centers_z_[index] = frame.top_center.get_z();
+    cylinder_bottom_centers_x_[index] = frame.bottom_center.get_x();
+    cylinder_bottom_centers_y_[index] = frame.bottom_center.get_y();
+    cylinder_bottom_centers_z_[index] = frame.bottom_center.get_z();
+    cylinder_half_heights_[index] = frame.half_height;
+    cylinder_radii_squared_[index] = frame.radius_squared;
     cylinder_materials_.push_back(mat);
   }
 
+  sphere_lanes scene_soa::get_sphere_lanes() const {
+    return sphere_lanes{
+      sphere_centers_x_.data(), sphere_centers_y_.data(), sphere_centers_z_.data(), sphere_radii_.data(),
+      sphere_radii_.size()
+    };
+  }
+
+  cylinder_lanes scene_soa::get_cylinder_lanes() const {
+    return cylinder_lanes{
+      cylinder_centers_x_.data(), cylinder_centers_y_.data(), cylinder_centers_z_.data(),
+      cylinder_unit_axes_x_.data(), cylinder_unit_axes_y_.data(), cylinder_unit_axes_z_.data(),
+      cylinder_top_centers_x_.data(), cylinder_top_centers_y_.data(), cylinder_top_centers_z_.data(),
+      cylinder_bottom_centers_x_.data(), cylinder_bottom_centers_y_.data(), cylinder_bottom_centers_z_.data(),
+      cylinder_half_heights_.data(), cylinder_radii_squared_.data(),
+      cylinder_radii_squared_.size()
+    };
+  }
+
+  primitive_arrays scene_soa::get_primitive_arrays() const {
+    const size_t num_spheres = get_num_spheres();
+    const size_t num_cylinders = get_num_cylinders();
+    return primitive_arrays{
+      std::span<const double>{sphere_centers_x_}.first(num_spheres),
+      std::span<const double>{sphere_centers_y_}.first(num_spheres),
+      std::span<const double>{sphere_centers_z_}.first(num_spheres),
+      std::span<const double>{sphere_radii_}.first(num_spheres),
+      std::span<const double>{cylinder_centers_x_}.first(num_cylinders),
+      std::span<const double>{cylinder_centers_y_}.first(num_cylinders),
+      std::span<const double>{cylinder_centers_z_}.first(num_cylinders),
+      std::span<const double>{cylinder_radii_}.first(num_cylinders),
+      std::span<const double>{cylinder_axes_x_}.first(num_cylinders),
+      std::span<const double>{cylinder_axes_y_}.first(num_cylinders),
+      std::span<const double>{cylinder_axes_z_}.first(num_cylinders)
+    };
+  }
+
 }
 
@@ -0,0 +1,192 @@
+#include "wavefront_renderer_soa.hpp"
+
+#include "material.hpp"
+#include "ray_packet.hpp"
+#include "renderer_utils.hpp"
+
+#include <algorithm>
+#include <optional>
+#include <utility>
+
+namespace render {
+
+  namespace {
+
+    constexpr auto bucket(material_type type) {
+      return static_cast<std::size_t>(type);
+    }
+
+  }
+
+  template <typename Layout>
+  basic_wavefront_renderer<Layout>::basic_wavefront_renderer(const render_config& config, const camera& cam, const layout_renderer<Layout>& tracer)
+    : config_{config}, camera_{cam}, tracer_{tracer} {}
+
+  template <typename Layout>
+  void basic_wavefront_renderer<Layout>::render_tile(const tile& t, std::vector<pixel_estimate>& pixels) const {
+    const int tile_width = t.x_end - t.x_begin;
+    const auto num_pixels = static_cast<std::size_t>(tile_width) * static_cast<std::size_t>(t.y_end - t.y_begin);
+    pixels.assign(num_pixels, pixel_estimate{});
+
+    const int width = camera_.get_image_width();
+    const int height = camera_.get_image_height();
+    const int samples_per_batch = static_cast<int>(std::max<std::size_t>(1, max_paths / num_pixels));
+    const bool adaptive = config_.adaptive_threshold > 0.0;
+    const sample_pattern pattern = sample_pattern_for(config_);
+
+    queues q;
+    while (true) {
+      // Same streams as the recursive path, addressed by pixel and sample index.
+      q.paths.clear();
+      for (int j = t.y_begin; j < t.y_end; ++j) {
+        for (int i = t.x_begin; i < t.x_end; ++i) {
+          const auto slot = static_cast<std::uint32_t>((j - t.y_begin) * tile_width + (i - t.x_begin));
+          const pixel_estimate& estimate = pixels[slot];
+          if (!estimate.needs_sample(config_)) {
+            continue;
+          }
+          // Past the minimum batch, adaptive sampling looks at every new sample.
+          const int s_begin = estimate.count;
+          const int next_check = adaptive && s_begin >= config_.adaptive_min_samples ? s_begin + 1 : config_.samples_per_pixel;
+          const int s_end = std::min({config_.samples_per_pixel, next_check, s_begin + samples_per_batch});
+          const auto pixel = static_cast<std::uint64_t>(j) * static_cast<std::uint64_t>(width) + static_cast<std::uint64_t>(i);
+          for (int s = s_begin; s < s_end; ++s) {
+            random_stream ray_rng{config_.ray_rng_seed, pixel, static_cast<std::uint32_t>(s), random_domain::camera, pattern};
+            const double u = (static_cast<double>(i) + ray_rng.uniform()) / static_cast<double>(width);
+            const double v = (static_cast<double>(j) + ray_rng.uniform()) / static_cast<double>(height);
+            q.paths.push_back(wavefront_path{
+              camera_.get_ray(u, v),
+              vector{1.0, 1.0, 1.0},
+              random_stream{config_.material_rng_seed, pixel, static_cast<std::uint32_t>(s), random_domain::material, pattern},
+              slot
+            });
+          }
+        }
+      }
+      if (q.paths.empty()) {
+        return;
+      }
+
+      q.colors.assign(q.paths.size(), vector{0.0, 0.0, 0.0});
+      q.active.resize(q.paths.size());
+      for (std::size_t k = 0; k < q.active.size(); ++k) {
+        q.active[k] = static_cast<std::uint32_t>(k);
+      }
+      trace_paths(q);
+
+      // Paths were queued pixel by pixel in sample order.
+      for (std::size_t k = 0; k < q.paths.size(); ++k) {
+        pixels[q.paths[k].slot].add(q.colors[k]);
+      }
+    }
+  }
+
+  template <typename Layout>
+  void basic_wavefront_renderer<Layout>::trace_paths(queues& q) const {
+    // Paths still alive after max_depth bounces contribute nothing, as in trace_ray.
+    for (int depth = 0; depth < config_.max_depth && !q.active.empty(); ++depth) {
+      intersect_paths(q, depth);
+
+      q.next.clear();
+      scatter_matte(q, depth);
+      scatter_metal(q, depth);
+      scatter_refractive(q, depth);
+      std::swap(q.active, q.next);
+    }
+  }
+
+  template <typename Layout>
+  void basic_wavefront_renderer<Layout>::intersect_paths(queues& q, int depth) const {
+    const material_table& materials = tracer_.layout_.get_materials();
+    for (auto& hits : q.by_material) {
+      hits.clear();
+    }
+
+    // Misses are finished; hits are compacted into one queue per material.
+    const auto sort_hit = [&](std::uint32_t index, const std::optional<hit_info>& hit) {
+      const wavefront_path& path = q.paths[index];
+      if (!hit) {
+        q.colors[index] = path.throughput.multiply(tracer_.get_background_color(path.r));
+        return;
+      }
+      q.by_material[bucket(materials.get_type(hit->mat))].push_back(pending_hit{*hit, index});
+    };
+
+    // Camera rays are queued pixel by pixel, so runs of them are coherent
+    // enough for packets; scattered rays are traced one at a time.
+    if (depth > 0) {
+      for (const std::uint32_t index : q.active) {
+        auto hit = tracer_.find_closest_hit(q.paths[index].r);
+        sort_hit(index, hit);
+      }
+      return;
+    }
+
+    ray_packet packet;
+    std::array<std::optional<hit_info>, ray_packet::capacity> hits;
+    for (std::size_t base = 0; base < q.active.size(); base += ray_packet::capacity) {
+      packet.count = std::min(ray_packet::capacity, q.active.size() - base);
+      for (std::size_t k = 0; k < packet.count; ++k) {
+        const ray& r = q.paths[q.active[base + k]].r;
+        packet.origin_x[k] = r.get_origin().get_x();
+        packet.origin_y[k] = r.get_origin().get_y();
+        packet.origin_z[k] = r.get_origin().get_z();
+        packet.direction_x[k] = r.get_direction().get_x();
+        packet.direction_y[k] = r.get_direction().get_y();
+        packet.direction_z[k] = r.get_direction().get_z();
+      }
+      tracer_.find_closest_hits(packet, hits);
+      for (std::size_t k = 0; k < packet.count; ++k) {
+        sort_hit(q.active[base + k], hits[k]);
+      }
+    }
+  }
+
+  template <typename Layout>
+  void basic_wavefront_renderer<Layout>::advance(queues& q, std::uint32_t index, const std::optional<scatter_event>& event, int depth) const {
+    if (!event) {
+      return;
+    }
+    wavefront_path& path = q.paths[index];
+    path.throughput = path.throughput.multiply(event->attenuation);
+    if (continue_path(config_, depth, path.throughput, path.rng)) {
+      path.r = event->scattered;
+      q.next.push_back(index);
+    }
+  }
+
+  // One loop per material over the hits sorted into its queue, each calling
+  // the matching layout_renderer scatter function directly.
+
+  template <typename Layout>
+  void basic_wavefront_renderer<Layout>::scatter_matte(queues& q, int depth) const {
+    for (const pending_hit& pending : q.by_material[bucket(material_type::matte)]) {
+      random_stream& rng = q.paths[pending.path].rng;
+      rng.set_bounce(static_cast<std::uint32_t>(depth));
+      advance(q, pending.path, tracer_.scatter_matte(pending.hit, rng), depth);
+    }
+  }
+
+  template <typename Layout>
+  void basic_wavefront_renderer<Layout>::scatter_metal(queues& q, int depth) const {
+    for (const pending_hit& pending : q.by_material[bucket(material_type::metal)]) {
+      wavefront_path& path = q.paths[pending.path];
+      path.rng.set_bounce(static_cast<std::uint32_t>(depth));
+      advance(q, pending.path, tracer_.scatter_metal(path.r, pending.hit, path.rng), depth);
+    }
+  }
+
+  template <typename Layout>
+  void basic_wavefront_renderer<Layout>::scatter_refractive(queues& q, int depth) const {
+    for (const pending_hit& pending : q.by_material[bucket(material_type::refractive)]) {
+      wavefront_path& path = q.paths[pending.path];
+      path.rng.set_bounce(static_cast<std::uint32_t>(depth));
+      advance(q, pending.path, tracer_.scatter_refractive(path.r, pending.hit, path.rng), depth);
+    }
+  }
+
+  template class basic_wavefront_renderer<aos_layout<double>>;
+  template class basic_wavefront_renderer<soa_layout>;
+  template class basic_wavefront_renderer<aosoa_layout>;
+
+}
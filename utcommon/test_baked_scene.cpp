@@ -0,0 +1,110 @@
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <memory>
+
+#include "baked_scene.hpp"
+#include "cylinder.hpp"
+#include "material.hpp"
+#include "scene.hpp"
+#include "sphere.hpp"
+
+namespace {
+
+    render::scene make_scene() {
+        render::scene sc;
+        const render::material_id matte = sc.add_material(render::matte_material{"matte", 0.5, 0.5, 0.5});
+        const render::material_id metal = sc.add_material(render::metal_material{"metal", 0.8, 0.8, 0.8, 0.1});
+        sc.add_sphere(std::make_shared<render::sphere>(render::vector{0.0, 0.0, -5.0}, 1.5, matte));
+        sc.add_sphere(std::make_shared<render::sphere>(render::vector{3.0, 0.0, -5.0}, 0.5, metal));
+        sc.add_cylinder(std::make_shared<render::cylinder>(render::vector{-3.0, 0.0, -5.0}, 0.75, render::vector{0.0, 2.0, 0.0}, metal));
+        return sc;
+    }
+
+}
+
+TEST(test_baked_scene, precomputes_records_and_bounds) {
+    const render::scene sc = make_scene();
+    const render::baked_scene baked{sc};
+
+    ASSERT_EQ(baked.get_spheres().size(), 2);
+    ASSERT_EQ(baked.get_cylinders().size(), 1);
+    EXPECT_EQ(baked.get_spheres()[0].radius_squared, 1.5 * 1.5);
+    EXPECT_EQ(baked.get_spheres()[1].mat, sc.get_spheres()[1]->get_material());
+    EXPECT_EQ(baked.get_cylinders()[0].frame.half_height, sc.get_cylinders()[0]->get_frame().half_height);
+    EXPECT_EQ(baked.get_cylinders()[0].mat, sc.get_cylinders()[0]->get_material());
+    EXPECT_EQ(baked.get_materials().size(), 2);
+
+    const auto expected = sc.get_primitive_bounds();
+    const auto bounds = baked.get_primitive_bounds();
+    ASSERT_EQ(bounds.size(), expected.size());
+    for (size_t i = 0; i < bounds.size(); ++i) {
+        EXPECT_EQ(bounds[i].min, expected[i].min);
+        EXPECT_EQ(bounds[i].max, expected[i].max);
+    }
+}
+
+TEST(test_baked_scene, sections_are_cache_line_aligned) {
+    const render::baked_scene baked{make_scene()};
+
+    EXPECT_EQ(reinterpret_cast<std::uintptr_t>(baked.get_spheres().data()) % render::cache_line_size, 0);
+    EXPECT_EQ(reinterpret_cast<std::uintptr_t>(baked.get_cylinders().data()) % render::cache_line_size, 0);
+    EXPECT_EQ(reinterpret_cast<std::uintptr_t>(baked.get_primitive_bounds().data()) % render::cache_line_size, 0);
+    EXPECT_EQ(baked.get_memory_bytes() % render::cache_line_size, 0);
+}
+
+TEST(test_baked_scene, hits_match_parsed_primitives) {
+    const render::scene sc = make_scene();
+    const render::baked_scene baked{sc};
+
+    for (const double x : {-3.2, -3.0, 0.3, 2.9, 5.0}) {
+        const render::ray r{render::vector{0.0, 0.5, 0.0}, render::vector{x, -0.5, -5.0}};
+        for (size_t i = 0; i < sc.get_spheres().size(); ++i) {
+            const auto expected = sc.get_spheres()[i]->hit_distance(r, 0.0001, 1e9);
+            const auto t = baked.get_spheres()[i].hit_distance(r, 0.0001, 1e9);
+            ASSERT_EQ(t.has_value(), expected.has_value());
+            if (t) {
+                EXPECT_EQ(*t, *expected);
+            }
+        }
+        const auto expected = sc.get_cylinders()[0]->intersect(r);
+        const auto t = baked.get_cylinders()[0].hit_distance(r, 0.0001, 1e9);
+        ASSERT_EQ(t.has_value(), expected.has_value());
+        if (t) {
+            const render::hit_info hit = baked.get_cylinders()[0].surface_at(r, *t);
+            EXPECT_EQ(hit.t, expected->t);
+            EXPECT_EQ(hit.normal.get_x(), expected->normal.get_x());
+            EXPECT_EQ(hit.normal.get_y(), expected->normal.get_y());
+            EXPECT_EQ(hit.normal.get_z(), expected->normal.get_z());
+        }
+    }
+}
+
+TEST(test_baked_scene, single_precision_bake) {
+    const render::scene sc = make_scene();
+    const render::basic_baked_scene<float> baked{sc};
+
+    ASSERT_EQ(baked.get_spheres().size(), 2);
+    EXPECT_EQ(baked.get_spheres()[1].radius_squared, 0.25f);
+    EXPECT_EQ(baked.get_cylinders()[0].frame.half_height, 1.0f);
+
+    // Rays are rounded to float as well and find the same surfaces.
+    const render::ray r{render::vector{0.0, 0.0, 0.0}, render::vector{0.0, 0.0, -1.0}};
+    const auto expected = sc.get_spheres()[0]->hit_distance(r, 0.0001, 1e9);
+    const auto t = baked.get_spheres()[0].hit_distance(render::basic_ray<float>{r}, 0.0001f, 1e9f);
+    ASSERT_TRUE(expected && t);
+    EXPECT_NEAR(*t, *expected, 1e-5);
+
+    for (size_t i = 0; i < baked.get_primitive_bounds().size(); ++i) {
+        EXPECT_LE(baked.get_primitive_bounds()[i].min[0], sc.get_primitive_bounds()[i].min[0] + 1e-6);
+        EXPECT_GE(baked.get_primitive_bounds()[i].max[0], sc.get_primitive_bounds()[i].max[0] - 1e-6);
+    }
+}
+
+TEST(test_baked_scene, empty_scene) {
+    const render::baked_scene baked{render::scene{}};
+
+    EXPECT_TRUE(baked.get_spheres().empty());
+    EXPECT_TRUE(baked.get_cylinders().empty());
+    EXPECT_TRUE(baked.get_primitive_bounds().empty());
+    EXPECT_EQ(baked.get_memory_bytes(), 0);
+}
@@ -0,0 +1,216 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <random>
+#include <vector>
+
+#include "aabb.hpp"
+#include "bvh.hpp"
+#include "cylinder.hpp"
+#include "material.hpp"
+#include "ray.hpp"
+#include "sphere.hpp"
+
+TEST(test_aabb, slab_intersection) {
+    const auto box = render::make_sphere_bounds(render::vector{0.0, 0.0, 0.0}, 1.0);
+    const std::array<double, 3> origin{0.0, 0.0, 5.0};
+    const std::array<double, 3> towards{1.0 / 0.0001, 1.0 / 0.0001, -1.0};
+    const std::array<double, 3> away{1.0 / 0.0001, 1.0 / 0.0001, 1.0};
+
+    EXPECT_NEAR(box.intersect(origin, towards, 0.0, 100.0), 4.0, 1e-9);
+    EXPECT_LT(box.intersect(origin, away, 0.0, 100.0), 0.0);
+    EXPECT_LT(box.intersect(origin, towards, 0.0, 3.0), 0.0);
+}
+
+TEST(test_aabb, cylinder_bounds_contain_caps) {
+    const render::vector center{1.0, 2.0, 3.0};
+    const render::vector axis{0.0, 4.0, 0.0};
+    const auto box = render::make_cylinder_bounds(center, 0.5, axis);
+
+    EXPECT_NEAR(box.min[0], 0.5, 1e-12);
+    EXPECT_NEAR(box.max[0], 1.5, 1e-12);
+    EXPECT_NEAR(box.min[1], 0.0, 1e-12);
+    EXPECT_NEAR(box.max[1], 4.0, 1e-12);
+    EXPECT_NEAR(box.min[2], 2.5, 1e-12);
+    EXPECT_NEAR(box.max[2], 3.5, 1e-12);
+}
+
+TEST(test_bvh, empty_and_single) {
+    const auto empty = render::bvh::build_sah({});
+    EXPECT_TRUE(empty.get_nodes().empty());
+
+    const auto single = render::bvh::build_sah(std::vector<render::aabb>{render::make_sphere_bounds(render::vector{0.0, 0.0, 0.0}, 1.0)});
+    ASSERT_EQ(single.get_nodes().size(), 1);
+    EXPECT_EQ(single.get_nodes()[0].count, 1);
+}
+
+namespace {
+
+    struct random_scene {
+        std::vector<render::sphere> spheres;
+        std::vector<render::cylinder> cylinders;
+        std::vector<render::aabb> bounds;
+
+        [[nodiscard]] std::optional<render::hit_info> intersect(std::uint32_t prim, const render::ray& r) const {
+            return prim < spheres.size() ? spheres[prim].intersect(r) : cylinders[prim - spheres.size()].intersect(r);
+        }
+    };
+
+    random_scene make_random_scene(std::mt19937& rng, int count) {
+        const render::material_id mat = 0;
+        std::uniform_real_distribution<double> coord(-20.0, 20.0);
+        std::uniform_real_distribution<double> size(0.1, 2.0);
+
+        random_scene scene;
+        for (int i = 0; i < count; ++i) {
+            scene.spheres.emplace_back(render::vector{coord(rng), coord(rng), coord(rng)}, size(rng), mat);
+            scene.cylinders.emplace_back(render::vector{coord(rng), coord(rng), coord(rng)}, size(rng), render::vector{coord(rng), coord(rng), coord(rng)} * 0.1, mat);
+        }
+        for (const auto& s : scene.spheres) {
+            scene.bounds.push_back(s.bounds());
+        }
+        for (const auto& c : scene.cylinders) {
+            scene.bounds.push_back(c.bounds());
+        }
+        return scene;
+    }
+
+    void expect_matches_brute_force(const render::bvh& tree, const random_scene& scene, std::mt19937& rng) {
+        std::uniform_real_distribution<double> coord(-20.0, 20.0);
+
+        int hits = 0;
+        for (int i = 0; i < 500; ++i) {
+            const render::ray r{render::vector{coord(rng), coord(rng), coord(rng)},
+                                render::vector{coord(rng), coord(rng), coord(rng)}.normalize()};
+
+            double expected = std::numeric_limits<double>::max();
+            for (std::uint32_t prim = 0; prim < scene.bounds.size(); ++prim) {
+                const auto hit = scene.intersect(prim, r);
+                if (hit && hit->t < expected) {
+                    expected = hit->t;
+                }
+            }
+
+            double found = std::numeric_limits<double>::max();
+            tree.traverse(r, 0.0001, found, [&](std::uint32_t prim, double t_max) -> std::optional<double> {
+                const auto hit = scene.intersect(prim, r);
+                if (hit && hit->t < t_max) {
+                    found = hit->t;
+                    return hit->t;
+                }
+                return std::nullopt;
+            });
+
+            EXPECT_DOUBLE_EQ(found, expected);
+            hits += (expected < std::numeric_limits<double>::max()) ? 1 : 0;
+        }
+        EXPECT_GT(hits, 50);
+    }
+
+}
+
+TEST(test_bvh, matches_brute_force) {
+    std::mt19937 rng(7);
+    const auto scene = make_random_scene(rng, 300);
+    const auto tree = render::bvh::build_sah(scene.bounds);
+    EXPECT_LE(tree.get_depth(), 64);
+
+    expect_matches_brute_force(tree, scene, rng);
+}
+
+TEST(test_bvh, packet_traversal_matches_brute_force) {
+    std::mt19937 rng(13);
+    const auto scene = make_random_scene(rng, 300);
+    const auto tree = render::bvh::build_sah(scene.bounds);
+    std::uniform_real_distribution<double> coord(-20.0, 20.0);
+
+    int hits = 0;
+    for (int p = 0; p < 60; ++p) {
+        render::ray_packet packet;
+        packet.count = (p % 3 == 0) ? 7 : render::ray_packet::capacity;
+        const render::vector origin{coord(rng), coord(rng), coord(rng)};
+        const render::vector towards{coord(rng), coord(rng), coord(rng)};
+        for (size_t k = 0; k < packet.count; ++k) {
+            const render::vector d = (towards + render::vector{coord(rng), coord(rng), coord(rng)} * 0.2 - origin).normalize();
+            packet.origin_x[k] = origin.get_x();
+            packet.origin_y[k] = origin.get_y();
+            packet.origin_z[k] = origin.get_z();
+            packet.direction_x[k] = d.get_x();
+            packet.direction_y[k] = d.get_y();
+            packet.direction_z[k] = d.get_z();
+        }
+
+        std::array<double, render::ray_packet::capacity> found;
+        found.fill(std::numeric_limits<double>::max());
+        tree.traverse_packet(packet, 0.0001, found.data(), [&](std::uint32_t prim) {
+            for (size_t k = 0; k < packet.count; ++k) {
+                const auto hit = scene.intersect(prim, packet.get_ray(k));
+                if (hit && hit->t < found[k]) {
+                    found[k] = hit->t;
+                }
+            }
+        });
+
+        for (size_t k = 0; k < packet.count; ++k) {
+            double expected = std::numeric_limits<double>::max();
+            for (std::uint32_t prim = 0; prim < scene.bounds.size(); ++prim) {
+                const auto hit = scene.intersect(prim, packet.get_ray(k));
+                if (hit && hit->t < expected) {
+                    expected = hit->t;
+                }
+            }
+            EXPECT_DOUBLE_EQ(found[k], expected);
+            hits += (expected < std::numeric_limits<double>::max()) ? 1 : 0;
+        }
+    }
+    EXPECT_GT(hits, 50);
+}
+
+TEST(test_lbvh, empty_and_single) {
+    render::thread_pool pool{2};
+    const auto empty = render::bvh::build_lbvh(std::vector<render::aabb>{}, pool);
+    EXPECT_TRUE(empty.get_nodes().empty());
+
+    const auto single = render::bvh::build_lbvh(std::vector<render::aabb>{render::make_sphere_bounds(render::vector{0.0, 0.0, 0.0}, 1.0)}, pool);
+    ASSERT_EQ(single.get_nodes().size(), 1);
+    EXPECT_EQ(single.get_nodes()[0].count, 1);
+}
+
+TEST(test_lbvh, matches_brute_force) {
+    std::mt19937 rng(11);
+    const auto scene = make_random_scene(rng, 300);
+    render::thread_pool pool{3};
+    const auto tree = render::bvh::build_lbvh(scene.bounds, pool);
+
+    ASSERT_EQ(tree.get_nodes().size(), 2 * scene.bounds.size() - 1);
+    std::vector<std::uint32_t> indices(tree.get_primitive_indices().begin(), tree.get_primitive_indices().end());
+    std::sort(indices.begin(), indices.end());
+    for (std::uint32_t i = 0; i < indices.size(); ++i) {
+        EXPECT_EQ(indices[i], i);
+    }
+
+    expect_matches_brute_force(tree, scene, rng);
+}
+
+TEST(test_lbvh, duplicate_centroids) {
+    render::thread_pool pool{2};
+    const std::vector<render::aabb> bounds(64, render::make_sphere_bounds(render::vector{1.0, 2.0, 3.0}, 0.5));
+    const auto tree = render::bvh::build_lbvh(bounds, pool);
+
+    EXPECT_EQ(tree.get_nodes().size(), 2 * bounds.size() - 1);
+    EXPECT_LE(tree.get_depth(), 8);
+}
+
+TEST(test_lbvh, independent_of_thread_count) {
+    std::mt19937 rng(5);
+    const auto scene = make_random_scene(rng, 200);
+    render::thread_pool one{1};
+    render::thread_pool many{4};
+
+    const auto single = render::bvh::build_lbvh(scene.bounds, one);
+    const auto parallel = render::bvh::build_lbvh(scene.bounds, many);
+    EXPECT_TRUE(std::ranges::equal(single.get_primitive_indices(), parallel.get_primitive_indices()));
+}
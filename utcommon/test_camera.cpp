@@ -0,0 +1,40 @@
+#include <gtest/gtest.h>
+#include <random>
+
+#include "camera.hpp"
+#include "config.hpp"
+#include "ray_packet.hpp"
+
+TEST(test_camera, packet_rays_match_single_rays) {
+    render::render_config config;
+    config.image_width = 64;
+    config.camera_position = render::vector{1.0, 2.0, 3.0};
+    config.camera_target = render::vector{-2.0, 0.5, -4.0};
+    config.field_of_view = 70.0;
+    const render::camera cam{config};
+
+    std::mt19937 rng(3);
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+    for (size_t count : {size_t{1}, size_t{5}, render::ray_packet::capacity}) {
+        double u[render::ray_packet::capacity];
+        double v[render::ray_packet::capacity];
+        for (size_t k = 0; k < count; ++k) {
+            u[k] = unit(rng);
+            v[k] = unit(rng);
+        }
+
+        render::ray_packet packet;
+        packet.count = count;
+        cam.get_rays(u, v, packet);
+        for (size_t k = 0; k < count; ++k) {
+            const render::ray expected = cam.get_ray(u[k], v[k]);
+            const render::ray actual = packet.get_ray(k);
+            EXPECT_EQ(actual.get_origin().get_x(), expected.get_origin().get_x());
+            EXPECT_EQ(actual.get_origin().get_y(), expected.get_origin().get_y());
+            EXPECT_EQ(actual.get_origin().get_z(), expected.get_origin().get_z());
+            EXPECT_EQ(actual.get_direction().get_x(), expected.get_direction().get_x());
+            EXPECT_EQ(actual.get_direction().get_y(), expected.get_direction().get_y());
+            EXPECT_EQ(actual.get_direction().get_z(), expected.get_direction().get_z());
+        }
+    }
+}
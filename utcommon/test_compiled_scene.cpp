@@ -0,0 +1,172 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <optional>
+#include <string>
+
+#include "baked_scene.hpp"
+#include "bvh.hpp"
+#include "compiled_scene.hpp"
+#include "config.hpp"
+#include "cylinder.hpp"
+#include "material.hpp"
+#include "scene.hpp"
+#include "sphere.hpp"
+
+namespace {
+
+    render::scene make_scene() {
+        render::scene sc;
+        const render::material_id matte = sc.add_material(render::matte_material{"matte", 0.5, 0.5, 0.5});
+        const render::material_id glass = sc.add_material(render::refractive_material{"glass", 1.5});
+        for (int i = 0; i < 11; ++i) {
+            sc.add_sphere(std::make_shared<render::sphere>(render::vector{i * 2.0, 0.0, -5.0}, 0.5, i % 2 == 0 ? matte : glass));
+        }
+        sc.add_cylinder(std::make_shared<render::cylinder>(render::vector{-3.0, 0.0, -5.0}, 0.75, render::vector{0.0, 2.0, 0.0}, glass));
+        return sc;
+    }
+
+}
+
+TEST(test_compiled_scene, round_trips_columns_materials_and_bvh) {
+    const std::string test_file = "test_compiled_scene.bin";
+    const render::baked_scene baked{make_scene()};
+    render::render_config config;
+    config.acceleration = render::acceleration_type::bvh;
+    const auto accel = render::build_acceleration(config, baked.get_primitive_bounds());
+    render::write_compiled_scene(test_file, baked, config, accel);
+
+    ASSERT_TRUE(render::is_compiled_scene(test_file));
+    const auto compiled = render::compiled_scene::open(test_file);
+    ASSERT_EQ(compiled.get_num_spheres(), 11);
+    ASSERT_EQ(compiled.get_num_cylinders(), 1);
+    EXPECT_EQ(compiled.get_materials().size(), 2);
+    EXPECT_EQ(compiled.get_materials().get_type(1), render::material_type::refractive);
+    EXPECT_EQ(compiled.get_materials().get_refractive(1).r0, baked.get_materials().get_refractive(1).r0);
+
+    // Columns are padded with NaN and aligned like scene_soa's.
+    const render::sphere_lanes spheres = compiled.get_sphere_lanes();
+    EXPECT_EQ(spheres.count, 16);
+    EXPECT_EQ(reinterpret_cast<std::uintptr_t>(spheres.centers_x) % render::cache_line_size, 0);
+    EXPECT_EQ(spheres.centers_x[10], 20.0);
+    EXPECT_TRUE(std::isnan(spheres.centers_x[11]));
+    EXPECT_EQ(compiled.get_sphere_materials()[3], baked.get_spheres()[3].mat);
+    const render::cylinder_lanes cylinders = compiled.get_cylinder_lanes();
+    EXPECT_EQ(cylinders.half_heights[0], baked.get_cylinders()[0].frame.half_height);
+    EXPECT_EQ(compiled.get_primitive_arrays().cylinder_axes_y[0], 2.0);
+
+    // The stored tree is used as is when the config asks for the same kind.
+    const auto loaded = compiled.load_acceleration(config);
+    ASSERT_TRUE(loaded.has_value());
+    ASSERT_EQ(loaded->get_nodes().size(), accel->get_nodes().size());
+    EXPECT_TRUE(std::ranges::equal(loaded->get_primitive_indices(), accel->get_primitive_indices()));
+    const render::bvh copy = *loaded;
+    EXPECT_EQ(copy.get_nodes().data(), loaded->get_nodes().data());
+
+    const render::scene rebuilt = compiled.to_scene();
+    ASSERT_EQ(rebuilt.get_spheres().size(), 11);
+    EXPECT_EQ(rebuilt.get_cylinders()[0]->get_material(), baked.get_cylinders()[0].mat);
+    EXPECT_EQ(rebuilt.get_spheres()[4]->get_center().get_x(), 8.0);
+
+    std::remove(test_file.c_str());
+}
+
+TEST(test_compiled_scene, rejects_other_files) {
+    const std::string test_file = "test_compiled_scene_bad.bin";
+    {
+        std::ofstream file(test_file);
+        file << "matte: mat1 0.5 0.5 0.5\n";
+    }
+    EXPECT_FALSE(render::is_compiled_scene(test_file));
+    EXPECT_THROW((void)render::compiled_scene::open(test_file), std::runtime_error);
+
+    const render::baked_scene baked{make_scene()};
+    render::write_compiled_scene(test_file, baked, render::render_config{}, std::nullopt);
+    std::filesystem::resize_file(test_file, std::filesystem::file_size(test_file) - 8);
+    EXPECT_TRUE(render::is_compiled_scene(test_file));
+    EXPECT_THROW((void)render::compiled_scene::open(test_file), std::runtime_error);
+
+    std::remove(test_file.c_str());
+}
+
+TEST(test_compiled_scene, rejects_corrupted_bvh) {
+    const std::string test_file = "test_compiled_scene_bvh.bin";
+    const render::baked_scene baked{make_scene()};
+    render::render_config config;
+    config.acceleration = render::acceleration_type::bvh;
+    const auto accel = render::build_acceleration(config, baked.get_primitive_bounds());
+
+    // Overwrites one 32-bit word of a freshly written file at the given offset
+    // into the section.
+    const auto corrupt = [&](render::compiled_section which, std::uint64_t offset, std::uint32_t value) {
+        render::write_compiled_scene(test_file, baked, config, accel);
+        render::compiled_scene_header header{};
+        std::fstream file(test_file, std::ios::in | std::ios::out | std::ios::binary);
+        file.read(reinterpret_cast<char*>(&header), sizeof(header));
+        file.seekp(static_cast<std::streamoff>(header.sections[static_cast<std::size_t>(which)][0] + offset));
+        file.write(reinterpret_cast<const char*>(&value), sizeof(value));
+    };
+    const auto root_offset = offsetof(render::bvh_node, offset);
+
+    corrupt(render::compiled_section::bvh_indices, 0, 0x7fffff00U);
+    EXPECT_THROW((void)render::compiled_scene::open(test_file), std::runtime_error);
+
+    // The root is interior; point its second child past the node list, then
+    // back at itself.
+    ASSERT_EQ(accel->get_nodes()[0].count, 0U);
+    corrupt(render::compiled_section::bvh_nodes, root_offset, static_cast<std::uint32_t>(accel->get_nodes().size()));
+    EXPECT_THROW((void)render::compiled_scene::open(test_file), std::runtime_error);
+    corrupt(render::compiled_section::bvh_nodes, root_offset, 0U);
+    EXPECT_THROW((void)render::compiled_scene::open(test_file), std::runtime_error);
+
+    // A leaf whose range runs past the index list.
+    const auto leaf = static_cast<std::uint64_t>(std::ranges::find_if(accel->get_nodes(), [](const render::bvh_node& node) { return node.count > 0; }) -
+                                                 accel->get_nodes().begin());
+    corrupt(render::compiled_section::bvh_nodes, leaf * sizeof(render::bvh_node) + root_offset, 0xfffffff0U);
+    EXPECT_THROW((void)render::compiled_scene::open(test_file), std::runtime_error);
+
+    // Rewriting a word with its own value (material 0 is matte) is harmless.
+    corrupt(render::compiled_section::materials, 0, 0U);
+    EXPECT_NO_THROW((void)render::compiled_scene::open(test_file));
+
+    std::remove(test_file.c_str());
+}
+
+TEST(test_compiled_scene, rejects_counts_whose_sizes_overflow) {
+    const std::string test_file = "test_compiled_scene_counts.bin";
+    const render::baked_scene baked{make_scene()};
+    render::render_config config;
+    config.acceleration = render::acceleration_type::bvh;
+    const auto accel = render::build_acceleration(config, baked.get_primitive_bounds());
+
+    // Adds to one count of a freshly written header. A multiple of 2^62 leaves
+    // every section size computed from it unchanged modulo 2^64.
+    const auto grow = [&](std::size_t count_offset, std::uint64_t extra) {
+        render::write_compiled_scene(test_file, baked, config, accel);
+        std::fstream file(test_file, std::ios::in | std::ios::out | std::ios::binary);
+        std::uint64_t count = 0;
+        file.seekg(static_cast<std::streamoff>(count_offset));
+        file.read(reinterpret_cast<char*>(&count), sizeof(count));
+        count += extra;
+        file.seekp(static_cast<std::streamoff>(count_offset));
+        file.write(reinterpret_cast<const char*>(&count), sizeof(count));
+    };
+    constexpr std::uint64_t wrap = std::uint64_t{1} << 62;
+
+    grow(offsetof(render::compiled_scene_header, num_spheres), wrap);
+    EXPECT_THROW((void)render::compiled_scene::open(test_file), std::runtime_error);
+    grow(offsetof(render::compiled_scene_header, num_cylinders), wrap);
+    EXPECT_THROW((void)render::compiled_scene::open(test_file), std::runtime_error);
+    grow(offsetof(render::compiled_scene_header, num_indices), wrap);
+    EXPECT_THROW((void)render::compiled_scene::open(test_file), std::runtime_error);
+    grow(offsetof(render::compiled_scene_header, num_materials), 0);
+    EXPECT_NO_THROW((void)render::compiled_scene::open(test_file));
+
+    std::remove(test_file.c_str());
+}
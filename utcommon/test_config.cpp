@@ -2,6 +2,7 @@
 #include <fstream>
 #include <cstdio>
 
+#include "command_line.hpp"
 #include "config.hpp"
 
 TEST(test_config_parser, basic_config) {
@@ -58,3 +59,237 @@ TEST(test_config_parser, unknown_parameter) {
     std::remove(test_file.c_str());
 }
 
+
+TEST(test_config_parser, threading_parameters) {
+    const std::string test_file = "test_config3.txt";
+    std::ofstream file(test_file);
+    file << "threads: 4\n";
+    file << "tile_size: 32\n";
+    file.close();
+
+    auto config = render::config_parser::parse(test_file);
+    EXPECT_EQ(config.threads, 4);
+    EXPECT_EQ(config.tile_size, 32);
+
+    std::remove(test_file.c_str());
+}
+
+TEST(test_config_parser, acceleration_parameter) {
+    const std::string test_file = "test_config4.txt";
+    std::ofstream file(test_file);
+    file << "acceleration: none\n";
+    file.close();
+
+    auto config = render::config_parser::parse(test_file);
+    EXPECT_EQ(config.acceleration, render::acceleration_type::none);
+    EXPECT_EQ(render::render_config{}.acceleration, render::acceleration_type::bvh);
+
+    std::ofstream lbvh(test_file);
+    lbvh << "acceleration: lbvh\n";
+    lbvh.close();
+    EXPECT_EQ(render::config_parser::parse(test_file).acceleration, render::acceleration_type::lbvh);
+
+    std::ofstream bad(test_file);
+    bad << "acceleration: octree\n";
+    bad.close();
+    EXPECT_THROW(render::config_parser::parse(test_file), std::runtime_error);
+
+    std::remove(test_file.c_str());
+}
+
+TEST(test_config_parser, engine_parameter) {
+    const std::string test_file = "test_config5.txt";
+    std::ofstream file(test_file);
+    file << "engine: wavefront\n";
+    file.close();
+
+    EXPECT_EQ(render::config_parser::parse(test_file).engine, render::render_engine::wavefront);
+    EXPECT_EQ(render::render_config{}.engine, render::render_engine::recursive);
+
+    std::ofstream bad(test_file);
+    bad << "engine: wavefront recursive\n";
+    bad.close();
+    EXPECT_THROW(render::config_parser::parse(test_file), std::runtime_error);
+
+    std::remove(test_file.c_str());
+}
+
+TEST(test_config_parser, russian_roulette_depth) {
+    const std::string test_file = "test_config6.txt";
+    std::ofstream file(test_file);
+    file << "russian_roulette_depth: 3\n";
+    file.close();
+
+    EXPECT_EQ(render::config_parser::parse(test_file).russian_roulette_depth, 3);
+    EXPECT_EQ(render::render_config{}.russian_roulette_depth, 0);
+
+    std::ofstream bad(test_file);
+    bad << "russian_roulette_depth: -1\n";
+    bad.close();
+    EXPECT_THROW(render::config_parser::parse(test_file), std::runtime_error);
+
+    std::remove(test_file.c_str());
+}
+
+TEST(test_config_parser, precision_parameter) {
+    const std::string test_file = "test_config7.txt";
+    std::ofstream file(test_file);
+    file << "precision: float\n";
+    file.close();
+
+    EXPECT_EQ(render::config_parser::parse(test_file).precision, render::render_precision::single_precision);
+    EXPECT_EQ(render::render_config{}.precision, render::render_precision::double_precision);
+
+    std::ofstream bad(test_file);
+    bad << "precision: half\n";
+    bad.close();
+    EXPECT_THROW(render::config_parser::parse(test_file), std::runtime_error);
+
+    std::remove(test_file.c_str());
+}
+
+TEST(test_config_parser, layout_parameter) {
+    const std::string test_file = "test_config8.txt";
+    std::ofstream file(test_file);
+    file << "layout: aosoa\n";
+    file.close();
+
+    EXPECT_EQ(render::config_parser::parse(test_file).layout, render::memory_layout::aosoa);
+    EXPECT_FALSE(render::render_config{}.layout.has_value());
+
+    std::ofstream bad(test_file);
+    bad << "layout: soaos\n";
+    bad.close();
+    EXPECT_THROW(render::config_parser::parse(test_file), std::runtime_error);
+
+    std::remove(test_file.c_str());
+}
+
+TEST(test_config_parser, primitive_order_parameter) {
+    const std::string test_file = "test_config9.txt";
+    std::ofstream file(test_file);
+    file << "primitive_order: hilbert\n";
+    file.close();
+
+    EXPECT_EQ(render::config_parser::parse(test_file).ordering, render::primitive_order::hilbert);
+    EXPECT_EQ(render::render_config{}.ordering, render::primitive_order::file);
+
+    std::ofstream bad(test_file);
+    bad << "primitive_order: z-curve\n";
+    bad.close();
+    EXPECT_THROW(render::config_parser::parse(test_file), std::runtime_error);
+
+    std::remove(test_file.c_str());
+}
+
+TEST(test_config_parser, output_format_parameter) {
+    const std::string test_file = "test_config10.txt";
+    std::ofstream file(test_file);
+    file << "output_format: pfm\n";
+    file.close();
+
+    EXPECT_EQ(render::config_parser::parse(test_file).output_format, render::image_format::pfm);
+    EXPECT_FALSE(render::render_config{}.output_format.has_value());
+
+    std::ofstream bad(test_file);
+    bad << "output_format: png\n";
+    bad.close();
+    EXPECT_THROW(render::config_parser::parse(test_file), std::runtime_error);
+
+    std::remove(test_file.c_str());
+}
+
+TEST(test_config_parser, stream_output_parameter) {
+    const std::string test_file = "test_config11.txt";
+    std::ofstream file(test_file);
+    file << "stream_output: true\n";
+    file.close();
+
+    EXPECT_TRUE(render::config_parser::parse(test_file).stream_output);
+    EXPECT_FALSE(render::render_config{}.stream_output);
+
+    std::ofstream bad(test_file);
+    bad << "stream_output: yes\n";
+    bad.close();
+    EXPECT_THROW(render::config_parser::parse(test_file), std::runtime_error);
+
+    std::remove(test_file.c_str());
+}
+
+TEST(test_config_parser, adaptive_sampling_parameters) {
+    const std::string test_file = "test_config12.txt";
+    std::ofstream file(test_file);
+    file << "adaptive_threshold: 0.05\n";
+    file << "adaptive_min_samples: 8\n";
+    file.close();
+
+    const auto config = render::config_parser::parse(test_file);
+    EXPECT_DOUBLE_EQ(config.adaptive_threshold, 0.05);
+    EXPECT_EQ(config.adaptive_min_samples, 8);
+    EXPECT_EQ(render::render_config{}.adaptive_threshold, 0.0);
+
+    std::ofstream bad(test_file);
+    bad << "adaptive_min_samples: 1\n";
+    bad.close();
+    EXPECT_THROW(render::config_parser::parse(test_file), std::runtime_error);
+
+    std::ofstream negative(test_file);
+    negative << "adaptive_threshold: -0.1\n";
+    negative.close();
+    EXPECT_THROW(render::config_parser::parse(test_file), std::runtime_error);
+
+    std::remove(test_file.c_str());
+}
+
+TEST(test_config_parser, sampler_parameter) {
+    const std::string test_file = "test_config13.txt";
+    std::ofstream file(test_file);
+    file << "sampler: sobol\n";
+    file.close();
+
+    EXPECT_EQ(render::config_parser::parse(test_file).sampler, render::sampler_type::sobol);
+    EXPECT_EQ(render::render_config{}.sampler, render::sampler_type::independent);
+
+    std::ofstream bad(test_file);
+    bad << "sampler: halton\n";
+    bad.close();
+    EXPECT_THROW(render::config_parser::parse(test_file), std::runtime_error);
+
+    std::remove(test_file.c_str());
+}
+
+TEST(test_config_parser, invalid_tile_size) {
+    const std::string test_file = "test_config_error2.txt";
+    std::ofstream file(test_file);
+    file << "tile_size: 0\n";
+    file.close();
+
+    EXPECT_THROW(render::config_parser::parse(test_file), std::runtime_error);
+
+    std::remove(test_file.c_str());
+}
+
+TEST(test_command_line, overrides_config) {
+    const char* argv[] = {"render", "config.txt", "--threads", "3", "scene.txt", "out.ppm", "--tile-size", "8"};
+    auto args = render::command_line_parser::parse(8, argv);
+    EXPECT_EQ(args.config_file, "config.txt");
+    EXPECT_EQ(args.scene_file, "scene.txt");
+    EXPECT_EQ(args.output_file, "out.ppm");
+
+    render::render_config config;
+    args.apply_overrides(config);
+    EXPECT_EQ(config.threads, 3);
+    EXPECT_EQ(config.tile_size, 8);
+    EXPECT_FALSE(args.sample_counts_file);
+
+    const char* with_counts[] = {"render", "config.txt", "scene.txt", "out.ppm", "--sample-counts", "counts.pgm"};
+    EXPECT_EQ(render::command_line_parser::parse(6, with_counts).sample_counts_file, "counts.pgm");
+}
+
+TEST(test_command_line, invalid_arguments) {
+    const char* missing[] = {"render", "config.txt", "scene.txt"};
+    EXPECT_THROW(render::command_line_parser::parse(3, missing), std::runtime_error);
+
+    const char* bad_value[] = {"render", "a", "b", "c", "--threads", "many"};
+    EXPECT_THROW(render::command_line_parser::parse(6, bad_value), std::runtime_error);
+}
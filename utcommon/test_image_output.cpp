@@ -0,0 +1,102 @@
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <optional>
+#include <string>
+
+#include "config.hpp"
+#include "image_output.hpp"
+#include "renderer_utils.hpp"
+#include "tile_renderer.hpp"
+#include "vector.hpp"
+
+namespace {
+
+    std::string read_file(const std::string& filename) {
+        std::ifstream file(filename, std::ios::binary);
+        return std::string{std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()};
+    }
+
+    render::vector color_at(int i, int j) {
+        return render::vector{i / 40.0, j / 30.0, (i + j) % 7 / 6.0};
+    }
+
+    // Stores every tile of a width x height gradient through output, with
+    // the workers of render_tiles.
+    void store_gradient(const render::render_config& config, render::image_output& output, int width, int height) {
+        render::render_tiles(config, width, height, [&](const render::tile& t) {
+            render::framebuffer pixels{t.x_end - t.x_begin, t.y_end - t.y_begin};
+            for (int j = t.y_begin; j < t.y_end; ++j) {
+                for (int i = t.x_begin; i < t.x_end; ++i) {
+                    pixels.set_pixel(i - t.x_begin, j - t.y_begin, color_at(i, j));
+                }
+            }
+            output.store_tile(t, pixels);
+        });
+    }
+
+}
+
+TEST(test_image_output, streamed_files_match_in_memory_ones) {
+    const int width = 37;
+    const int height = 29;
+    render::render_config config;
+    config.threads = 3;
+    config.tile_size = 8;
+
+    for (const std::string extension : {".ppm", ".pfm"}) {
+        const std::string memory_file = "test_image_output_memory" + extension;
+        const std::string streamed_file = "test_image_output_streamed" + extension;
+        // P3, the default for .ppm files, is never streamed.
+        config.output_format = extension == ".ppm" ? std::optional{render::image_format::p6} : std::nullopt;
+
+        config.stream_output = false;
+        render::image_output in_memory{config, memory_file, width, height};
+        store_gradient(config, in_memory, width, height);
+        in_memory.finish();
+
+        config.stream_output = true;
+        render::image_output streamed{config, streamed_file, width, height};
+        store_gradient(config, streamed, width, height);
+        streamed.finish();
+
+        const std::string expected = read_file(memory_file);
+        EXPECT_FALSE(expected.empty());
+        EXPECT_EQ(read_file(streamed_file), expected) << extension;
+
+        std::remove(memory_file.c_str());
+        std::remove(streamed_file.c_str());
+    }
+}
+
+TEST(test_image_output, stored_tiles_are_in_the_file_before_finish) {
+    const std::string test_file = "test_image_output_partial.ppm";
+    render::render_config config;
+    config.stream_output = true;
+    config.output_format = render::image_format::p6;
+    config.tile_size = 4;
+
+    render::image_output output{config, test_file, 8, 8};
+    const std::string header = render::image_header(render::image_format::p6, 8, 8);
+    std::string contents = read_file(test_file);
+    ASSERT_EQ(contents.size(), header.size() + 8 * 8 * 3);
+    EXPECT_EQ(contents.substr(0, header.size()), header);
+
+    // The bottom-left tile lands in the last rows of the file.
+    render::framebuffer white{4, 4};
+    for (int j = 0; j < 4; ++j) {
+        for (int i = 0; i < 4; ++i) {
+            white.set_pixel(i, j, render::vector{1.0, 1.0, 1.0});
+        }
+    }
+    output.store_tile(render::tile{0, 0, 4, 0, 4}, white);
+
+    contents = read_file(test_file);
+    EXPECT_EQ(contents.substr(header.size() + 7 * 8 * 3, 12), std::string(12, '\xff'));
+    EXPECT_EQ(contents.substr(header.size() + 7 * 8 * 3 + 12, 12), std::string(12, '\0'));
+    EXPECT_EQ(contents.substr(header.size(), 12), std::string(12, '\0'));
+
+    output.finish();
+    std::remove(test_file.c_str());
+}
@@ -0,0 +1,526 @@
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <vector>
+
+#include "aligned_allocator.hpp"
+#include "cylinder.hpp"
+#include "intersection_kernels.hpp"
+#include "kernel_dispatch.hpp"
+#include "material.hpp"
+#include "ray.hpp"
+#include "sphere.hpp"
+
+namespace {
+
+    struct padded_spheres {
+        render::aligned_vector<double> x;
+        render::aligned_vector<double> y;
+        render::aligned_vector<double> z;
+        render::aligned_vector<double> radius;
+
+        void add(double cx, double cy, double cz, double r) {
+            x.push_back(cx);
+            y.push_back(cy);
+            z.push_back(cz);
+            radius.push_back(r);
+        }
+
+        void pad() {
+            const double nan = std::numeric_limits<double>::quiet_NaN();
+            while (x.size() % render::kernel_lane_padding != 0) {
+                add(nan, nan, nan, 0.0);
+            }
+        }
+
+        [[nodiscard]] render::sphere_lanes lanes() const {
+            return render::sphere_lanes{x.data(), y.data(), z.data(), radius.data(), x.size()};
+        }
+    };
+
+    struct padded_cylinders {
+        std::vector<render::aligned_vector<double>> columns = std::vector<render::aligned_vector<double>>(14);
+
+        void add(const render::cylinder_frame& f) {
+            const double values[] = {
+                f.center.get_x(), f.center.get_y(), f.center.get_z(),
+                f.unit_axis.get_x(), f.unit_axis.get_y(), f.unit_axis.get_z(),
+                f.top_center.get_x(), f.top_center.get_y(), f.top_center.get_z(),
+                f.bottom_center.get_x(), f.bottom_center.get_y(), f.bottom_center.get_z(),
+                f.half_height, f.radius_squared
+            };
+            for (size_t i = 0; i < columns.size(); ++i) {
+                columns[i].push_back(values[i]);
+            }
+        }
+
+        void pad() {
+            while (columns[0].size() % render::kernel_lane_padding != 0) {
+                for (auto& column : columns) {
+                    column.push_back(std::numeric_limits<double>::quiet_NaN());
+                }
+            }
+        }
+
+        [[nodiscard]] render::cylinder_lanes lanes() const {
+            return render::cylinder_lanes{
+                columns[0].data(), columns[1].data(), columns[2].data(),
+                columns[3].data(), columns[4].data(), columns[5].data(),
+                columns[6].data(), columns[7].data(), columns[8].data(),
+                columns[9].data(), columns[10].data(), columns[11].data(),
+                columns[12].data(), columns[13].data(), columns[0].size()
+            };
+        }
+    };
+
+    // The given columns interleaved block by block, as AoSoA storage keeps them.
+    render::aligned_vector<double> interleave(const std::vector<const render::aligned_vector<double>*>& columns) {
+        const size_t count = columns[0]->size();
+        render::aligned_vector<double> blocks(count * columns.size());
+        for (size_t i = 0; i < count; ++i) {
+            for (size_t c = 0; c < columns.size(); ++c) {
+                const size_t block = i / render::kernel_lane_padding;
+                blocks[(block * columns.size() + c) * render::kernel_lane_padding + i % render::kernel_lane_padding] = (*columns[c])[i];
+            }
+        }
+        return blocks;
+    }
+
+}
+
+TEST(test_aligned_allocator, cache_line_aligned) {
+    for (size_t n = 1; n < 40; n += 7) {
+        render::aligned_vector<double> values(n);
+        EXPECT_EQ(reinterpret_cast<std::uintptr_t>(values.data()) % render::cache_line_size, 0U);
+    }
+}
+
+TEST(test_intersection_kernels, spheres_match_scalar_and_sphere_intersect) {
+    const render::material_id mat = 0;
+    std::mt19937 rng(17);
+    std::uniform_real_distribution<double> coord(-10.0, 10.0);
+    std::uniform_real_distribution<double> size(0.2, 1.5);
+
+    padded_spheres arrays;
+    std::vector<render::sphere> spheres;
+    for (int i = 0; i < 61; ++i) {
+        const render::vector center{coord(rng), coord(rng), coord(rng)};
+        const double radius = size(rng);
+        arrays.add(center.get_x(), center.get_y(), center.get_z(), radius);
+        spheres.emplace_back(center, radius, mat);
+    }
+    arrays.pad();
+
+    int hits = 0;
+    for (int i = 0; i < 2000; ++i) {
+        const render::ray r{render::vector{coord(rng), coord(rng), coord(rng)},
+                            render::vector{coord(rng), coord(rng), coord(rng)}.normalize()};
+
+        double expected_t = std::numeric_limits<double>::max();
+        std::int64_t expected_index = -1;
+        for (size_t s = 0; s < spheres.size(); ++s) {
+            const auto hit = spheres[s].intersect(r);
+            if (hit && hit->t < expected_t) {
+                expected_t = hit->t;
+                expected_index = static_cast<std::int64_t>(s);
+            }
+        }
+
+        const auto simd = render::closest_sphere_hit(arrays.lanes(), r, 0.0001, std::numeric_limits<double>::max());
+        const auto scalar = render::closest_sphere_hit_scalar(arrays.lanes(), r, 0.0001, std::numeric_limits<double>::max());
+        ASSERT_EQ(simd.has_value(), expected_index >= 0);
+        ASSERT_EQ(scalar.has_value(), expected_index >= 0);
+        if (simd) {
+            ++hits;
+            EXPECT_EQ(simd->index, expected_index);
+            EXPECT_EQ(scalar->index, expected_index);
+            EXPECT_DOUBLE_EQ(simd->t, expected_t);
+            EXPECT_EQ(simd->t, scalar->t);
+        }
+    }
+    EXPECT_GT(hits, 100);
+}
+
+TEST(test_intersection_kernels, spheres_respect_t_max_and_ties) {
+    padded_spheres arrays;
+    for (int i = 0; i < 12; ++i) {
+        arrays.add(0.0, 0.0, -5.0, 1.0);
+    }
+    arrays.add(0.0, 0.0, -2.0, 0.5);
+    arrays.pad();
+
+    const render::ray r{render::vector{0.0, 0.0, 0.0}, render::vector{0.0, 0.0, -1.0}};
+    const auto nearest = render::closest_sphere_hit(arrays.lanes(), r, 0.0001, 100.0);
+    ASSERT_TRUE(nearest.has_value());
+    EXPECT_EQ(nearest->index, 12U);
+    EXPECT_DOUBLE_EQ(nearest->t, 1.5);
+
+    const auto bounded = render::closest_sphere_hit(arrays.lanes(), r, 0.0001, 1.0);
+    EXPECT_FALSE(bounded.has_value());
+
+    arrays.radius[12] = 0.0;
+    arrays.z[12] = 100.0;
+    const auto tie = render::closest_sphere_hit(arrays.lanes(), r, 0.0001, 100.0);
+    ASSERT_TRUE(tie.has_value());
+    EXPECT_EQ(tie->index, 0U);
+    EXPECT_DOUBLE_EQ(tie->t, 4.0);
+}
+
+TEST(test_intersection_kernels, cylinder_frame_precomputes_constants) {
+    const auto frame = render::cylinder_frame::make(render::vector{1.0, 2.0, 3.0}, 0.5, render::vector{0.0, 4.0, 0.0});
+
+    EXPECT_DOUBLE_EQ(frame.half_height, 2.0);
+    EXPECT_DOUBLE_EQ(frame.radius_squared, 0.25);
+    EXPECT_DOUBLE_EQ(frame.unit_axis.get_y(), 1.0);
+    EXPECT_DOUBLE_EQ(frame.top_center.get_y(), 4.0);
+    EXPECT_DOUBLE_EQ(frame.bottom_center.get_y(), 0.0);
+}
+
+TEST(test_intersection_kernels, cylinders_match_scalar_and_cylinder_intersect) {
+    const render::material_id mat = 0;
+    std::mt19937 rng(23);
+    std::uniform_real_distribution<double> coord(-10.0, 10.0);
+    std::uniform_real_distribution<double> size(0.2, 1.5);
+
+    padded_cylinders arrays;
+    std::vector<render::cylinder> cylinders;
+    for (int i = 0; i < 45; ++i) {
+        const render::vector center{coord(rng), coord(rng), coord(rng)};
+        const double radius = size(rng);
+        const render::vector axis = render::vector{coord(rng), coord(rng), coord(rng)} * 0.3;
+        cylinders.emplace_back(center, radius, axis, mat);
+        arrays.add(cylinders.back().get_frame());
+    }
+    arrays.pad();
+
+    int hits = 0;
+    for (int i = 0; i < 3000; ++i) {
+        // Every fourth ray runs along a coordinate axis to exercise the parallel cases.
+        render::vector direction{coord(rng), coord(rng), coord(rng)};
+        if (i % 4 == 0) {
+            direction = render::vector{0.0, 1.0, 0.0};
+        }
+        const render::ray r{render::vector{coord(rng), coord(rng), coord(rng)}, direction.normalize()};
+
+        double expected_t = std::numeric_limits<double>::max();
+        std::int64_t expected_index = -1;
+        for (size_t c = 0; c < cylinders.size(); ++c) {
+            const auto hit = cylinders[c].intersect(r);
+            if (hit && hit->t < expected_t) {
+                expected_t = hit->t;
+                expected_index = static_cast<std::int64_t>(c);
+            }
+        }
+
+        const auto simd = render::closest_cylinder_hit(arrays.lanes(), r, 0.0001, std::numeric_limits<double>::max());
+        const auto scalar = render::closest_cylinder_hit_scalar(arrays.lanes(), r, 0.0001, std::numeric_limits<double>::max());
+        ASSERT_EQ(simd.has_value(), expected_index >= 0);
+        ASSERT_EQ(scalar.has_value(), expected_index >= 0);
+        if (simd) {
+            ++hits;
+            EXPECT_EQ(simd->index, expected_index);
+            EXPECT_EQ(scalar->index, expected_index);
+            EXPECT_EQ(simd->t, expected_t);
+            EXPECT_EQ(scalar->t, expected_t);
+        }
+    }
+    EXPECT_GT(hits, 100);
+}
+
+TEST(test_intersection_kernels, cylinder_caps_and_sides) {
+    padded_cylinders arrays;
+    arrays.add(render::cylinder_frame::make(render::vector{0.0, 0.0, -5.0}, 1.0, render::vector{0.0, 0.0, 2.0}));
+    arrays.add(render::cylinder_frame::make(render::vector{3.0, 0.0, -5.0}, 1.0, render::vector{0.0, 2.0, 0.0}));
+    arrays.pad();
+
+    const render::ray along_axis{render::vector{0.0, 0.0, 0.0}, render::vector{0.0, 0.0, -1.0}};
+    const auto cap = render::closest_cylinder_hit(arrays.lanes(), along_axis, 0.0001, 100.0);
+    ASSERT_TRUE(cap.has_value());
+    EXPECT_EQ(cap->index, 0U);
+    EXPECT_DOUBLE_EQ(cap->t, 4.0);
+
+    const render::ray from_side{render::vector{3.0, 0.0, 0.0}, render::vector{0.0, 0.0, -1.0}};
+    const auto side = render::closest_cylinder_hit(arrays.lanes(), from_side, 0.0001, 100.0);
+    ASSERT_TRUE(side.has_value());
+    EXPECT_EQ(side->index, 1U);
+    EXPECT_DOUBLE_EQ(side->t, 4.0);
+
+    EXPECT_FALSE(render::closest_cylinder_hit(arrays.lanes(), from_side, 0.0001, 3.0).has_value());
+}
+
+TEST(test_intersection_kernels, packets_match_single_rays) {
+    std::mt19937 rng(29);
+    std::uniform_real_distribution<double> coord(-10.0, 10.0);
+    std::uniform_real_distribution<double> size(0.2, 1.5);
+
+    padded_spheres spheres;
+    for (int i = 0; i < 37; ++i) {
+        spheres.add(coord(rng), coord(rng), coord(rng), size(rng));
+    }
+    spheres.pad();
+    padded_cylinders cylinders;
+    for (int i = 0; i < 29; ++i) {
+        const render::vector axis = render::vector{coord(rng), coord(rng), coord(rng)} * 0.3;
+        cylinders.add(render::cylinder_frame::make(render::vector{coord(rng), coord(rng), coord(rng)}, size(rng), axis));
+    }
+    cylinders.pad();
+    const auto first_cylinder = static_cast<std::uint32_t>(spheres.x.size());
+
+    int hits = 0;
+    for (int p = 0; p < 200; ++p) {
+        // Coherent packets share an origin like camera rays; odd ones are short.
+        render::ray_packet packet;
+        packet.count = (p % 2 == 0) ? render::ray_packet::capacity : 11;
+        const render::vector origin{coord(rng), coord(rng), coord(rng)};
+        const render::vector towards{coord(rng), coord(rng), coord(rng)};
+        for (size_t k = 0; k < packet.count; ++k) {
+            const render::vector d = (towards + render::vector{coord(rng), coord(rng), coord(rng)} * 0.1 - origin).normalize();
+            packet.origin_x[k] = origin.get_x();
+            packet.origin_y[k] = origin.get_y();
+            packet.origin_z[k] = origin.get_z();
+            packet.direction_x[k] = d.get_x();
+            packet.direction_y[k] = d.get_y();
+            packet.direction_z[k] = d.get_z();
+        }
+
+        render::packet_hits found;
+        found.reset(packet.count, std::numeric_limits<double>::max());
+        render::intersect_packet_spheres(spheres.lanes(), 0, spheres.x.size(), 0, packet, 0.0001, found);
+        render::intersect_packet_cylinders(cylinders.lanes(), 0, cylinders.columns[0].size(), first_cylinder, packet, 0.0001, found);
+
+        for (size_t k = 0; k < packet.count; ++k) {
+            const render::ray r = packet.get_ray(k);
+            double expected_t = std::numeric_limits<double>::max();
+            double expected_primitive = -1.0;
+            if (const auto s = render::closest_sphere_hit(spheres.lanes(), r, 0.0001, expected_t)) {
+                expected_t = s->t;
+                expected_primitive = s->index;
+            }
+            if (const auto c = render::closest_cylinder_hit(cylinders.lanes(), r, 0.0001, expected_t)) {
+                expected_t = c->t;
+                expected_primitive = first_cylinder + c->index;
+            }
+            EXPECT_EQ(found.t[k], expected_t);
+            EXPECT_EQ(found.primitive[k], expected_primitive);
+            hits += expected_primitive >= 0.0 ? 1 : 0;
+        }
+        for (size_t k = packet.count; k < render::ray_packet::capacity; ++k) {
+            EXPECT_EQ(found.primitive[k], -1.0);
+        }
+    }
+    EXPECT_GT(hits, 200);
+}
+
+TEST(test_intersection_kernels, every_isa_finds_identical_hits) {
+    std::mt19937 rng(37);
+    std::uniform_real_distribution<double> coord(-10.0, 10.0);
+    std::uniform_real_distribution<double> size(0.2, 1.5);
+
+    padded_spheres spheres;
+    for (int i = 0; i < 45; ++i) {
+        spheres.add(coord(rng), coord(rng), coord(rng), size(rng));
+    }
+    spheres.pad();
+    padded_cylinders cylinders;
+    for (int i = 0; i < 21; ++i) {
+        const render::vector axis = render::vector{coord(rng), coord(rng), coord(rng)} * 0.3;
+        cylinders.add(render::cylinder_frame::make(render::vector{coord(rng), coord(rng), coord(rng)}, size(rng), axis));
+    }
+    cylinders.pad();
+
+    render::ray_packet packet;
+    packet.count = 13;
+    for (size_t k = 0; k < packet.count; ++k) {
+        const render::vector d = render::vector{coord(rng), coord(rng), coord(rng)}.normalize();
+        packet.origin_x[k] = coord(rng);
+        packet.origin_y[k] = coord(rng);
+        packet.origin_z[k] = coord(rng);
+        packet.direction_x[k] = d.get_x();
+        packet.direction_y[k] = d.get_y();
+        packet.direction_z[k] = d.get_z();
+    }
+
+    // Every closest distance and index, single-ray and packet, as one list.
+    const auto trace_all = [&] {
+        std::vector<double> results;
+        for (size_t k = 0; k < packet.count; ++k) {
+            const render::ray r = packet.get_ray(k);
+            const auto s = render::closest_sphere_hit(spheres.lanes(), r, 0.0001, std::numeric_limits<double>::max());
+            const auto c = render::closest_cylinder_hit(cylinders.lanes(), r, 0.0001, std::numeric_limits<double>::max());
+            results.insert(results.end(), {s ? s->t : -1.0, s ? s->index : -1.0, c ? c->t : -1.0, c ? c->index : -1.0});
+        }
+        render::packet_hits found;
+        found.reset(packet.count, std::numeric_limits<double>::max());
+        render::intersect_packet_spheres(spheres.lanes(), 0, spheres.x.size(), 0, packet, 0.0001, found);
+        render::intersect_packet_cylinders(cylinders.lanes(), 0, cylinders.columns[0].size(), 64, packet, 0.0001, found);
+        results.insert(results.end(), found.t, found.t + packet.count);
+        results.insert(results.end(), found.primitive, found.primitive + packet.count);
+        return results;
+    };
+
+    render::select_kernel_isa(render::cpu_isa::scalar);
+    const std::vector<double> expected = trace_all();
+    for (const render::cpu_isa isa : render::supported_isas()) {
+        render::select_kernel_isa(isa);
+        EXPECT_EQ(trace_all(), expected) << render::isa_name(isa);
+    }
+    render::select_kernel_isa(std::nullopt);
+}
+
+TEST(test_intersection_kernels, blocked_columns_find_identical_hits) {
+    std::mt19937 rng(41);
+    std::uniform_real_distribution<double> coord(-10.0, 10.0);
+    std::uniform_real_distribution<double> size(0.2, 1.5);
+
+    padded_spheres spheres;
+    for (int i = 0; i < 29; ++i) {
+        spheres.add(coord(rng), coord(rng), coord(rng), size(rng));
+    }
+    spheres.pad();
+    padded_cylinders cylinders;
+    for (int i = 0; i < 19; ++i) {
+        const render::vector axis = render::vector{coord(rng), coord(rng), coord(rng)} * 0.3;
+        cylinders.add(render::cylinder_frame::make(render::vector{coord(rng), coord(rng), coord(rng)}, size(rng), axis));
+    }
+    cylinders.pad();
+
+    const auto sphere_blocks = interleave({&spheres.x, &spheres.y, &spheres.z, &spheres.radius});
+    const double* s = sphere_blocks.data();
+    const size_t lane = render::kernel_lane_padding;
+    const render::sphere_lanes blocked_spheres{s, s + lane, s + 2 * lane, s + 3 * lane, spheres.x.size(), 4 * lane};
+    std::vector<const render::aligned_vector<double>*> cylinder_columns;
+    for (const auto& column : cylinders.columns) {
+        cylinder_columns.push_back(&column);
+    }
+    const auto cylinder_blocks = interleave(cylinder_columns);
+    const double* c = cylinder_blocks.data();
+    const render::cylinder_lanes blocked_cylinders{
+        c, c + lane, c + 2 * lane, c + 3 * lane, c + 4 * lane, c + 5 * lane, c + 6 * lane,
+        c + 7 * lane, c + 8 * lane, c + 9 * lane, c + 10 * lane, c + 11 * lane, c + 12 * lane, c + 13 * lane,
+        cylinders.columns[0].size(), 14 * lane
+    };
+
+    render::ray_packet packet;
+    packet.count = 11;
+    for (size_t k = 0; k < packet.count; ++k) {
+        const render::vector d = render::vector{coord(rng), coord(rng), coord(rng)}.normalize();
+        packet.origin_x[k] = coord(rng);
+        packet.origin_y[k] = coord(rng);
+        packet.origin_z[k] = coord(rng);
+        packet.direction_x[k] = d.get_x();
+        packet.direction_y[k] = d.get_y();
+        packet.direction_z[k] = d.get_z();
+    }
+
+    const auto trace_all = [&](const render::sphere_lanes& sl, const render::cylinder_lanes& cl) {
+        std::vector<double> results;
+        for (size_t k = 0; k < packet.count; ++k) {
+            const render::ray r = packet.get_ray(k);
+            const auto sh = render::closest_sphere_hit(sl, r, 0.0001, std::numeric_limits<double>::max());
+            const auto ch = render::closest_cylinder_hit(cl, r, 0.0001, std::numeric_limits<double>::max());
+            const auto sd = render::sphere_hit_distance(sl, 27, r, 0.0001, std::numeric_limits<double>::max());
+            const auto cd = render::cylinder_hit_distance(cl, 17, r, 0.0001, std::numeric_limits<double>::max());
+            results.insert(results.end(), {sh ? sh->t : -1.0, sh ? sh->index : -1.0, ch ? ch->t : -1.0, ch ? ch->index : -1.0,
+                                           sd.value_or(-1.0), cd.value_or(-1.0)});
+        }
+        render::packet_hits found;
+        found.reset(packet.count, std::numeric_limits<double>::max());
+        render::intersect_packet_spheres(sl, 0, sl.count, 0, packet, 0.0001, found);
+        render::intersect_packet_cylinders(cl, 3, cl.count, 64, packet, 0.0001, found);
+        results.insert(results.end(), found.t, found.t + packet.count);
+        results.insert(results.end(), found.primitive, found.primitive + packet.count);
+        return results;
+    };
+
+    for (const render::cpu_isa isa : render::supported_isas()) {
+        render::select_kernel_isa(isa);
+        EXPECT_EQ(trace_all(blocked_spheres, blocked_cylinders), trace_all(spheres.lanes(), cylinders.lanes())) << render::isa_name(isa);
+    }
+    render::select_kernel_isa(std::nullopt);
+}
+
+TEST(test_intersection_kernels, packet_primitive_range) {
+    padded_spheres spheres;
+    spheres.add(0.0, 0.0, -2.0, 0.5);
+    spheres.add(0.0, 0.0, -5.0, 1.0);
+    spheres.pad();
+
+    render::ray_packet packet;
+    packet.count = 1;
+    packet.direction_z[0] = -1.0;
+
+    render::packet_hits hits;
+    hits.reset(packet.count, 100.0);
+    render::intersect_packet_spheres(spheres.lanes(), 1, 2, 40, packet, 0.0001, hits);
+    EXPECT_EQ(hits.primitive[0], 41.0);
+    EXPECT_DOUBLE_EQ(hits.t[0], 4.0);
+
+    render::intersect_packet_spheres(spheres.lanes(), 0, 1, 40, packet, 0.0001, hits);
+    EXPECT_EQ(hits.primitive[0], 40.0);
+    EXPECT_DOUBLE_EQ(hits.t[0], 1.5);
+}
+
+TEST(test_intersection_kernels, deferred_attributes_match_intersect) {
+    std::mt19937 rng(31);
+    std::uniform_real_distribution<double> coord(-10.0, 10.0);
+    std::uniform_real_distribution<double> size(0.2, 1.5);
+
+    padded_spheres sphere_arrays;
+    padded_cylinders cylinder_arrays;
+    std::vector<render::sphere> spheres;
+    std::vector<render::cylinder> cylinders;
+    for (render::material_id i = 0; i < 20; ++i) {
+        spheres.emplace_back(render::vector{coord(rng), coord(rng), coord(rng)}, size(rng), i);
+        sphere_arrays.add(spheres.back().get_center().get_x(), spheres.back().get_center().get_y(),
+                          spheres.back().get_center().get_z(), spheres.back().get_radius());
+        cylinders.emplace_back(render::vector{coord(rng), coord(rng), coord(rng)}, size(rng),
+                               render::vector{coord(rng), coord(rng), coord(rng)} * 0.3, i);
+        cylinder_arrays.add(cylinders.back().get_frame());
+    }
+    sphere_arrays.pad();
+    cylinder_arrays.pad();
+
+    const auto expect_same = [](const render::hit_info& a, const render::hit_info& b) {
+        EXPECT_EQ(a.t, b.t);
+        EXPECT_EQ(a.normal.get_x(), b.normal.get_x());
+        EXPECT_EQ(a.normal.get_y(), b.normal.get_y());
+        EXPECT_EQ(a.normal.get_z(), b.normal.get_z());
+        EXPECT_EQ(a.mat, b.mat);
+    };
+
+    int hits = 0;
+    for (int i = 0; i < 2000; ++i) {
+        // Every third ray runs along the cylinder axes to hit caps head on.
+        render::vector direction{coord(rng), coord(rng), coord(rng)};
+        const size_t target = static_cast<size_t>(i) % cylinders.size();
+        if (i % 3 == 0) {
+            direction = cylinders[target].get_frame().unit_axis;
+        }
+        const render::vector origin = (i % 3 == 0) ? cylinders[target].get_center() - direction * 5.0
+                                                   : render::vector{coord(rng), coord(rng), coord(rng)};
+        const render::ray r{origin, direction.normalize()};
+
+        for (size_t k = 0; k < spheres.size(); ++k) {
+            const auto full = spheres[k].intersect(r);
+            const auto t = spheres[k].hit_distance(r, 0.0001, std::numeric_limits<double>::max());
+            ASSERT_EQ(full.has_value(), t.has_value());
+            ASSERT_EQ(render::sphere_hit_distance(sphere_arrays.lanes(), k, r, 0.0001, std::numeric_limits<double>::max()), t);
+            if (t) {
+                expect_same(spheres[k].surface_at(r, *t), *full);
+            }
+        }
+        for (size_t k = 0; k < cylinders.size(); ++k) {
+            const auto full = cylinders[k].intersect(r);
+            const auto t = cylinders[k].hit_distance(r, 0.0001, std::numeric_limits<double>::max());
+            ASSERT_EQ(full.has_value(), t.has_value());
+            ASSERT_EQ(render::cylinder_hit_distance(cylinder_arrays.lanes(), k, r, 0.0001, std::numeric_limits<double>::max()), t);
+            if (t) {
+                ++hits;
+                expect_same(cylinders[k].surface_at(r, *t), *full);
+                EXPECT_FALSE(cylinders[k].hit_distance(r, 0.0001, *t).has_value());
+            }
+        }
+    }
+    EXPECT_GT(hits, 500);
+}
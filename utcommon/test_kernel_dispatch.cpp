@@ -0,0 +1,72 @@
+#include <gtest/gtest.h>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "kernel_dispatch.hpp"
+#include "renderer_utils.hpp"
+#include "simd_random.hpp"
+
+TEST(test_kernel_dispatch, isa_names_round_trip) {
+    for (const render::cpu_isa isa : {render::cpu_isa::scalar, render::cpu_isa::avx2, render::cpu_isa::avx512}) {
+        EXPECT_EQ(render::parse_isa(render::isa_name(isa)), isa);
+    }
+    EXPECT_FALSE(render::parse_isa("auto").has_value());
+    EXPECT_FALSE(render::parse_isa("AVX2").has_value());
+}
+
+TEST(test_kernel_dispatch, detects_best_supported_isa) {
+    const auto isas = render::supported_isas();
+    ASSERT_FALSE(isas.empty());
+    EXPECT_EQ(isas.front(), render::cpu_isa::scalar);
+    EXPECT_EQ(render::detect_cpu_isa(), isas.back());
+
+    render::select_kernel_isa(render::cpu_isa::scalar);
+    EXPECT_EQ(render::active_kernel_isa(), render::cpu_isa::scalar);
+    render::select_kernel_isa(std::nullopt);
+    EXPECT_EQ(render::active_kernel_isa(), render::detect_cpu_isa());
+}
+
+TEST(test_kernel_dispatch, random_fill_is_identical_on_every_isa) {
+    const auto generate = [] {
+        render::xoshiro256x4 gen;
+        gen.reseed(5U, 3U);
+        std::vector<std::uint64_t> out(103);
+        gen.fill(out.data(), 7);
+        gen.fill(out.data() + 7, out.size() - 7);
+        return out;
+    };
+
+    render::select_kernel_isa(render::cpu_isa::scalar);
+    const auto expected = generate();
+    for (const render::cpu_isa isa : render::supported_isas()) {
+        render::select_kernel_isa(isa);
+        EXPECT_EQ(generate(), expected) << render::isa_name(isa);
+    }
+    render::select_kernel_isa(std::nullopt);
+}
+
+TEST(test_kernel_dispatch, gamma_encoding_matches_pow_on_every_isa) {
+    std::vector<float> components;
+    for (int i = 0; i < 1100; ++i) {
+        const float c = static_cast<float>(i) / 1024.0F;
+        components.insert(components.end(), {std::nextafter(c, -1.0F), c, std::nextafter(c, 2.0F)});
+    }
+    components.insert(components.end(), {-0.0F, -0.5F, 1e30F, std::numeric_limits<float>::infinity(), std::numeric_limits<float>::quiet_NaN()});
+
+    for (const double gamma : {2.2, 1.0, -1.0}) {
+        const render::gamma_encoder encoder{gamma};
+        for (const render::cpu_isa isa : render::supported_isas()) {
+            render::select_kernel_isa(isa);
+            std::vector<std::uint8_t> levels(components.size());
+            encoder.encode(components.data(), levels.data(), components.size());
+            for (size_t i = 0; i < components.size(); ++i) {
+                const double c = components[i] < 0.0F ? 0.0 : components[i];
+                const render::vector encoded = render::clamp_color(render::gamma_correct(render::vector{c, c, c}, gamma));
+                EXPECT_EQ(levels[i], render::color_to_int(encoded.get_x())) << render::isa_name(isa) << " " << gamma << " " << components[i];
+            }
+        }
+    }
+    render::select_kernel_isa(std::nullopt);
+}
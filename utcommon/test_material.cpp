@@ -28,3 +28,25 @@ TEST(test_material, refractive_material) {
     EXPECT_DOUBLE_EQ(mat.get_refraction_index(), 1.5);
 }
 
+
+TEST(test_material_table, interns_parameters_by_type) {
+    render::material_table table;
+    const auto matte = table.add(render::matte_material{"matte", 0.5, 0.6, 0.7});
+    const auto glass = table.add(render::refractive_material{"glass", 1.5});
+    const auto metal = table.add(render::metal_material{"metal", 0.8, 0.9, 1.0, 0.3});
+
+    ASSERT_EQ(table.size(), 3U);
+    EXPECT_EQ(matte, 0U);
+    EXPECT_EQ(glass, 1U);
+    EXPECT_EQ(metal, 2U);
+    EXPECT_EQ(table.get_type(matte), render::material_type::matte);
+    EXPECT_EQ(table.get_type(glass), render::material_type::refractive);
+    EXPECT_EQ(table.get_type(metal), render::material_type::metal);
+
+    EXPECT_DOUBLE_EQ(table.get_matte(matte).reflectance.get_y(), 0.6);
+    EXPECT_DOUBLE_EQ(table.get_metal(metal).reflectance.get_x(), 0.8);
+    EXPECT_DOUBLE_EQ(table.get_metal(metal).diffusion, 0.3);
+    EXPECT_DOUBLE_EQ(table.get_refractive(glass).refraction_index, 1.5);
+    EXPECT_DOUBLE_EQ(table.get_refractive(glass).inverse_index, 1.0 / 1.5);
+    EXPECT_DOUBLE_EQ(table.get_refractive(glass).r0, 0.04);
+}
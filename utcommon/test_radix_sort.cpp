@@ -0,0 +1,118 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cstdint>
+#include <numeric>
+#include <random>
+#include <vector>
+
+#include "morton.hpp"
+#include "radix_sort.hpp"
+#include "thread_pool.hpp"
+
+namespace {
+
+    std::uint64_t interleave(std::uint64_t x, std::uint64_t y, std::uint64_t z, int bits) {
+        std::uint64_t code = 0;
+        for (int b = bits - 1; b >= 0; --b) {
+            code = (code << 3) | (((x >> b) & 1U) << 2) | (((y >> b) & 1U) << 1) | ((z >> b) & 1U);
+        }
+        return code;
+    }
+
+    template <typename Key>
+    void expect_sorts_like_stable_sort(std::vector<Key> keys, int threads) {
+        std::vector<std::uint32_t> values(keys.size());
+        std::iota(values.begin(), values.end(), 0U);
+
+        std::vector<std::uint32_t> expected = values;
+        std::stable_sort(expected.begin(), expected.end(), [&](std::uint32_t a, std::uint32_t b) { return keys[a] < keys[b]; });
+
+        render::thread_pool pool{threads};
+        render::radix_sort(keys, values, pool);
+
+        EXPECT_TRUE(std::is_sorted(keys.begin(), keys.end()));
+        EXPECT_EQ(values, expected);
+    }
+
+}
+
+TEST(test_morton, matches_bit_interleave) {
+    std::mt19937 rng(3);
+    std::uniform_int_distribution<std::uint32_t> small(0, 1023);
+    std::uniform_int_distribution<std::uint64_t> large(0, (1U << 21) - 1);
+
+    for (int i = 0; i < 1000; ++i) {
+        const std::uint32_t x = small(rng), y = small(rng), z = small(rng);
+        EXPECT_EQ(render::morton_encode_30(x, y, z), interleave(x, y, z, 10));
+
+        const std::uint64_t u = large(rng), v = large(rng), w = large(rng);
+        EXPECT_EQ(render::morton_encode_63(u, v, w), interleave(u, v, w, 21));
+    }
+}
+
+TEST(test_morton, quantize_clamps_to_grid) {
+    render::aabb bounds;
+    bounds.expand(std::array<double, 3>{0.0, 0.0, 0.0});
+    bounds.expand(std::array<double, 3>{2.0, 4.0, 0.0});
+
+    const auto low = render::quantize({0.0, 0.0, 0.0}, bounds, 10);
+    const auto high = render::quantize({2.0, 4.0, 0.0}, bounds, 10);
+    const auto mid = render::quantize({1.0, 2.0, 0.0}, bounds, 10);
+
+    EXPECT_EQ(low, (std::array<std::uint64_t, 3>{0, 0, 0}));
+    EXPECT_EQ(high, (std::array<std::uint64_t, 3>{1023, 1023, 0}));
+    EXPECT_EQ(mid, (std::array<std::uint64_t, 3>{512, 512, 0}));
+}
+
+TEST(test_morton, hilbert_steps_between_face_neighbours) {
+    constexpr int bits = 3;
+    constexpr std::uint64_t side = 1U << bits;
+    std::vector<std::array<std::uint64_t, 3>> cells(side * side * side);
+    for (std::uint64_t x = 0; x < side; ++x) {
+        for (std::uint64_t y = 0; y < side; ++y) {
+            for (std::uint64_t z = 0; z < side; ++z) {
+                const std::uint64_t index = render::hilbert_encode(x, y, z, bits);
+                ASSERT_LT(index, cells.size());
+                cells[index] = {x, y, z};
+            }
+        }
+    }
+
+    // Every index is used once and each step moves to an adjacent cell.
+    EXPECT_EQ(cells[0], (std::array<std::uint64_t, 3>{0, 0, 0}));
+    for (size_t i = 1; i < cells.size(); ++i) {
+        std::uint64_t distance = 0;
+        for (size_t axis = 0; axis < 3; ++axis) {
+            distance += cells[i][axis] > cells[i - 1][axis] ? cells[i][axis] - cells[i - 1][axis] : cells[i - 1][axis] - cells[i][axis];
+        }
+        EXPECT_EQ(distance, 1U) << "step " << i;
+    }
+}
+
+TEST(test_radix_sort, sorts_32_bit_keys_stably) {
+    std::mt19937 rng(1);
+    std::uniform_int_distribution<std::uint32_t> key(0, 5000);
+    std::vector<std::uint32_t> keys(20000);
+    for (auto& k : keys) {
+        k = key(rng);
+    }
+
+    expect_sorts_like_stable_sort(keys, 1);
+    expect_sorts_like_stable_sort(keys, 4);
+}
+
+TEST(test_radix_sort, sorts_64_bit_keys_stably) {
+    std::mt19937_64 rng(2);
+    std::vector<std::uint64_t> keys(20000);
+    for (size_t i = 0; i < keys.size(); ++i) {
+        keys[i] = rng() >> (i % 2 == 0 ? 1 : 40);
+    }
+
+    expect_sorts_like_stable_sort(keys, 3);
+}
+
+TEST(test_radix_sort, handles_tiny_inputs) {
+    expect_sorts_like_stable_sort(std::vector<std::uint32_t>{}, 2);
+    expect_sorts_like_stable_sort(std::vector<std::uint32_t>{42}, 2);
+    expect_sorts_like_stable_sort(std::vector<std::uint32_t>{7, 7, 7, 1}, 8);
+}
@@ -0,0 +1,212 @@
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <vector>
+
+#include "random.hpp"
+#include "simd_random.hpp"
+
+TEST(test_random, philox_known_answers) {
+    // Known-answer vectors from the Random123 distribution.
+    const auto zero = render::philox4x32({0U, 0U, 0U, 0U}, {0U, 0U});
+    EXPECT_EQ(zero[0], 0x6627e8d5U);
+    EXPECT_EQ(zero[1], 0xe169c58dU);
+    EXPECT_EQ(zero[2], 0xbc57ac4cU);
+    EXPECT_EQ(zero[3], 0x9b00dbd8U);
+
+    const auto pi = render::philox4x32({0x243f6a88U, 0x85a308d3U, 0x13198a2eU, 0x03707344U}, {0xa4093822U, 0x299f31d0U});
+    EXPECT_EQ(pi[0], 0xd16cfe09U);
+    EXPECT_EQ(pi[1], 0x94fdccebU);
+    EXPECT_EQ(pi[2], 0x5001e420U);
+    EXPECT_EQ(pi[3], 0x24126ea1U);
+}
+
+TEST(test_random, unit_double_range) {
+    EXPECT_DOUBLE_EQ(render::to_unit_double(0U, 0U), 0.0);
+    EXPECT_LT(render::to_unit_double(0xffffffffU, 0xffffffffU), 1.0);
+}
+
+TEST(test_random, stream_is_addressable) {
+    render::random_stream a{7U, 12345U, 3U, render::random_domain::material};
+    a.set_bounce(2);
+    const double first = a.uniform();
+    const double second = a.uniform();
+    const double third = a.uniform();
+
+    // A fresh stream positioned at the same bounce replays the same values.
+    render::random_stream b{7U, 12345U, 3U, render::random_domain::material};
+    b.set_bounce(5);
+    (void)b.uniform();
+    b.set_bounce(2);
+    EXPECT_EQ(b.uniform(), first);
+    EXPECT_EQ(b.uniform(), second);
+    EXPECT_EQ(b.uniform(), third);
+    EXPECT_NE(first, second);
+}
+
+TEST(test_random, streams_are_independent) {
+    render::random_stream camera{0U, 99U, 0U, render::random_domain::camera};
+    render::random_stream material{0U, 99U, 0U, render::random_domain::material};
+    render::random_stream other_pixel{0U, 100U, 0U, render::random_domain::camera};
+    render::random_stream other_sample{0U, 99U, 1U, render::random_domain::camera};
+    render::random_stream other_seed{1U, 99U, 0U, render::random_domain::camera};
+
+    const double reference = camera.uniform();
+    EXPECT_NE(material.uniform(), reference);
+    EXPECT_NE(other_pixel.uniform(), reference);
+    EXPECT_NE(other_sample.uniform(), reference);
+    EXPECT_NE(other_seed.uniform(), reference);
+}
+
+TEST(test_random, uniform_mean) {
+    double sum = 0.0;
+    const int count = 100000;
+    for (int s = 0; s < count; ++s) {
+        render::random_stream rng{1U, 0U, static_cast<std::uint32_t>(s), render::random_domain::material};
+        const double value = rng.uniform(-1.0, 1.0);
+        EXPECT_GE(value, -1.0);
+        EXPECT_LT(value, 1.0);
+        sum += value;
+    }
+    EXPECT_NEAR(sum / count, 0.0, 0.01);
+}
+
+TEST(test_random, draws_past_block_and_backwards_jumps) {
+    render::random_stream a{3U, 42U, 1U, render::random_domain::material};
+    std::vector<double> bounce1;
+    a.set_bounce(0);
+    (void)a.uniform();
+    a.set_bounce(1);
+    for (std::uint32_t d = 0; d < render::random_stream::dimensions_per_bounce + 4; ++d) {
+        bounce1.push_back(a.uniform());
+    }
+
+    // Revisiting an earlier bounce replays the same values.
+    a.set_bounce(3);
+    (void)a.uniform();
+    a.set_bounce(1);
+    for (double expected : bounce1) {
+        EXPECT_EQ(a.uniform(), expected);
+    }
+
+    // A stream that skips bounce 0 entirely sees the same bounce 1.
+    render::random_stream b{3U, 42U, 1U, render::random_domain::material};
+    b.set_bounce(1);
+    for (double expected : bounce1) {
+        EXPECT_EQ(b.uniform(), expected);
+    }
+}
+
+TEST(test_random, pattern_samplers_stratify_pairs) {
+    // 16 samples of either pattern put one point of every dimension pair in
+    // each cell of a 4 x 4 grid, and the stratified one also puts every x in
+    // its own 1/16 column and every y in its own 1/16 row.
+    for (const auto sampler : {render::sampler_type::stratified, render::sampler_type::sobol}) {
+        const render::sample_pattern pattern{sampler, 16U};
+        for (std::uint32_t bounce = 0; bounce < 3; ++bounce) {
+            std::vector<int> cells(16, 0);
+            std::vector<int> columns(16, 0);
+            std::vector<int> rows(16, 0);
+            for (std::uint32_t s = 0; s < 16; ++s) {
+                render::random_stream rng{5U, 777U, s, render::random_domain::material, pattern};
+                rng.set_bounce(bounce);
+                (void)rng.uniform();
+                (void)rng.uniform();
+                const double x = rng.uniform();
+                const double y = rng.uniform();
+                ASSERT_GE(x, 0.0);
+                ASSERT_LT(x, 1.0);
+                ASSERT_GE(y, 0.0);
+                ASSERT_LT(y, 1.0);
+                ++cells[static_cast<std::size_t>(x * 4.0) * 4 + static_cast<std::size_t>(y * 4.0)];
+                ++columns[static_cast<std::size_t>(x * 16.0)];
+                ++rows[static_cast<std::size_t>(y * 16.0)];
+            }
+            for (const int count : cells) {
+                EXPECT_EQ(count, 1);
+            }
+            if (sampler == render::sampler_type::stratified) {
+                for (const int count : columns) {
+                    EXPECT_EQ(count, 1);
+                }
+                for (const int count : rows) {
+                    EXPECT_EQ(count, 1);
+                }
+            }
+        }
+    }
+}
+
+TEST(test_random, pattern_samplers_are_addressable_and_unbiased) {
+    const render::sample_pattern pattern{render::sampler_type::sobol, 1U};
+    render::random_stream a{2U, 9U, 4U, render::random_domain::camera, pattern};
+    const double first = a.uniform();
+    render::random_stream b{2U, 9U, 4U, render::random_domain::camera, pattern};
+    b.set_bounce(3);
+    (void)b.uniform();
+    b.set_bounce(0);
+    EXPECT_EQ(b.uniform(), first);
+    EXPECT_EQ(a.get_sampler(), render::sampler_type::sobol);
+
+    // Every pixel scrambles its own pattern, so a sample's first draw
+    // averages to 1/2 over pixels.
+    for (const auto sampler : {render::sampler_type::stratified, render::sampler_type::sobol}) {
+        double sum = 0.0;
+        const int count = 20000;
+        for (int pixel = 0; pixel < count; ++pixel) {
+            render::random_stream rng{1U, static_cast<std::uint64_t>(pixel), 3U, render::random_domain::material, {sampler, 8U}};
+            sum += rng.uniform();
+        }
+        EXPECT_NEAR(sum / count, 0.5, 0.01);
+    }
+}
+
+TEST(test_simd_random, bulk_fill_ranges) {
+    render::xoshiro256x4 gen{1234U};
+    std::vector<double> doubles(1001);
+    std::vector<float> floats(1001);
+    gen.fill_uniform(doubles.data(), doubles.size());
+    gen.fill_uniform(floats.data(), floats.size());
+
+    double sum = 0.0;
+    for (double d : doubles) {
+        EXPECT_GE(d, 0.0);
+        EXPECT_LT(d, 1.0);
+        sum += d;
+    }
+    EXPECT_NEAR(sum / static_cast<double>(doubles.size()), 0.5, 0.05);
+    for (float f : floats) {
+        EXPECT_GE(f, 0.0F);
+        EXPECT_LT(f, 1.0F);
+    }
+}
+
+TEST(test_simd_random, matches_scalar_xoshiro) {
+    // Lane 0 of the interleaved output must follow the reference xoshiro256+ recurrence.
+    render::xoshiro256x4 gen;
+    gen.reseed(99U, 7U);
+    std::uint64_t state = 99U ^ (7U * 0xD1B54A32D192ED03ULL);
+    std::uint64_t s[4];
+    for (auto& word : s) {
+        word = render::splitmix64(state);
+    }
+
+    std::vector<std::uint64_t> out(40);
+    gen.fill(out.data(), out.size());
+    for (size_t i = 0; i < out.size(); i += 4) {
+        EXPECT_EQ(out[i], s[0] + s[3]);
+        const std::uint64_t t = s[1] << 17;
+        s[2] ^= s[0];
+        s[3] ^= s[1];
+        s[1] ^= s[2];
+        s[0] ^= s[3];
+        s[2] ^= t;
+        s[3] = (s[3] << 45) | (s[3] >> 19);
+    }
+}
+
+TEST(test_simd_random, bit_trick_conversion) {
+    EXPECT_EQ(render::bits_to_unit_double(0U), 0.0);
+    EXPECT_LT(render::bits_to_unit_double(~0ULL), 1.0);
+    EXPECT_EQ(render::bits_to_unit_float(0U), 0.0F);
+    EXPECT_LT(render::bits_to_unit_float(~0U), 1.0F);
+}
@@ -0,0 +1,189 @@
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+
+#include "config.hpp"
+#include "random.hpp"
+#include "renderer_utils.hpp"
+#include "vector.hpp"
+
+TEST(test_renderer_utils, continue_path_without_roulette) {
+    render::render_config config;
+    render::random_stream rng{1U, 0U, 0U, render::random_domain::material};
+
+    render::vector throughput{0.01, 0.02, 0.03};
+    EXPECT_TRUE(render::continue_path(config, 40, throughput, rng));
+    EXPECT_DOUBLE_EQ(throughput.get_z(), 0.03);
+    EXPECT_EQ(rng.get_dimension(), 0U);
+
+    render::vector black{0.0, 0.0, 0.0};
+    EXPECT_FALSE(render::continue_path(config, 0, black, rng));
+}
+
+TEST(test_renderer_utils, russian_roulette_is_unbiased) {
+    render::render_config config;
+    config.russian_roulette_depth = 3;
+
+    // Before the roulette depth paths always continue unchanged.
+    render::random_stream early{1U, 0U, 0U, render::random_domain::material};
+    render::vector dim{0.25, 0.1, 0.2};
+    EXPECT_TRUE(render::continue_path(config, 1, dim, early));
+    EXPECT_DOUBLE_EQ(dim.get_x(), 0.25);
+
+    int survivors = 0;
+    double total = 0.0;
+    const int paths = 20000;
+    for (int i = 0; i < paths; ++i) {
+        render::random_stream rng{1U, static_cast<std::uint64_t>(i), 0U, render::random_domain::material};
+        render::vector throughput{0.25, 0.1, 0.2};
+        if (render::continue_path(config, 2, throughput, rng)) {
+            ++survivors;
+            EXPECT_DOUBLE_EQ(throughput.get_x(), 1.0);
+            total += throughput.get_y();
+        }
+    }
+    EXPECT_NEAR(static_cast<double>(survivors) / paths, 0.25, 0.02);
+    EXPECT_NEAR(total / paths, 0.1, 0.01);
+}
+
+namespace {
+
+    std::string read_file(const std::string& filename) {
+        std::ifstream file(filename, std::ios::binary);
+        return std::string{std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()};
+    }
+
+    // 2x2 image: bottom row dark red and blue, top row white and black.
+    render::framebuffer make_image() {
+        render::framebuffer image{2, 2};
+        image.set_pixel(0, 0, render::vector{0.25, 0.0, 0.0});
+        image.set_pixel(1, 0, render::vector{0.0, 0.0, 1.0});
+        image.set_pixel(0, 1, render::vector{2.0, 1.0, 1.0});
+        image.set_pixel(1, 1, render::vector{0.0, 0.0, 0.0});
+        return image;
+    }
+
+}
+
+TEST(test_renderer_utils, framebuffer_is_row_major_from_the_bottom) {
+    const render::framebuffer image = make_image();
+    const auto components = image.get_components();
+    ASSERT_EQ(components.size(), 12U);
+    EXPECT_EQ(reinterpret_cast<std::uintptr_t>(components.data()) % render::cache_line_size, 0U);
+    EXPECT_FLOAT_EQ(components[0], 0.25F);
+    EXPECT_FLOAT_EQ(components[5], 1.0F);
+    EXPECT_FLOAT_EQ(components[6], 2.0F);
+    EXPECT_EQ(image.get_row(1).data(), components.data() + 6);
+    EXPECT_DOUBLE_EQ(image.get_pixel(1, 0).get_z(), 1.0);
+}
+
+TEST(test_renderer_utils, writes_ppm_top_row_first) {
+    const std::string test_file = "test_renderer_utils.ppm";
+    const render::framebuffer image = make_image();
+    const int dark_red = render::color_to_int(render::gamma_correct(render::vector{0.25, 0.0, 0.0}, 2.0).get_x());
+
+    render::write_ppm(test_file, image, 2.0);
+    const std::string binary = read_file(test_file);
+    const std::string expected_pixels{'\xff', '\xff', '\xff', 0, 0, 0, static_cast<char>(dark_red), 0, 0, 0, 0, '\xff'};
+    EXPECT_EQ(binary, "P6\n2 2\n255\n" + expected_pixels);
+
+    render::write_ppm_ascii(test_file, image, 2.0);
+    EXPECT_EQ(read_file(test_file), "P3\n2 2\n255\n255 255 255\n0 0 0\n" + std::to_string(dark_red) + " 0 0\n0 0 255\n");
+
+    std::remove(test_file.c_str());
+}
+
+TEST(test_renderer_utils, writes_linear_pfm) {
+    const std::string test_file = "test_renderer_utils.pfm";
+    const render::framebuffer image = make_image();
+
+    render::write_pfm(test_file, image);
+    const std::string pfm = read_file(test_file);
+    const std::string header = "PF\n2 2\n-1.0\n";
+    ASSERT_EQ(pfm.size(), header.size() + 12 * sizeof(float));
+    EXPECT_EQ(pfm.substr(0, header.size()), header);
+    EXPECT_EQ(std::memcmp(pfm.data() + header.size(), image.get_components().data(), 12 * sizeof(float)), 0);
+
+    std::remove(test_file.c_str());
+}
+
+TEST(test_renderer_utils, output_format_follows_config_then_extension) {
+    render::render_config config;
+    EXPECT_EQ(render::output_format_for(config, "out.ppm"), render::image_format::p3);
+    EXPECT_EQ(render::output_format_for(config, "out.pfm"), render::image_format::pfm);
+    config.output_format = render::image_format::p6;
+    EXPECT_EQ(render::output_format_for(config, "out.ppm"), render::image_format::p6);
+    config.output_format = render::image_format::p3;
+    EXPECT_EQ(render::output_format_for(config, "out.pfm"), render::image_format::p3);
+}
+
+TEST(test_renderer_utils, pixel_estimate_tracks_luminance_variance) {
+    render::pixel_estimate estimate;
+    const double samples[] = {0.2, 0.9, 0.4, 0.7};
+    for (const double y : samples) {
+        estimate.add(render::vector{y, y, y});
+    }
+    EXPECT_EQ(estimate.count, 4);
+    EXPECT_NEAR(estimate.mean().get_y(), 0.55, 1e-12);
+    EXPECT_NEAR(estimate.luminance_mean, 0.55, 1e-12);
+    // Sum of squared deviations from 0.55.
+    EXPECT_NEAR(estimate.luminance_m2, 0.35 * 0.35 + 0.35 * 0.35 + 0.15 * 0.15 + 0.15 * 0.15, 1e-12);
+}
+
+TEST(test_renderer_utils, adaptive_sampling_stops_converged_pixels) {
+    render::render_config config;
+    config.samples_per_pixel = 64;
+    config.adaptive_min_samples = 4;
+
+    // Without a threshold every pixel takes samples_per_pixel samples.
+    render::pixel_estimate constant;
+    while (constant.needs_sample(config)) {
+        constant.add(render::vector{0.5, 0.5, 0.5});
+    }
+    EXPECT_EQ(constant.count, 64);
+
+    config.adaptive_threshold = 0.05;
+    render::pixel_estimate flat;
+    while (flat.needs_sample(config)) {
+        flat.add(render::vector{0.5, 0.5, 0.5});
+    }
+    EXPECT_EQ(flat.count, 4);
+
+    // Alternating 0 and 1 never gets within 5% of its mean by 64 samples.
+    render::pixel_estimate noisy;
+    while (noisy.needs_sample(config)) {
+        const double y = noisy.count % 2 == 0 ? 0.0 : 1.0;
+        noisy.add(render::vector{y, y, y});
+    }
+    EXPECT_EQ(noisy.count, 64);
+}
+
+TEST(test_renderer_utils, writes_sample_counts_as_pgm) {
+    const std::string test_file = "test_renderer_utils.pgm";
+    render::sample_count_image narrow{2, 1, 100};
+    narrow.set_count(0, 0, 7);
+    narrow.set_count(1, 0, 100);
+    narrow.write(test_file);
+    EXPECT_EQ(read_file(test_file), std::string{"P5\n2 1\n100\n"} + '\x07' + 'd');
+
+    render::sample_count_image wide{1, 2, 1000};
+    wide.set_count(0, 0, 300);
+    wide.set_count(0, 1, 1000);
+    wide.write(test_file);
+    EXPECT_EQ(read_file(test_file), std::string{"P5\n1 2\n1000\n"} + '\x03' + '\xe8' + '\x01' + ',');
+
+    std::remove(test_file.c_str());
+}
+
+TEST(test_renderer_utils, sphere_direction_covers_the_sphere) {
+    EXPECT_NEAR(render::sphere_direction(0.0, 0.3).get_z(), 1.0, 1e-12);
+    EXPECT_NEAR(render::sphere_direction(0.5, 0.0).get_x(), 1.0, 1e-12);
+    EXPECT_NEAR(render::sphere_direction(0.5, 0.25).get_y(), 1.0, 1e-12);
+    for (const double u : {0.1, 0.37, 0.9}) {
+        EXPECT_NEAR(render::sphere_direction(u, 0.6).magnitude_squared(), 1.0, 1e-12);
+    }
+}
@@ -1,8 +1,15 @@
 #include <gtest/gtest.h>
 #include <fstream>
 #include <cstdio>
+#include <iterator>
+#include <string>
+#include <memory>
+#include <vector>
 
+#include "cylinder.hpp"
+#include "material.hpp"
 #include "scene.hpp"
+#include "sphere.hpp"
 
 TEST(test_scene_parser, simple_scene) {
     // Create a temporary scene file
@@ -66,14 +73,63 @@ TEST(test_scene_parser, unknown_entity) {
     std::remove(test_file.c_str());
 }
 
+TEST(test_scene_parser, chunked_parse_matches_single_thread) {
+    // Large enough to be split into chunks, with a forward material reference
+    // in the second half that only a line-by-line read would reject first.
+    const std::string test_file = "test_scene_chunks.txt";
+    {
+        std::ofstream file(test_file);
+        file << "matte: mat1 0.5 0.6 0.7\n\n";
+        for (int i = 0; i < 40000; ++i) {
+            file << "sphere: " << i << " 0 -1.5e1 0.25 mat1\r\n";
+            file << "cylinder: 0 " << i << " 0 1.0 0 2 0 mat1\n";
+        }
+        file << "metal: mat2 0.1 0.2 0.3 0.0\n";
+        file << "sphere: 0 0 0 1.0 mat2";
+    }
+
+    const auto single = render::scene_parser::parse(test_file, 1);
+    const auto chunked = render::scene_parser::parse(test_file, 4);
+    ASSERT_EQ(single.get_spheres().size(), 40001U);
+    ASSERT_EQ(chunked.get_spheres().size(), single.get_spheres().size());
+    ASSERT_EQ(chunked.get_cylinders().size(), single.get_cylinders().size());
+    for (size_t i = 0; i < single.get_spheres().size(); ++i) {
+        EXPECT_EQ(chunked.get_spheres()[i]->get_center().get_x(), single.get_spheres()[i]->get_center().get_x());
+        EXPECT_EQ(chunked.get_spheres()[i]->get_material(), single.get_spheres()[i]->get_material());
+    }
+    EXPECT_EQ(chunked.get_spheres().back()->get_material(), chunked.get_material("mat2"));
+
+    {
+        std::ofstream file(test_file, std::ios::app);
+        file << "\nsphere: 0 0 0 -1.0 mat1\n";
+    }
+    {
+        std::ifstream in(test_file);
+        std::string contents((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        contents.insert(contents.find("sphere: 20000 "), "cylinder: 0 0 0 1.0 0 1 0 mat2\n");
+        std::ofstream(test_file) << contents;
+    }
+    for (const int threads : {1, 4}) {
+        try {
+            (void)render::scene_parser::parse(test_file, threads);
+            ADD_FAILURE() << "no error with " << threads << " threads";
+        }
+        catch (const std::runtime_error& e) {
+            EXPECT_STREQ(e.what(), "Error: Material not found: [mat2]\nLine: \"cylinder: 0 0 0 1.0 0 1 0 mat2\"");
+        }
+    }
+
+    std::remove(test_file.c_str());
+}
+
 TEST(test_scene, add_materials_and_objects) {
     render::scene scene;
     
-    auto mat1 = std::make_shared<render::matte_material>("mat1", 0.5, 0.5, 0.5);
-    scene.add_material(mat1);
+    const render::material_id mat1 = scene.add_material(render::matte_material{"mat1", 0.5, 0.5, 0.5});
     
-    EXPECT_NE(scene.get_material("mat1"), nullptr);
-    EXPECT_EQ(scene.get_material("nonexistent"), nullptr);
+    EXPECT_EQ(scene.get_material("mat1"), mat1);
+    EXPECT_FALSE(scene.get_material("nonexistent").has_value());
+    EXPECT_THROW(scene.add_material(render::metal_material{"mat1", 0.5, 0.5, 0.5, 0.1}), std::runtime_error);
     
     auto sph = std::make_shared<render::sphere>(render::vector{0.0, 0.0, 0.0}, 1.0, mat1);
     scene.add_sphere(sph);
@@ -81,3 +137,76 @@ TEST(test_scene, add_materials_and_objects) {
     EXPECT_EQ(scene.get_spheres().size(), 1);
 }
 
+TEST(test_scene, reorder_groups_nearby_primitives) {
+    render::scene scene;
+    const render::material_id mat = scene.add_material(render::matte_material{"mat", 0.5, 0.5, 0.5});
+    for (const double x : {9.0, 0.0, 8.0, 1.0, 9.0}) {
+        scene.add_sphere(std::make_shared<render::sphere>(render::vector{x, 0.0, 0.0}, 0.5, mat));
+    }
+    scene.add_cylinder(std::make_shared<render::cylinder>(render::vector{9.0, 0.0, 0.0}, 0.5, render::vector{0.0, 1.0, 0.0}, mat));
+    scene.add_cylinder(std::make_shared<render::cylinder>(render::vector{0.0, 0.0, 0.0}, 0.5, render::vector{0.0, 1.0, 0.0}, mat));
+    const auto first = scene.get_spheres()[0];
+
+    scene.reorder(render::primitive_order::file);
+    EXPECT_EQ(scene.get_spheres()[0], first);
+
+    const auto sphere_xs = [&] {
+        std::vector<double> xs;
+        for (const auto& sph : scene.get_spheres()) {
+            xs.push_back(sph->get_center().get_x());
+        }
+        return xs;
+    };
+
+    // On one axis the Morton order is plain sorting.
+    scene.reorder(render::primitive_order::morton);
+    EXPECT_EQ(sphere_xs(), (std::vector<double>{0.0, 1.0, 8.0, 9.0, 9.0}));
+    EXPECT_EQ(scene.get_cylinders()[0]->get_center().get_x(), 0.0);
+    EXPECT_EQ(scene.get_spheres()[3], first);
+
+    // The Hilbert curve may run either way, but keeps both clusters together.
+    scene.reorder(render::primitive_order::hilbert);
+    const std::vector<double> xs = sphere_xs();
+    ASSERT_EQ(xs.size(), 5U);
+    const bool low_first = xs[0] < 2.0;
+    for (size_t i = 0; i < xs.size(); ++i) {
+        EXPECT_EQ(xs[i] < 2.0, low_first ? i < 2 : i >= 3) << i;
+    }
+}
+
+TEST(test_scene_parser, delivers_to_builder) {
+    // Records the calls a builder receives.
+    struct recording_builder : render::scene_builder {
+        std::vector<std::string> calls;
+
+        void reserve(std::size_t num_spheres, std::size_t num_cylinders) override {
+            calls.push_back("reserve " + std::to_string(num_spheres) + " " + std::to_string(num_cylinders));
+        }
+        render::material_id add_material(const render::material& mat) override {
+            calls.push_back("material " + mat.get_name());
+            return static_cast<render::material_id>(calls.size());
+        }
+        void add_sphere(const render::vector& center, double, render::material_id mat) override {
+            calls.push_back("sphere " + std::to_string(static_cast<int>(center.get_x())) + " " + std::to_string(mat));
+        }
+        void add_cylinder(const render::vector& center, double, const render::vector&, render::material_id mat) override {
+            calls.push_back("cylinder " + std::to_string(static_cast<int>(center.get_x())) + " " + std::to_string(mat));
+        }
+    };
+
+    const std::string test_file = "test_scene_builder.txt";
+    std::ofstream file(test_file);
+    file << "matte: mat1 0.5 0.6 0.7\n";
+    file << "sphere: 1 0 0 1.0 mat1\n";
+    file << "metal: mat2 0.5 0.6 0.7 0.1\n";
+    file << "cylinder: 2 0 0 1.0 0 1 0 mat2\n";
+    file << "sphere: 3 0 0 1.0 mat2\n";
+    file.close();
+
+    recording_builder builder;
+    render::scene_parser::parse(test_file, builder);
+    EXPECT_EQ(builder.calls, (std::vector<std::string>{
+        "reserve 2 1", "material mat1", "material mat2", "sphere 1 2", "sphere 3 3", "cylinder 2 3"}));
+
+    std::remove(test_file.c_str());
+}
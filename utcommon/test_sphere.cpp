@@ -5,7 +5,7 @@
 #include "sphere.hpp"
 
 TEST(test_sphere, creation) {
-    auto mat = std::make_shared<render::matte_material>("mat1", 0.5, 0.5, 0.5);
+    const render::material_id mat = 0;
     render::sphere sph{render::vector{0.0, 0.0, 0.0}, 1.0, mat};
     
     EXPECT_DOUBLE_EQ(sph.get_center().get_x(), 0.0);
@@ -15,13 +15,13 @@ TEST(test_sphere, creation) {
 }
 
 TEST(test_sphere, invalid_radius) {
-    auto mat = std::make_shared<render::matte_material>("mat1", 0.5, 0.5, 0.5);
+    const render::material_id mat = 0;
     EXPECT_THROW(render::sphere{render::vector{0.0, 0.0, 0.0}, -1.0, mat}, std::invalid_argument);
     EXPECT_THROW(render::sphere{render::vector{0.0, 0.0, 0.0}, 0.0, mat}, std::invalid_argument);
 }
 
 TEST(test_sphere, intersection_hit) {
-    auto mat = std::make_shared<render::matte_material>("mat1", 0.5, 0.5, 0.5);
+    const render::material_id mat = 0;
     render::sphere sph{render::vector{0.0, 0.0, 0.0}, 1.0, mat};
     
     render::ray r{render::vector{0.0, 0.0, 5.0}, render::vector{0.0, 0.0, -1.0}};
@@ -33,7 +33,7 @@ TEST(test_sphere, intersection_hit) {
 }
 
 TEST(test_sphere, intersection_miss) {
-    auto mat = std::make_shared<render::matte_material>("mat1", 0.5, 0.5, 0.5);
+    const render::material_id mat = 0;
     render::sphere sph{render::vector{0.0, 0.0, 0.0}, 1.0, mat};
     
     render::ray r{render::vector{0.0, 0.0, 5.0}, render::vector{1.0, 0.0, 0.0}};
@@ -42,3 +42,16 @@ TEST(test_sphere, intersection_miss) {
     EXPECT_FALSE(hit.has_value());
 }
 
+TEST(test_sphere, hit_distance_window) {
+    const render::material_id mat = 0;
+    render::sphere sph{render::vector{0.0, 0.0, 0.0}, 1.0, mat};
+    render::ray r{render::vector{0.0, 0.0, 5.0}, render::vector{0.0, 0.0, -1.0}};
+
+    EXPECT_DOUBLE_EQ(*sph.hit_distance(r, 0.0001, 100.0), 4.0);
+    EXPECT_DOUBLE_EQ(*sph.hit_distance(r, 4.5, 100.0), 6.0);
+    EXPECT_FALSE(sph.hit_distance(r, 0.0001, 4.0).has_value());
+
+    const auto hit = sph.surface_at(r, 4.0);
+    EXPECT_DOUBLE_EQ(hit.point.get_z(), 1.0);
+    EXPECT_DOUBLE_EQ(hit.normal.get_z(), 1.0);
+}
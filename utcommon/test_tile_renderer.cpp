@@ -0,0 +1,79 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <stdexcept>
+#include <vector>
+
+#include "config.hpp"
+#include "thread_pool.hpp"
+#include "tile_renderer.hpp"
+
+TEST(test_thread_pool, runs_task_on_every_worker) {
+    render::thread_pool pool{4};
+    std::vector<int> visits(4, 0);
+    pool.run([&](int worker) { visits[static_cast<size_t>(worker)]++; });
+    pool.run([&](int worker) { visits[static_cast<size_t>(worker)]++; });
+
+    for (int count : visits) {
+        EXPECT_EQ(count, 2);
+    }
+}
+
+TEST(test_thread_pool, propagates_exceptions) {
+    render::thread_pool pool{3};
+    EXPECT_THROW(pool.run([](int worker) {
+        if (worker == 2) {
+            throw std::runtime_error("worker failed");
+        }
+    }), std::runtime_error);
+}
+
+TEST(test_tiles, cover_image_exactly) {
+    const auto tiles = render::make_tiles(37, 20, 16);
+    ASSERT_EQ(tiles.size(), 6);
+
+    int covered = 0;
+    for (size_t i = 0; i < tiles.size(); ++i) {
+        EXPECT_EQ(tiles[i].index, static_cast<int>(i));
+        covered += (tiles[i].x_end - tiles[i].x_begin) * (tiles[i].y_end - tiles[i].y_begin);
+    }
+    EXPECT_EQ(covered, 37 * 20);
+    EXPECT_EQ(tiles.back().x_end, 37);
+    EXPECT_EQ(tiles.back().y_end, 20);
+}
+
+TEST(test_tiles, queue_steals_remaining_tiles) {
+    const render::tile_grid grid{64, 64, 16};
+    render::tile_queue queue{grid, 4};
+
+    // A single worker drains its own deque first and then steals the rest.
+    std::vector<bool> seen(grid.size(), false);
+    while (const auto t = queue.pop(0)) {
+        EXPECT_FALSE(seen[static_cast<size_t>(t->index)]);
+        seen[static_cast<size_t>(t->index)] = true;
+    }
+    for (bool s : seen) {
+        EXPECT_TRUE(s);
+    }
+}
+
+TEST(test_tiles, render_tiles_shades_every_pixel_once) {
+    render::render_config config;
+    config.threads = 4;
+    config.tile_size = 7;
+
+    const int width = 50;
+    const int height = 31;
+    std::vector<std::atomic<int>> hits(static_cast<size_t>(width * height));
+
+    render::render_tiles(config, width, height, [&](const render::tile& t) {
+        for (int j = t.y_begin; j < t.y_end; ++j) {
+            for (int i = t.x_begin; i < t.x_end; ++i) {
+                hits[static_cast<size_t>(j * width + i)]++;
+            }
+        }
+    });
+
+    for (const auto& h : hits) {
+        EXPECT_EQ(h.load(), 1);
+    }
+}
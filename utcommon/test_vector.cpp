@@ -124,4 +124,33 @@ TEST(test_vector, compound_assignment_division) {
     EXPECT_DOUBLE_EQ(v.get_x(), 1.0);
     EXPECT_DOUBLE_EQ(v.get_y(), 2.0);
     EXPECT_DOUBLE_EQ(v.get_z(), 3.0);
-}
\ No newline at end of file
+}
+
+TEST(test_vector, component_wise_multiply) {
+    render::vector v1{1.0, 2.0, 3.0};
+    render::vector v2{4.0, 5.0, 6.0};
+    render::vector result = v1.multiply(v2);
+    EXPECT_DOUBLE_EQ(result.get_x(), 4.0);
+    EXPECT_DOUBLE_EQ(result.get_y(), 10.0);
+    EXPECT_DOUBLE_EQ(result.get_z(), 18.0);
+}
+
+TEST(test_vector, add_scaled_matches_operators) {
+    render::vector v1{0.1, 0.2, 0.3};
+    render::vector v2{0.7, -1.3, 2.9};
+    render::vector fused = v1.add_scaled(v2, 0.37);
+    render::vector separate = v1 + v2 * 0.37;
+    EXPECT_EQ(fused.get_x(), separate.get_x());
+    EXPECT_EQ(fused.get_y(), separate.get_y());
+    EXPECT_EQ(fused.get_z(), separate.get_z());
+}
+
+TEST(test_vector, constant_expressions) {
+    constexpr render::vector v1{1.0, 2.0, 3.0};
+    constexpr render::vector v2{4.0, 5.0, 6.0};
+    static_assert(v1.dot(v2) == 32.0);
+    static_assert((v1 + v2).get_y() == 7.0);
+    static_assert(v1.cross(v2).get_z() == -3.0);
+    static_assert((-v1).get_x() == -1.0);
+    EXPECT_EQ(v1.multiply(v2).get_z(), 18.0);
+}
@@ -0,0 +1,100 @@
+#include <gtest/gtest.h>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <vector>
+
+#include "baked_scene.hpp"
+#include "bvh.hpp"
+#include "camera.hpp"
+#include "config.hpp"
+#include "material.hpp"
+#include "random.hpp"
+#include "renderer.hpp"
+#include "renderer_utils.hpp"
+#include "scene.hpp"
+#include "sphere.hpp"
+#include "tile_renderer.hpp"
+#include "wavefront_renderer_soa.hpp"
+
+namespace {
+
+    // A matte ground and a matte, a fuzzy metal and a glass sphere, so every
+    // per-material queue of the wavefront renderer is used.
+    render::scene make_scene() {
+        render::scene sc;
+        const render::material_id ground = sc.add_material(render::matte_material{"ground", 0.5, 0.5, 0.5});
+        const render::material_id matte = sc.add_material(render::matte_material{"matte", 0.7, 0.3, 0.1});
+        const render::material_id metal = sc.add_material(render::metal_material{"metal", 0.8, 0.8, 0.9, 0.3});
+        const render::material_id glass = sc.add_material(render::refractive_material{"glass", 1.5});
+        sc.add_sphere(std::make_shared<render::sphere>(render::vector{0.0, -1000.0, 0.0}, 1000.0, ground));
+        sc.add_sphere(std::make_shared<render::sphere>(render::vector{-4.0, 1.0, 0.0}, 1.0, matte));
+        sc.add_sphere(std::make_shared<render::sphere>(render::vector{0.0, 1.0, 0.0}, 1.0, glass));
+        sc.add_sphere(std::make_shared<render::sphere>(render::vector{4.0, 1.0, 0.0}, 1.0, metal));
+        return sc;
+    }
+
+    // The estimates of the recursive engine for the pixels of the tile,
+    // row-major within the tile, with the streams of render-soa's tile loop.
+    std::vector<render::pixel_estimate> render_recursive(const render::render_config& config, const render::camera& cam, const render::renderer& tracer,
+                                                         const render::tile& t) {
+        const int width = cam.get_image_width();
+        const int height = cam.get_image_height();
+        const render::sample_pattern pattern = render::sample_pattern_for(config);
+        std::vector<render::pixel_estimate> pixels;
+        for (int j = t.y_begin; j < t.y_end; ++j) {
+            for (int i = t.x_begin; i < t.x_end; ++i) {
+                const auto pixel = static_cast<std::uint64_t>(j) * static_cast<std::uint64_t>(width) + static_cast<std::uint64_t>(i);
+                render::pixel_estimate& estimate = pixels.emplace_back();
+                while (estimate.needs_sample(config)) {
+                    const auto s = static_cast<std::uint32_t>(estimate.count);
+                    render::random_stream ray_rng{config.ray_rng_seed, pixel, s, render::random_domain::camera, pattern};
+                    render::random_stream material_rng{config.material_rng_seed, pixel, s, render::random_domain::material, pattern};
+                    const double u = (static_cast<double>(i) + ray_rng.uniform()) / static_cast<double>(width);
+                    const double v = (static_cast<double>(j) + ray_rng.uniform()) / static_cast<double>(height);
+                    estimate.add(tracer.trace_ray(cam.get_ray(u, v), 0, material_rng));
+                }
+            }
+        }
+        return pixels;
+    }
+
+}
+
+TEST(test_wavefront_renderer, matches_recursive_engine_over_several_batches) {
+    render::render_config config;
+    config.image_width = 48;
+    config.camera_position = render::vector{0.0, 2.0, 10.0};
+    config.camera_target = render::vector{0.0, 1.0, 0.0};
+    config.field_of_view = 50.0;
+    config.max_depth = 8;
+    config.samples_per_pixel = 5;
+    const render::camera cam{config};
+
+    const render::baked_scene baked{make_scene()};
+    const std::optional<render::bvh> accel = render::build_acceleration(config, baked.get_primitive_bounds());
+    const render::renderer tracer{config, baked, accel};
+    const render::basic_wavefront_renderer<render::aos_layout<double>> wavefront{config, cam, tracer};
+
+    // 16x12 pixels take two samples each per batch, so the five samples need
+    // three rounds, the last of them partial.
+    const render::tile t{0, 16, 32, 8, 20};
+    const auto num_pixels = static_cast<std::size_t>((t.x_end - t.x_begin) * (t.y_end - t.y_begin));
+    ASSERT_LE(t.y_end, cam.get_image_height());
+    ASSERT_EQ(render::basic_wavefront_renderer<render::aos_layout<double>>::max_paths / num_pixels, 2U);
+
+    std::vector<render::pixel_estimate> estimates;
+    wavefront.render_tile(t, estimates);
+    const std::vector<render::pixel_estimate> expected = render_recursive(config, cam, tracer, t);
+
+    ASSERT_EQ(estimates.size(), expected.size());
+    for (std::size_t k = 0; k < expected.size(); ++k) {
+        EXPECT_EQ(estimates[k].count, config.samples_per_pixel);
+        const render::vector color = estimates[k].mean();
+        const render::vector reference = expected[k].mean();
+        EXPECT_NEAR(color.get_x(), reference.get_x(), 1e-9) << "pixel " << k;
+        EXPECT_NEAR(color.get_y(), reference.get_y(), 1e-9) << "pixel " << k;
+        EXPECT_NEAR(color.get_z(), reference.get_z(), 1e-9) << "pixel " << k;
+    }
+}